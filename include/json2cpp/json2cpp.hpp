@@ -26,6 +26,7 @@ SOFTWARE.
 #define CONSTEXPR_JSON_HPP_INCLUDED
 
 #include <array>
+#include <bit>
 #include <concepts>
 #include <cstddef>
 #include <cstdint>
@@ -36,6 +37,14 @@ SOFTWARE.
 #include <type_traits>
 #include <utility>
 
+#ifdef JSON2CPP_RECORD_ACCESS
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#endif
+
 #define JSON2CPP_DETAIL_INLINE inline
 
 namespace json2cpp {
@@ -102,6 +111,40 @@ namespace detail {
     constexpr operator std::basic_string_view<CharType>() const noexcept { return value; }
   };
 
+  // Key filters are blocked Bloom filters over the key hashes of large objects: each key sets key_filter_probes bits of
+  // one 64-bit word, so a lookup reads one word and rejects most missing keys before any scan or probe. The number of
+  // words follows from the object size and the bits from the key hash, so the generator and the runtime agree.
+  inline constexpr size_t key_filter_bits_per_key = 10;
+  inline constexpr size_t key_filter_probes = 4;
+
+  struct key_filter_probe_t
+  {
+    size_t word;
+    uint64_t bits;
+  };
+
+  constexpr size_t key_filter_words(size_t size) noexcept
+  {
+    return std::bit_ceil((size * key_filter_bits_per_key + 63u) / 64u);
+  }
+
+  constexpr key_filter_probe_t key_filter_probe(uint32_t hash, size_t size) noexcept
+  {
+    uint64_t mixed = hash + 0x9E3779B97F4A7C15ull;
+    mixed = (mixed ^ (mixed >> 30u)) * 0xBF58476D1CE4E5B9ull;
+    mixed = (mixed ^ (mixed >> 27u)) * 0x94D049BB133111EBull;
+    mixed ^= mixed >> 31u;
+    uint64_t bits = 0;
+    for (size_t i = 0; i < key_filter_probes; ++i) bits |= uint64_t{ 1 } << ((mixed >> (6u * i)) & 63u);
+    return { static_cast<uint32_t>(mixed >> 32u) & (key_filter_words(size) - 1u), bits };
+  }
+
+  constexpr bool key_filter_may_contain(const uint64_t *words, size_t size, uint32_t hash) noexcept
+  {
+    const auto probe = key_filter_probe(hash, size);
+    return (words[probe.word] & probe.bits) == probe.bits;
+  }
+
   template<typename T, typename CharType>
   concept char_array_like =
     std::is_array_v<std::remove_reference_t<T>>
@@ -114,6 +157,88 @@ namespace detail {
                              { value.size() } -> std::convertible_to<size_t>;
                            };
 
+  // Decoder for the LZ-style sequences the generator emits for compressed strings: a token byte holding the literal
+  // count (high nibble) and match length minus 4 (low nibble), 255-continued extended lengths, the literal units
+  // (little endian), then a 16-bit little endian back-reference offset. The stream ends once `length` units are out;
+  // the end of the consumed input is returned, or nullptr when the output rejects a unit.
+  template<typename CharType, typename Output>
+  constexpr const uint8_t *lz_decode(const uint8_t *in, size_t length, Output &&output) noexcept
+  {
+    const auto read_length = [&](size_t value) {
+      if (value != 15) return value;
+      uint8_t extra = 0;
+      do {
+        extra = *in++;
+        value += extra;
+      } while (extra == 255);
+      return value;
+    };
+
+    size_t pos = 0;
+    while (pos < length) {
+      const auto token = *in++;
+      for (auto literals = read_length(static_cast<size_t>(token >> 4)); literals != 0; --literals, ++pos) {
+        uint32_t unit = 0;
+        for (size_t i = 0; i < sizeof(CharType); ++i) unit |= static_cast<uint32_t>(*in++) << (8 * i);
+        if (!output.literal(pos, static_cast<CharType>(unit))) return nullptr;
+      }
+      if (pos >= length) break;
+
+      const auto offset = static_cast<size_t>(in[0]) | (static_cast<size_t>(in[1]) << 8);
+      in += 2;
+      for (auto match = read_length(static_cast<size_t>(token & 15u)) + 4; match != 0; --match, ++pos) {
+        if (!output.copy(pos, pos - offset)) return nullptr;
+      }
+    }
+    return in;
+  }
+
+#ifdef JSON2CPP_RECORD_ACCESS
+  // Access counts per node storage address; entry npos counts every lookup or iteration of the node itself.
+  struct access_key_t
+  {
+    const void *node = nullptr;
+    size_t entry = 0;
+
+    bool operator==(const access_key_t &) const = default;
+  };
+
+  struct access_key_hash
+  {
+    size_t operator()(const access_key_t &key) const noexcept
+    {
+      return std::hash<const void *>{}(key.node) ^ (key.entry * size_t{ 0x9e3779b97f4a7c15ull });
+    }
+  };
+
+  struct access_log_t
+  {
+    std::mutex mutex;
+    std::unordered_map<access_key_t, uint64_t, access_key_hash> counts;
+  };
+
+  inline access_log_t &access_log()
+  {
+    static access_log_t log;
+    return log;
+  }
+
+  inline thread_local bool access_recording_paused = false;
+
+  inline void record_access(const void *node, size_t entry) noexcept
+  {
+    if (node == nullptr || access_recording_paused) return;
+    auto &log = access_log();
+    std::lock_guard lock(log.mutex);
+    try {
+      ++log.counts[{ node, static_cast<size_t>(-1) }];
+      if (entry != static_cast<size_t>(-1)) ++log.counts[{ node, entry }];
+    } catch (...) {
+      // Profiling is best effort; running out of memory here must not change program behavior.
+    }
+  }
+#endif
+
   template<typename CharType, typename T>
   constexpr std::basic_string_view<CharType> make_string_view(const T &value) noexcept
   {
@@ -139,6 +264,13 @@ template<typename CharType> struct basic_item_key_t;
 template<typename CharType> struct basic_item_view_t;
 template<typename CharType> struct basic_entry_view_t;
 
+template<typename CharType> struct basic_compressed_string_t
+{
+  const uint8_t *data = nullptr;
+  uint32_t length = 0;
+  uint32_t hash = 0;
+};
+
 template<typename F, typename S> struct pair
 {
   F first;
@@ -174,6 +306,10 @@ private:
   {
   };
 
+  struct key_filter_t
+  {
+  };
+
   struct object_key_view
   {
     std::basic_string_view<CharType> value{};
@@ -183,8 +319,10 @@ private:
 public:
   static constexpr uint32_t type_mask = 0b111u;
   static constexpr uint32_t sorted_mask = 0b1000u;
+  static constexpr uint32_t compressed_string_mask = sorted_mask;
   static constexpr uint32_t object_layout_shift = 4;
   static constexpr uint32_t object_layout_mask = 0b111u << object_layout_shift;
+  static constexpr uint32_t key_filter_mask = 0b1u << 7;
   static constexpr size_t npos = static_cast<size_t>(-1);
 
 private:
@@ -213,6 +351,8 @@ private:
     const basic_blob_ref_value_pair_t<CharType> *blob_ref_object_value;
     const detail::basic_indexed_mphf8_blob_ref_object_t<CharType> *indexed_mphf_blob_object_value;
     const CharType *long_data;
+    const uint8_t *compressed_data;
+    const uint64_t *key_filter_words;
     std::array<CharType, capacity> short_data;
     int64_t int_value;
     uint64_t uint_value;
@@ -275,8 +415,17 @@ private:
     indexed_mphf_blob_object() const noexcept;
   [[nodiscard]] constexpr size_t mphf_prefix_size(const detail::basic_mphf8_blob_ref_object_t<CharType> *object,
     uint32_t target_hash) const noexcept;
+  template<typename Object> static constexpr size_t mphf_prefix_entry(const Object *object, size_t i) noexcept
+  {
+    return object->prefix_order == nullptr ? i : object->prefix_order[i];
+  }
   [[nodiscard]] constexpr size_t mphf_prefix_size(const detail::basic_indexed_mphf8_blob_ref_object_t<CharType> *object,
     uint32_t target_hash) const noexcept;
+  [[nodiscard]] constexpr const uint64_t *key_filter() const noexcept;
+  [[nodiscard]] constexpr bool may_contain_key(uint32_t target_hash) const noexcept
+  {
+    return !has_key_filter() || detail::key_filter_may_contain(key_filter(), length_, target_hash);
+  }
 
   constexpr void set_metadata(Type t, size_t len, bool sorted = false, uint32_t extra_bits = 0u) noexcept;
   constexpr void set_string_metadata(size_t len, uint32_t hash_val) noexcept;
@@ -318,7 +467,9 @@ private:
     uint32_t target_hash) const
   {
     if (is_object() && object_layout() == ObjectLayout::Regular) [[likely]] {
-      if (const auto *entry = find_regular_entry(view, target_hash)) [[likely]]
+      const auto *entry = find_regular_entry(view, target_hash);
+      record_lookup(entry == nullptr ? npos : static_cast<size_t>(entry - data_storage_.object_value));
+      if (entry != nullptr) [[likely]]
         return entry->second;
       detail::throw_exception<std::out_of_range>("Key not found");
       return null_value();
@@ -329,11 +480,16 @@ private:
       const auto prefix_size = mphf_prefix_size(object, target_hash);
       const auto packed_hash = blob_target_hash(target_hash);
       for (size_t i = 0; i < prefix_size; ++i) {
-        const auto &entry = entries[i];
-        if (blob_key_hash(entry.key_meta) == packed_hash && blob_key_view(entries, entry) == view) return *entry.value;
+        const auto index = mphf_prefix_entry(object, i);
+        const auto &entry = entries[index];
+        if (blob_key_hash(entry.key_meta) == packed_hash && blob_key_view(entries, entry) == view) {
+          record_lookup(index);
+          return *entry.value;
+        }
       }
 
       const auto index = find_mphf_blob_entry_index_after_prefix(object, view, target_hash, prefix_size);
+      record_lookup(index);
       if (index != npos) [[likely]]
         return *entries[index].value;
       detail::throw_exception<std::out_of_range>("Key not found");
@@ -345,17 +501,24 @@ private:
       const auto packed_hash = static_cast<uint16_t>(target_hash);
       for (size_t i = 0; i < prefix_size; ++i) {
         if (object->prefix_hashes[i] != packed_hash) continue;
-        const auto &entry = object->entries[i];
-        if (indexed_blob_key_view(object, entry) == view) return object->values[indexed_value_index(entry.key_meta)];
+        const auto index = mphf_prefix_entry(object, i);
+        const auto &entry = object->entries[index];
+        if (indexed_blob_key_view(object, entry) == view) {
+          record_lookup(index);
+          return object->values[indexed_value_index(entry.key_meta)];
+        }
       }
 
       const auto index = find_indexed_mphf_blob_entry_index_after_prefix(object, view, target_hash, prefix_size);
+      record_lookup(index);
       if (index != npos) [[likely]]
         return object->values[indexed_value_index(object->entries[index].key_meta)];
       detail::throw_exception<std::out_of_range>("Key not found");
       return null_value();
     }
-    return entry_at(find_entry_index(view, target_hash));
+    const auto index = find_entry_index(view, target_hash);
+    record_lookup(index);
+    return entry_at(index);
   }
 
   [[nodiscard]] constexpr const basic_json &entry_at(size_t index) const
@@ -367,6 +530,62 @@ private:
   }
 
   constexpr basic_json(std::basic_string_view<CharType> v, uint32_t hash_val, prehashed_t) noexcept;
+  constexpr basic_json(basic_object_t<CharType> v, bool sorted, prehashed_t) noexcept
+    : data_storage_{ .object_value = v.data() }
+  {
+    set_metadata(Type::Object, v.size(), sorted, layout_bits(ObjectLayout::Regular));
+  }
+  constexpr basic_json(basic_compact_object_t<CharType> v, bool sorted, prehashed_t) noexcept
+    : data_storage_{ .compact_object_value = v.data() }
+  {
+    set_metadata(Type::Object, v.size(), sorted, layout_bits(ObjectLayout::CompactInline));
+  }
+  constexpr basic_json(basic_ref_value_object_t<CharType> v, bool sorted, prehashed_t) noexcept
+    : data_storage_{ .ref_value_object_value = v.data() }
+  {
+    set_metadata(Type::Object, v.size(), sorted, layout_bits(ObjectLayout::ValueByReference));
+  }
+  constexpr basic_json(basic_blob_ref_object_t<CharType> v, bool sorted, prehashed_t) noexcept
+    : data_storage_{ .blob_ref_object_value = v.entries }
+  {
+    set_metadata(Type::Object, v.size, sorted, layout_bits(ObjectLayout::BlobByReference));
+  }
+  constexpr basic_json(const basic_blob_ref_value_pair_t<CharType> *entries, size_t size, prehashed_t) noexcept
+    : data_storage_{ .blob_ref_object_value = entries }
+  {
+    set_metadata(Type::Object, size, false, layout_bits(ObjectLayout::PerfectHashBlobByReference));
+  }
+  constexpr basic_json(const detail::basic_indexed_mphf8_blob_ref_object_t<CharType> *v,
+    size_t size,
+    prehashed_t) noexcept
+    : data_storage_{ .indexed_mphf_blob_object_value = v }
+  {
+    set_metadata(Type::Object, size, false, layout_bits(ObjectLayout::IndexedPerfectHashBlobByReference));
+  }
+  constexpr basic_json(const uint64_t *words, key_filter_t) noexcept : data_storage_{ .key_filter_words = words } {}
+
+  [[nodiscard]] constexpr bool string_equals(std::basic_string_view<CharType> view) const noexcept;
+
+  constexpr void record_access([[maybe_unused]] size_t entry) const noexcept
+  {
+#ifdef JSON2CPP_RECORD_ACCESS
+    if !consteval {
+      detail::record_access(node_address(), entry);
+    }
+#endif
+  }
+
+  [[nodiscard]] constexpr basic_entry_view_t<CharType> lookup_entry(std::basic_string_view<CharType> key,
+    uint32_t target_hash) const noexcept;
+
+  // Counts one key lookup on an object from the entry index it found (npos on a miss).
+  constexpr void record_lookup([[maybe_unused]] size_t entry) const noexcept
+  {
+#ifdef JSON2CPP_RECORD_ACCESS
+    if (is_object()) record_access(entry);
+#endif
+  }
+  [[nodiscard]] constexpr bool compressed_bytes_equal(const basic_json &other) const noexcept;
 
 public:
   static constexpr uint32_t calc_hash(std::basic_string_view<CharType> sv) noexcept { return detail::hash_key(sv); }
@@ -378,7 +597,12 @@ public:
   }
 
   [[nodiscard]] constexpr basic_entry_view_t<CharType> find_entry(std::basic_string_view<CharType> key,
-    uint32_t target_hash) const noexcept;
+    uint32_t target_hash) const noexcept
+  {
+    const auto entry = lookup_entry(key, target_hash);
+    record_lookup(entry ? entry.first.index : npos);
+    return entry;
+  }
 
   [[nodiscard]] constexpr basic_entry_view_t<CharType> find_entry(std::basic_string_view<CharType> key) const noexcept
   {
@@ -396,6 +620,10 @@ public:
 
   [[nodiscard]] constexpr size_t size() const noexcept { return length_; }
   [[nodiscard]] constexpr bool is_sorted_obj() const noexcept { return (metadata_ & sorted_mask) != 0u; }
+  [[nodiscard]] constexpr bool has_key_filter() const noexcept
+  {
+    return is_object() && (metadata_ & key_filter_mask) != 0u;
+  }
   [[nodiscard]] constexpr uint32_t hash() const noexcept { return metadata_ >> 4; }
 
   constexpr basic_json() noexcept : length_(0), metadata_(0), data_storage_{ .short_data = {} } {}
@@ -442,13 +670,68 @@ public:
     init_object(v, ObjectLayout::ValueByReference);
   }
 
+  constexpr basic_json(basic_compressed_string_t<CharType> v) noexcept : data_storage_{ .compressed_data = v.data }
+  {
+    set_string_metadata(v.length, v.hash);
+    metadata_ |= compressed_string_mask;
+  }
+
   constexpr basic_json(basic_blob_ref_object_t<CharType> v) noexcept;
   constexpr basic_json(const detail::basic_mphf8_blob_ref_object_t<CharType> *v) noexcept;
   constexpr basic_json(const detail::basic_indexed_mphf8_blob_ref_object_t<CharType> *v) noexcept;
 
+  // Values with metadata computed by the generator: hash_val must be calc_hash(v), and sorted whether the keys are in
+  // ascending order. Nothing is hashed, validated or compared. These are functions rather than constructors so that
+  // each call in a generated document does not go through overload resolution over every constructor.
+  [[nodiscard]] static constexpr basic_json prehashed_string(std::basic_string_view<CharType> v,
+    uint32_t hash_val) noexcept
+  {
+    return basic_json(v, hash_val, prehashed_t{});
+  }
+  template<typename Entries> [[nodiscard]] static constexpr basic_json prehashed_object(Entries v, bool sorted) noexcept
+  {
+    return basic_json(v, sorted, prehashed_t{});
+  }
+  // Perfect-hash objects given the entries their descriptor points to, or the indexed descriptor itself, and their
+  // size; the descriptor is not read, so it can be a constinit variable.
+  [[nodiscard]] static constexpr basic_json prehashed_perfect_hash_object(
+    const basic_blob_ref_value_pair_t<CharType> *entries,
+    size_t size) noexcept
+  {
+    return basic_json(entries, size, prehashed_t{});
+  }
+  [[nodiscard]] static constexpr basic_json prehashed_perfect_hash_object(
+    const detail::basic_indexed_mphf8_blob_ref_object_t<CharType> *object,
+    size_t size) noexcept
+  {
+    return basic_json(object, size, prehashed_t{});
+  }
+
+  // An object whose lookups first check the key filter of detail::key_filter_words(size) words written by the
+  // generator. Regular, compact and value-ref entries are preceded by a key_filter_header() entry (its first json, or
+  // the value of a compact one), blob entries by a header pair holding the filter before the keys, and perfect-hash
+  // descriptors point to it.
+  template<typename Object> [[nodiscard]] static constexpr basic_json key_filtered(Object v) noexcept
+  {
+    basic_json result(v);
+    result.metadata_ |= key_filter_mask;
+    return result;
+  }
+  [[nodiscard]] static constexpr basic_json key_filter_header(const uint64_t *words) noexcept
+  {
+    return basic_json(words, key_filter_t{});
+  }
+
+  // Identity of the storage behind an array or object (nullptr for scalars); shared subtrees share an address.
+  [[nodiscard]] constexpr const void *node_address() const noexcept;
+
   [[nodiscard]] constexpr bool is_object() const noexcept { return type() == Type::Object; }
   [[nodiscard]] constexpr bool is_array() const noexcept { return type() == Type::Array; }
   [[nodiscard]] constexpr bool is_string() const noexcept { return type() == Type::String; }
+  [[nodiscard]] constexpr bool is_compressed_string() const noexcept
+  {
+    return is_string() && (metadata_ & compressed_string_mask) != 0u;
+  }
   [[nodiscard]] constexpr bool is_boolean() const noexcept { return type() == Type::Boolean; }
   [[nodiscard]] constexpr bool is_null() const noexcept { return type() == Type::Null; }
   [[nodiscard]] constexpr bool empty() const noexcept { return length_ == 0; }
@@ -459,6 +742,15 @@ public:
     return t == Type::Integer || t == Type::UInteger || t == Type::Float;
   }
 
+  // Same meaning as in nlohmann::json: integers are signed or unsigned.
+  [[nodiscard]] constexpr bool is_number_integer() const noexcept
+  {
+    const auto t = type();
+    return t == Type::Integer || t == Type::UInteger;
+  }
+  [[nodiscard]] constexpr bool is_number_unsigned() const noexcept { return type() == Type::UInteger; }
+  [[nodiscard]] constexpr bool is_number_float() const noexcept { return type() == Type::Float; }
+
   [[nodiscard]] constexpr const basic_json &operator[](std::integral auto index) const { return at(index); }
 
   template<size_t N> [[nodiscard]] constexpr const basic_json &operator[](const CharType (&key)[N]) const
@@ -490,7 +782,10 @@ public:
     case Type::Float:
       return data_storage_.float_value == other.data_storage_.float_value;
     case Type::String:
-      return getString() == other.getString();
+      if (hash() != other.hash() || length_ != other.length_) return false;
+      if (is_compressed_string() && other.is_compressed_string()) return compressed_bytes_equal(other);
+      if (other.is_compressed_string()) return other.string_equals(getString());
+      return string_equals(other.getString());
     case Type::Array:
       if (length_ != other.length_) return false;
       for (size_t i = 0; i < length_; ++i)
@@ -511,7 +806,7 @@ public:
 
   constexpr bool operator==(std::basic_string_view<CharType> other) const noexcept
   {
-    return is_string() && getString() == other;
+    return is_string() && string_equals(other);
   }
 
   template<typename T> constexpr bool operator==(const T &other) const noexcept
@@ -542,7 +837,7 @@ public:
         return false;
       }
     else if constexpr (detail::string_like<T, CharType>)
-      return is_string() && getString() == detail::make_string_view<CharType>(other);
+      return is_string() && string_equals(detail::make_string_view<CharType>(other));
     else
       return false;
   }
@@ -575,13 +870,17 @@ public:
 
   [[nodiscard]] constexpr bool contains(std::basic_string_view<CharType> key) const noexcept
   {
-    return find_entry_index(key) != npos;
+    const auto index = find_entry_index(key);
+    record_lookup(index);
+    return index != npos;
   }
 
   template<size_t N> [[nodiscard]] constexpr bool contains(const CharType (&key)[N]) const noexcept
   {
     const detail::CompileTimeKey<CharType, N> lookup(key);
-    return find_entry_index(lookup.value, lookup.hash) != npos;
+    const auto index = find_entry_index(lookup.value, lookup.hash);
+    record_lookup(index);
+    return index != npos;
   }
 
   [[nodiscard]] constexpr size_t index(std::basic_string_view<CharType> view) const noexcept
@@ -591,7 +890,7 @@ public:
     if (is_array()) {
       for (size_t i = 0; i < length_; ++i) {
         const auto &current = data_storage_.array_value[i];
-        if (current.is_string() && current.hash() == target_hash && current.getString() == view) return i;
+        if (current.is_string() && current.hash() == target_hash && current.string_equals(view)) return i;
       }
       return npos;
     }
@@ -602,7 +901,7 @@ public:
       const auto entries = std::span(data_storage_.object_value, length_);
       for (size_t i = 0; i < entries.size(); ++i) {
         const auto &current = entries[i].second;
-        if (current.is_string() && current.hash() == target_hash && current.getString() == view) return i;
+        if (current.is_string() && current.hash() == target_hash && current.string_equals(view)) return i;
       }
       return npos;
     }
@@ -611,7 +910,7 @@ public:
       const auto entries = std::span(data_storage_.compact_object_value, length_);
       for (size_t i = 0; i < entries.size(); ++i) {
         const auto &current = entries[i].value;
-        if (current.is_string() && current.hash() == target_hash && current.getString() == view) return i;
+        if (current.is_string() && current.hash() == target_hash && current.string_equals(view)) return i;
       }
       return npos;
     }
@@ -622,7 +921,7 @@ public:
       for (size_t i = 0; i < entries.size(); ++i) {
         if (blob_value_hash(entries[i].key_meta) != value_hash) continue;
         const auto &current = *entries[i].value;
-        if (current.is_string() && current.hash() == target_hash && current.getString() == view) return i;
+        if (current.is_string() && current.hash() == target_hash && current.string_equals(view)) return i;
       }
       return npos;
     }
@@ -634,7 +933,7 @@ public:
       for (size_t i = 0; i < length_; ++i) {
         if (object->value_hashes[i] != value_hash) continue;
         const auto &current = values[indexed_value_index(entries[i].key_meta)];
-        if (current.is_string() && current.hash() == target_hash && current.getString() == view) { return i; }
+        if (current.is_string() && current.hash() == target_hash && current.string_equals(view)) { return i; }
       }
       return npos;
     }
@@ -642,7 +941,7 @@ public:
     const auto entries = std::span(data_storage_.ref_value_object_value, length_);
     for (size_t i = 0; i < entries.size(); ++i) {
       const auto &current = *entries[i].second;
-      if (current.is_string() && current.hash() == target_hash && current.getString() == view) return i;
+      if (current.is_string() && current.hash() == target_hash && current.string_equals(view)) return i;
     }
     return npos;
   }
@@ -700,7 +999,9 @@ public:
 
   [[nodiscard]] constexpr const basic_json *begin() const noexcept
   {
-    return is_array() ? data_storage_.array_value : nullptr;
+    if (!is_array()) return nullptr;
+    record_access(npos);
+    return data_storage_.array_value;
   }
 
   [[nodiscard]] constexpr const basic_json *end() const noexcept
@@ -719,7 +1020,48 @@ public:
     return length_ <= capacity ? data_storage_.short_data.data() : data_storage_.long_data;
   }
 
-  [[nodiscard]] constexpr std::basic_string_view<CharType> getString() const noexcept { return { data(), length_ }; }
+  // Compressed strings have no contiguous text to view: asking for one fails constant evaluation, throws
+  // std::domain_error in debug builds and yields an empty view otherwise. Read them through decompress_to() or
+  // json2cpp::get_string() (json2cpp_string_cache.hpp).
+  [[nodiscard]] constexpr std::basic_string_view<CharType> getString() const
+  {
+    if (is_compressed_string()) [[unlikely]] {
+      detail::throw_exception<std::domain_error>("JSON string is compressed, read it through get_string()");
+      return {};
+    }
+    return { data(), length_ };
+  }
+
+  [[nodiscard]] constexpr const uint8_t *compressed_data() const noexcept
+  {
+    return is_compressed_string() ? data_storage_.compressed_data : nullptr;
+  }
+
+  // Writes the size() units of a string value to out, decompressing if needed.
+  constexpr void decompress_to(CharType *out) const noexcept
+  {
+    if (!is_compressed_string()) {
+      const auto view = getString();
+      for (size_t i = 0; i < view.size(); ++i) out[i] = view[i];
+      return;
+    }
+
+    struct writer
+    {
+      CharType *out;
+      constexpr bool literal(size_t pos, CharType c) const noexcept
+      {
+        out[pos] = c;
+        return true;
+      }
+      constexpr bool copy(size_t pos, size_t from) const noexcept
+      {
+        out[pos] = out[from];
+        return true;
+      }
+    };
+    detail::lz_decode<CharType>(data_storage_.compressed_data, length_, writer{ out });
+  }
 
   [[nodiscard]] constexpr double getNumber() const;
 
@@ -730,6 +1072,10 @@ public:
         detail::throw_exception<std::domain_error>("JSON value is not a string");
         return {};
       }
+      if (is_compressed_string()) [[unlikely]] {
+        detail::throw_exception<std::domain_error>("JSON string is compressed");
+        return {};
+      }
       return getString();
     } else if constexpr (std::is_same_v<T, bool>) {
       if (!is_boolean()) [[unlikely]] {
@@ -768,6 +1114,10 @@ template<typename CharType> struct basic_key_descriptor
   constexpr explicit basic_key_descriptor(std::basic_string_view<CharType> sv) noexcept
     : data(sv.data()), length(static_cast<uint32_t>(sv.size())), hash(detail::hash_key(sv))
   {}
+  // hash_val must be detail::hash_key(sv).
+  constexpr basic_key_descriptor(std::basic_string_view<CharType> sv, uint32_t hash_val) noexcept
+    : data(sv.data()), length(static_cast<uint32_t>(sv.size())), hash(hash_val)
+  {}
 
   template<size_t N>
   constexpr basic_key_descriptor(const CharType (&str)[N]) noexcept
@@ -799,11 +1149,13 @@ template<typename CharType> struct basic_blob_ref_value_pair_t
     const basic_json<CharType> *value = nullptr;
     const CharType *keys;
     const detail::basic_mphf8_blob_ref_object_t<CharType> *mphf_object;
+    const uint64_t *key_filter;
   };
   uint64_t key_meta = 0;
 
   constexpr basic_blob_ref_value_pair_t() noexcept = default;
   constexpr basic_blob_ref_value_pair_t(const CharType *k, header_t) noexcept : keys(k), key_meta(0) {}
+  constexpr basic_blob_ref_value_pair_t(const uint64_t *filter, header_t) noexcept : key_filter(filter), key_meta(0) {}
   constexpr basic_blob_ref_value_pair_t(const detail::basic_mphf8_blob_ref_object_t<CharType> *object,
     header_t) noexcept
     : mphf_object(object), key_meta(0)
@@ -854,6 +1206,10 @@ namespace detail {
     uint8_t seed1 = 0;
     uint8_t seed2 = 0;
     uint64_t prefix_mask = ~uint64_t{ 0 };
+    // Entry indices scanned before probing the table, hottest first; nullptr scans the leading entries.
+    const uint8_t *prefix_order = nullptr;
+    // Key filter checked before the prefix scan when the object has one, see basic_json::key_filtered().
+    const uint64_t *key_filter = nullptr;
   };
 
   template<typename CharType> struct basic_indexed_mphf8_blob_ref_object_t
@@ -869,6 +1225,10 @@ namespace detail {
     uint8_t seed1 = 0;
     uint8_t seed2 = 0;
     uint64_t prefix_mask = ~uint64_t{ 0 };
+    // Entry indices scanned before probing the table, hottest first; nullptr scans the leading entries.
+    const uint8_t *prefix_order = nullptr;
+    // Key filter checked before the prefix scan when the object has one, see basic_json::key_filtered().
+    const uint64_t *key_filter = nullptr;
   };
 
   template<typename CharType, size_t EntryCount> struct basic_indexed_blob_storage_t
@@ -880,13 +1240,15 @@ namespace detail {
     std::array<uint16_t, prefix_size> prefix_hashes{};
   };
 
-  template<typename CharType, size_t KeyCount, size_t EntryCount>
-  consteval auto make_indexed_blob_storage(const CharType (&keys)[KeyCount],
+  template<typename CharType, size_t EntryCount>
+  consteval auto make_indexed_blob_storage(const CharType *keys,
     const std::array<uint16_t, EntryCount> &lengths,
     const std::array<uint8_t, EntryCount> &value_indices,
-    const basic_json<CharType> *values)
+    const basic_json<CharType> *values,
+    const uint8_t *prefix_order = nullptr)
   {
     basic_indexed_blob_storage_t<CharType, EntryCount> result{};
+    std::array<uint16_t, EntryCount> key_hashes{};
     uint32_t offset = 0;
     for (size_t i = 0; i < EntryCount; ++i) {
       const auto length = static_cast<uint32_t>(lengths[i]);
@@ -898,10 +1260,11 @@ namespace detail {
         offset, length, key_hash, values[value_index].hash(), value_index
       };
       result.value_hashes[i] = static_cast<uint8_t>(values[value_index].hash());
-      if (i < result.prefix_hashes.size()) result.prefix_hashes[i] = static_cast<uint16_t>(key_hash);
+      key_hashes[i] = static_cast<uint16_t>(key_hash);
       offset += length;
     }
-    (void)KeyCount;
+    for (size_t i = 0; i < result.prefix_hashes.size(); ++i)
+      result.prefix_hashes[i] = key_hashes[prefix_order == nullptr ? i : prefix_order[i]];
     return result;
   }
 }// namespace detail
@@ -1021,6 +1384,18 @@ template<typename CharType> struct basic_items_t
   [[nodiscard]] constexpr bool empty() const noexcept { return size() == 0; }
   [[nodiscard]] constexpr iterator begin() const noexcept { return { owner, entries, first_value, 0, stride, layout }; }
   [[nodiscard]] constexpr iterator end() const noexcept { return { owner, nullptr, nullptr, size(), stride, layout }; }
+
+  // Iterator on the member at index, e.g. the one basic_json::find_entry() returned; end() if out of range.
+  [[nodiscard]] constexpr iterator iterator_at(size_t index) const noexcept
+  {
+    if (index >= size()) return end();
+    return { owner,
+      static_cast<const std::byte *>(entries) + (index * stride),
+      &owner->entry_value(index),
+      index,
+      stride,
+      layout };
+  }
 };
 
 template<typename CharType>
@@ -1036,6 +1411,42 @@ constexpr void basic_json<CharType>::set_string_metadata(size_t len, uint32_t ha
   set_metadata(Type::String, len, false, (hash_val & 0x0FFFFFFFu) << 4);
 }
 
+template<typename CharType>
+constexpr bool basic_json<CharType>::string_equals(std::basic_string_view<CharType> view) const noexcept
+{
+  if (!is_compressed_string()) [[likely]]
+    return getString() == view;
+  if (view.size() != length_) return false;
+
+  // A match copies earlier output, which equals the earlier part of view whenever the strings are equal.
+  struct comparer
+  {
+    std::basic_string_view<CharType> view;
+    constexpr bool literal(size_t pos, CharType c) const noexcept { return view[pos] == c; }
+    constexpr bool copy(size_t pos, size_t from) const noexcept { return view[pos] == view[from]; }
+  };
+  return detail::lz_decode<CharType>(data_storage_.compressed_data, length_, comparer{ view }) != nullptr;
+}
+
+template<typename CharType>
+constexpr bool basic_json<CharType>::compressed_bytes_equal(const basic_json &other) const noexcept
+{
+  // The generator's encoder is deterministic, so equal strings always compress to the same bytes.
+  const auto *first = data_storage_.compressed_data;
+  const auto *second = other.data_storage_.compressed_data;
+  if (first == second) return true;
+
+  struct skipper
+  {
+    constexpr bool literal(size_t, CharType) const noexcept { return true; }
+    constexpr bool copy(size_t, size_t) const noexcept { return true; }
+  };
+  const auto *last = detail::lz_decode<CharType>(first, length_, skipper{});
+  for (; first != last; ++first, ++second)
+    if (*first != *second) return false;
+  return true;
+}
+
 template<typename CharType>
 constexpr std::basic_string_view<CharType> basic_json<CharType>::blob_key_view(
   const basic_blob_ref_value_pair_t<CharType> *entries,
@@ -1173,6 +1584,24 @@ constexpr size_t basic_json<CharType>::mphf_prefix_size(
   return length_ < mphf_linear_prefix ? length_ : mphf_linear_prefix;
 }
 
+template<typename CharType> constexpr const uint64_t *basic_json<CharType>::key_filter() const noexcept
+{
+  switch (object_layout()) {
+  case ObjectLayout::Regular:
+    return data_storage_.object_value[-1].first.data_storage_.key_filter_words;
+  case ObjectLayout::CompactInline:
+    return data_storage_.compact_object_value[-1].value.data_storage_.key_filter_words;
+  case ObjectLayout::ValueByReference:
+    return data_storage_.ref_value_object_value[-1].first.data_storage_.key_filter_words;
+  case ObjectLayout::BlobByReference:
+    return data_storage_.blob_ref_object_value[-2].key_filter;
+  case ObjectLayout::PerfectHashBlobByReference:
+    return mphf_blob_object()->key_filter;
+  default:
+    return indexed_mphf_blob_object()->key_filter;
+  }
+}
+
 template<typename CharType>
 constexpr basic_json<CharType>::basic_json(std::basic_string_view<CharType> v, uint32_t hash_val, prehashed_t) noexcept
   : data_storage_{ .short_data = {} }
@@ -1305,7 +1734,10 @@ constexpr size_t basic_json<CharType>::find_entry_index(std::basic_string_view<C
 {
   if (!is_object() || length_ == 0) return npos;
   if (is_blob_ref_layout(object_layout())) return find_entry_index(key, calc_hash(key));
-  if (is_sorted_obj()) return find_sorted_entry_index(key);
+  if (is_sorted_obj()) {
+    if (has_key_filter() && !may_contain_key(calc_hash(key))) return npos;
+    return find_sorted_entry_index(key);
+  }
   return find_entry_index(key, calc_hash(key));
 }
 
@@ -1319,8 +1751,9 @@ JSON2CPP_DETAIL_INLINE constexpr size_t basic_json<CharType>::find_mphf_blob_ent
   const auto prefix_size = mphf_prefix_size(object, target_hash);
   const auto packed_hash = blob_target_hash(target_hash);
   for (size_t i = 0; i < prefix_size; ++i) {
-    const auto &entry = entries[i];
-    if (blob_key_hash(entry.key_meta) == packed_hash && blob_key_view(entries, entry) == key) return i;
+    const auto index = mphf_prefix_entry(object, i);
+    const auto &entry = entries[index];
+    if (blob_key_hash(entry.key_meta) == packed_hash && blob_key_view(entries, entry) == key) return index;
   }
 
   return find_mphf_blob_entry_index_after_prefix(object, key, target_hash, prefix_size);
@@ -1336,7 +1769,7 @@ JSON2CPP_DETAIL_INLINE constexpr size_t basic_json<CharType>::find_mphf_blob_ent
   const auto bucket = mphf_mix(target_hash, object->seed1) % object->bucket_count;
   const auto slot = (mphf_mix(target_hash, object->seed2) + object->table[bucket]) % length_;
   const auto index = object->table[object->bucket_count + slot];
-  if (index >= length_ || index < prefix_size) return npos;
+  if (index >= length_ || (object->prefix_order == nullptr && index < prefix_size)) return npos;
 
   const auto entries = data_storage_.blob_ref_object_value;
   const auto &entry = entries[index];
@@ -1354,8 +1787,8 @@ JSON2CPP_DETAIL_INLINE constexpr size_t basic_json<CharType>::find_indexed_mphf_
   const auto packed_hash = static_cast<uint16_t>(target_hash);
   for (size_t i = 0; i < prefix_size; ++i) {
     if (object->prefix_hashes[i] != packed_hash) continue;
-    const auto &entry = object->entries[i];
-    if (indexed_blob_key_view(object, entry) == key) return i;
+    const auto index = mphf_prefix_entry(object, i);
+    if (indexed_blob_key_view(object, object->entries[index]) == key) return index;
   }
 
   return find_indexed_mphf_blob_entry_index_after_prefix(object, key, target_hash, prefix_size);
@@ -1371,7 +1804,7 @@ JSON2CPP_DETAIL_INLINE constexpr size_t basic_json<CharType>::find_indexed_mphf_
   const auto bucket = mphf_mix(target_hash, object->seed1) % object->bucket_count;
   const auto slot = (mphf_mix(target_hash, object->seed2) + object->table[bucket]) % length_;
   const auto index = object->table[object->bucket_count + slot];
-  if (index >= length_ || index < prefix_size) return npos;
+  if (index >= length_ || (object->prefix_order == nullptr && index < prefix_size)) return npos;
 
   const auto &entry = object->entries[index];
   return indexed_blob_key_view(object, entry) == key ? index : npos;
@@ -1381,7 +1814,7 @@ template<typename CharType>
 constexpr size_t basic_json<CharType>::find_entry_index(std::basic_string_view<CharType> key,
   uint32_t target_hash) const noexcept
 {
-  if (!is_object() || length_ == 0) return npos;
+  if (!is_object() || length_ == 0 || !may_contain_key(target_hash)) return npos;
 
   const auto layout = object_layout();
   if (layout == ObjectLayout::Regular) {
@@ -1435,10 +1868,10 @@ constexpr const basic_value_pair_t<CharType> *
 }
 
 template<typename CharType>
-constexpr basic_entry_view_t<CharType> basic_json<CharType>::find_entry(std::basic_string_view<CharType> key,
+constexpr basic_entry_view_t<CharType> basic_json<CharType>::lookup_entry(std::basic_string_view<CharType> key,
   uint32_t target_hash) const noexcept
 {
-  if (!is_object() || length_ == 0) return {};
+  if (!is_object() || length_ == 0 || !may_contain_key(target_hash)) return {};
   const auto layout = object_layout();
   if (layout == ObjectLayout::Regular) {
     const auto entries = data_storage_.object_value;
@@ -1462,9 +1895,10 @@ constexpr basic_entry_view_t<CharType> basic_json<CharType>::find_entry(std::bas
     const auto prefix_size = mphf_prefix_size(object, target_hash);
     const auto packed_hash = blob_target_hash(target_hash);
     for (size_t i = 0; i < prefix_size; ++i) {
-      const auto &entry = entries[i];
+      const auto index = mphf_prefix_entry(object, i);
+      const auto &entry = entries[index];
       if (blob_key_hash(entry.key_meta) == packed_hash && blob_key_view(entries, entry) == key)
-        return { { this, i }, entry.value };
+        return { { this, index }, entry.value };
     }
 
     const auto index = find_mphf_blob_entry_index_after_prefix(object, key, target_hash, prefix_size);
@@ -1478,9 +1912,10 @@ constexpr basic_entry_view_t<CharType> basic_json<CharType>::find_entry(std::bas
     const auto packed_hash = static_cast<uint16_t>(target_hash);
     for (size_t i = 0; i < prefix_size; ++i) {
       if (object->prefix_hashes[i] != packed_hash) continue;
-      const auto &entry = object->entries[i];
+      const auto index = mphf_prefix_entry(object, i);
+      const auto &entry = object->entries[index];
       if (indexed_blob_key_view(object, entry) == key)
-        return { { this, i }, &object->values[indexed_value_index(entry.key_meta)] };
+        return { { this, index }, &object->values[indexed_value_index(entry.key_meta)] };
     }
 
     const auto index = find_indexed_mphf_blob_entry_index_after_prefix(object, key, target_hash, prefix_size);
@@ -1517,6 +1952,7 @@ constexpr const basic_json<CharType> &basic_json<CharType>::at(std::integral aut
     detail::throw_exception<std::out_of_range>("Index out of range");
     return null_value();
   }
+  record_access(static_cast<size_t>(index));
   return t == Type::Array ? data_storage_.array_value[index] : entry_value(static_cast<size_t>(index));
 }
 
@@ -1527,6 +1963,7 @@ template<typename CharType> constexpr basic_items_t<CharType> basic_json<CharTyp
     return {};
   }
   const auto layout = object_layout();
+  record_access(npos);
   if (length_ == 0) return { this, nullptr, nullptr, 0, static_cast<uint8_t>(layout) };
   if (layout == ObjectLayout::Regular) {
     const auto entries = data_storage_.object_value;
@@ -1556,6 +1993,24 @@ template<typename CharType> constexpr basic_items_t<CharType> basic_json<CharTyp
   return { this, entries, entries[0].second, sizeof(basic_ref_value_pair_t<CharType>), static_cast<uint8_t>(layout) };
 }
 
+template<typename CharType> constexpr const void *basic_json<CharType>::node_address() const noexcept
+{
+  if (is_array()) return data_storage_.array_value;
+  if (!is_object()) return nullptr;
+  switch (object_layout()) {
+  case ObjectLayout::Regular:
+    return data_storage_.object_value;
+  case ObjectLayout::CompactInline:
+    return data_storage_.compact_object_value;
+  case ObjectLayout::ValueByReference:
+    return data_storage_.ref_value_object_value;
+  case ObjectLayout::IndexedPerfectHashBlobByReference:
+    return data_storage_.indexed_mphf_blob_object_value;
+  default:
+    return data_storage_.blob_ref_object_value;
+  }
+}
+
 template<typename CharType> constexpr double basic_json<CharType>::getNumber() const
 {
   switch (type()) {
@@ -1571,6 +2026,107 @@ template<typename CharType> constexpr double basic_json<CharType>::getNumber() c
   }
 }
 
+#ifdef JSON2CPP_RECORD_ACCESS
+namespace detail {
+  template<typename CharType> void append_pointer_token(std::string &path, std::basic_string_view<CharType> key)
+  {
+    path += '/';
+    for (size_t i = 0; i < key.size(); ++i) {
+      uint32_t cp = static_cast<uint32_t>(key[i]);
+      if constexpr (sizeof(CharType) == 1) {
+        cp &= 0xFFu;
+      } else if (cp >= 0xD800u && cp < 0xDC00u && i + 1 < key.size()) {
+        cp = 0x10000u + ((cp - 0xD800u) << 10) + (static_cast<uint32_t>(key[++i]) - 0xDC00u);
+      }
+
+      if (cp == '~') {
+        path += "~0";
+      } else if (cp == '/') {
+        path += "~1";
+      } else if (sizeof(CharType) == 1 || cp < 0x80u) {
+        path += static_cast<char>(cp);
+      } else if (cp < 0x800u) {
+        path += static_cast<char>(0xC0u | (cp >> 6));
+        path += static_cast<char>(0x80u | (cp & 0x3Fu));
+      } else if (cp < 0x10000u) {
+        path += static_cast<char>(0xE0u | (cp >> 12));
+        path += static_cast<char>(0x80u | ((cp >> 6) & 0x3Fu));
+        path += static_cast<char>(0x80u | (cp & 0x3Fu));
+      } else {
+        path += static_cast<char>(0xF0u | (cp >> 18));
+        path += static_cast<char>(0x80u | ((cp >> 12) & 0x3Fu));
+        path += static_cast<char>(0x80u | ((cp >> 6) & 0x3Fu));
+        path += static_cast<char>(0x80u | (cp & 0x3Fu));
+      }
+    }
+  }
+
+  // Writes one line per accessed node: lookups that reached it from its parent plus lookups and iterations on it.
+  template<typename CharType>
+  void write_access_profile_node(const basic_json<CharType> &node,
+    uint64_t incoming,
+    std::string &path,
+    const std::unordered_map<access_key_t, uint64_t, access_key_hash> &counts,
+    std::unordered_set<const void *> &visited,
+    std::ostream &out)
+  {
+    const auto *address = node.node_address();
+    const bool expand = address != nullptr && visited.insert(address).second;
+    const auto count_of = [&](size_t entry) {
+      const auto it = counts.find({ address, entry });
+      return it == counts.end() ? uint64_t{ 0 } : it->second;
+    };
+
+    if (const auto count = incoming + (expand ? count_of(static_cast<size_t>(-1)) : 0); count != 0)
+      out << count << ' ' << path << '\n';
+    if (!expand) return;
+
+    const auto path_size = path.size();
+    if (node.is_array()) {
+      for (size_t i = 0; i < node.size(); ++i) {
+        path += '/';
+        path += std::to_string(i);
+        write_access_profile_node(node[i], count_of(i), path, counts, visited, out);
+        path.resize(path_size);
+      }
+    } else {
+      size_t index = 0;
+      for (const auto &[key, value] : node.items()) {
+        append_pointer_token(path, key.getString());
+        write_access_profile_node(value, count_of(index++), path, counts, visited, out);
+        path.resize(path_size);
+      }
+    }
+  }
+}// namespace detail
+
+// Writes the access counts recorded so far as "<count> <json pointer>" lines, the input of the generator's
+// --profile option. Counts of subtrees shared between several paths are written once, under the first path found.
+template<typename CharType> void write_access_profile(const basic_json<CharType> &root, std::ostream &out)
+{
+  auto &log = detail::access_log();
+  std::unordered_map<detail::access_key_t, uint64_t, detail::access_key_hash> counts;
+  {
+    std::lock_guard lock(log.mutex);
+    counts = log.counts;
+  }
+
+  detail::access_recording_paused = true;
+  std::string path;
+  std::unordered_set<const void *> visited;
+  out << "# json2cpp access profile\n";
+  detail::write_access_profile_node(root, 0, path, counts, visited, out);
+  detail::access_recording_paused = false;
+}
+
+inline void reset_access_profile()
+{
+  auto &log = detail::access_log();
+  std::lock_guard lock(log.mutex);
+  log.counts.clear();
+}
+#endif
+
 #ifdef JSON2CPP_USE_UTF16
 using basicType = char16_t;
 #else
@@ -1592,6 +2148,7 @@ using ref_value_pair_t = basic_ref_value_pair_t<basicType>;
 using ref_value_object_t = basic_ref_value_object_t<basicType>;
 using blob_ref_value_pair_t = basic_blob_ref_value_pair_t<basicType>;
 using blob_ref_object_t = basic_blob_ref_object_t<basicType>;
+using compressed_string_t = basic_compressed_string_t<basicType>;
 
 }// namespace json2cpp
 
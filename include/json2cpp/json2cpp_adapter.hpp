@@ -35,6 +35,7 @@ SOFTWARE.
  *  - json2cppJsonValueIterator
  *  - json2cppJsonFrozenValue
  *  - json2cppJsonObject
+ *  - json2cppJsonObjectKey
  *  - json2cppJsonObjectMember
  *  - json2cppJsonObjectMemberIterator
  *  - json2cppJsonValue
@@ -45,14 +46,31 @@ SOFTWARE.
  * since most of the functionality is inherited from the BasicAdapter class.
  * Most of the classes in this file are provided as template arguments to the
  * inherited BasicAdapter class.
+ *
+ * Iteration and property lookups do not allocate: arrays are walked in place,
+ * object members through basic_json::items(), and find() goes through
+ * basic_json::find_entry() and therefore the perfect-hash and blob fast paths.
+ * Member keys are views into the compiled document and only become a
+ * std::string where valijson asks for one.
+ *
+ * Frozen values point at the compiled document, which is immutable and has
+ * static lifetime, instead of copying it. The wrapper objects valijson owns
+ * and deletes come from json2cppJsonFrozenValuePool.
  */
 
 #pragma once
 
 #include "json2cpp.hpp"
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <new>
 #include <string>
-
+#include <string_view>
 #include <utility>
+#include <vector>
+
 #include <valijson/exceptions.hpp>
 #include <valijson/internal/adapter.hpp>
 #include <valijson/internal/basic_adapter.hpp>
@@ -64,8 +82,41 @@ namespace adapters {
   class json2cppJsonAdapter;
   class json2cppJsonArrayValueIterator;
   class json2cppJsonObjectMemberIterator;
+  struct json2cppJsonObjectMember;
+
+  /**
+   * @brief  Key of an object member, viewing the text stored in the document.
+   *
+   * Converts implicitly to std::string_view and, for the parts of valijson
+   * that take a const std::string &, to std::string.
+   */
+  class json2cppJsonObjectKey
+  {
+  public:
+    json2cppJsonObjectKey() = default;
+
+    explicit json2cppJsonObjectKey(std::string_view key) : m_key(key) {}
+
+    operator std::string_view() const noexcept { return m_key; }
+
+    operator std::string() const { return std::string(m_key); }
+
+    const char *data() const noexcept { return m_key.data(); }
+
+    size_t size() const noexcept { return m_key.size(); }
+
+    bool empty() const noexcept { return m_key.empty(); }
+
+    friend bool operator==(const json2cppJsonObjectKey &lhs, std::string_view rhs) noexcept { return lhs.m_key == rhs; }
+
+    friend bool operator==(const json2cppJsonObjectKey &lhs, const json2cppJsonObjectKey &rhs) noexcept
+    {
+      return lhs.m_key == rhs.m_key;
+    }
 
-  typedef std::pair<std::string, json2cppJsonAdapter> json2cppJsonObjectMember;
+  private:
+    std::string_view m_key;
+  };
 
   /**
    * @brief  Light weight wrapper for a json2cppJson array value.
@@ -128,7 +179,7 @@ namespace adapters {
      */
     static const json2cpp::json &emptyArray()
     {
-      static const json2cpp::json array = json2cpp::json::array();
+      static constexpr json2cpp::json array{ json2cpp::array_t{} };
       return array;
     }
 
@@ -209,7 +260,7 @@ namespace adapters {
      */
     static const json2cpp::json &emptyObject()
     {
-      static const json2cpp::json object = json2cpp::json::object();
+      static constexpr json2cpp::json object{ json2cpp::object_t{} };
       return object;
     }
 
@@ -219,11 +270,12 @@ namespace adapters {
 
 
   /**
-   * @brief   Stores an independent copy of a json2cppJson value.
+   * @brief   Refers to a json2cppJson value on behalf of valijson.
    *
-   * This class allows a json2cppJson value to be stored independent of its original
-   * document. json2cppJson makes this easy to do, as it does not perform any
-   * custom memory management.
+   * Compiled documents are immutable and live for the whole program, so the
+   * frozen value only keeps a pointer to the original value. Instances are
+   * allocated from json2cppJsonFrozenValuePool, which makes freeze() and
+   * clone() free of heap allocations once the pool is warm.
    *
    * @see FrozenValue
    */
@@ -231,19 +283,105 @@ namespace adapters {
   {
   public:
     /**
-     * @brief  Make a copy of a json2cppJson value
+     * @brief  Refer to a json2cppJson value
      *
-     * @param  source  the json2cppJson value to be copied
+     * @param  source  the json2cppJson value, which must outlive the frozen value
      */
-    explicit json2cppJsonFrozenValue(json2cpp::json source) : m_value(std::move(source)) {}
+    explicit json2cppJsonFrozenValue(const json2cpp::json &source) : m_value(&source) {}
 
-    FrozenValue *clone() const override { return new json2cppJsonFrozenValue(m_value); }
+    FrozenValue *clone() const override { return new json2cppJsonFrozenValue(*m_value); }
 
     bool equalTo(const Adapter &other, bool strict) const override;
 
+    static void *operator new(std::size_t size);
+
+    static void operator delete(void *ptr, std::size_t size) noexcept;
+
+  private:
+    /// Referenced json2cppJson value
+    const json2cpp::json *m_value;
+  };
+
+
+  /**
+   * @brief   Free list of the blocks json2cppJsonFrozenValue instances live in.
+   *
+   * Blocks are carved from chunks of blocks_per_chunk that are never given
+   * back to the system, so the heap is only reached when a thread holds more
+   * frozen values than ever before. Each thread keeps its own free list; a
+   * block released on another thread simply joins that thread's list.
+   */
+  class json2cppJsonFrozenValuePool
+  {
+  public:
+    static constexpr size_t blocks_per_chunk = 256;
+
+    static void *allocate()
+    {
+      auto &state = threadState();
+      ++state.allocations;
+      if (state.free_list == nullptr) {
+        ++state.chunks;
+        auto *chunk = newChunk();
+        for (size_t i = blocks_per_chunk; i-- > 0;) {
+          chunk[i].next = state.free_list;
+          state.free_list = &chunk[i];
+        }
+      }
+      auto *result = state.free_list;
+      state.free_list = result->next;
+      return result;
+    }
+
+    static void release(void *ptr) noexcept
+    {
+      auto &state = threadState();
+      auto *released = static_cast<block *>(ptr);
+      released->next = state.free_list;
+      state.free_list = released;
+    }
+
+    /// Blocks handed out on this thread, i.e. the allocations a heap-backed frozen value would have made.
+    static size_t allocations() noexcept { return threadState().allocations; }
+
+    /// Chunks this thread took from the heap.
+    static size_t chunks() noexcept { return threadState().chunks; }
+
   private:
-    /// Stored json2cppJson value
-    json2cpp::json m_value;
+    union block {
+      block *next;
+      alignas(json2cppJsonFrozenValue) unsigned char storage[sizeof(json2cppJsonFrozenValue)];
+    };
+
+    struct thread_state
+    {
+      block *free_list = nullptr;
+      size_t allocations = 0;
+      size_t chunks = 0;
+    };
+
+    static thread_state &threadState() noexcept
+    {
+      thread_local thread_state state;
+      return state;
+    }
+
+    // Chunks stay reachable, and alive, until exit: frozen values owned by static schemas may be deleted late.
+    static block *newChunk()
+    {
+      struct chunk_list
+      {
+        std::mutex mutex;
+        std::vector<std::unique_ptr<block[]>> chunks;
+      };
+      static auto *const list = new chunk_list;
+
+      auto chunk = std::make_unique<block[]>(blocks_per_chunk);
+      auto *result = chunk.get();
+      const std::lock_guard<std::mutex> lock(list->mutex);
+      list->chunks.push_back(std::move(chunk));
+      return result;
+    }
   };
 
 
@@ -383,10 +521,17 @@ namespace adapters {
       return false;
     }
 
+    /**
+     * @brief   Copy a string value, decompressing it if needed.
+     *
+     * valijson only reads strings through a std::string, so this is the one
+     * accessor that copies.
+     */
     bool getString(std::string &result) const
     {
       if (m_value.is_string()) {
-        result = m_value.get<std::string_view>();
+        result.resize(m_value.size());
+        m_value.decompress_to(result.data());
         return true;
       }
 
@@ -415,7 +560,7 @@ namespace adapters {
     /// Return a reference to an empty object singleton
     static const json2cpp::json &emptyObject()
     {
-      static const json2cpp::json object = json2cpp::json::object();
+      static constexpr json2cpp::json object{ json2cpp::object_t{} };
       return object;
     }
 
@@ -447,6 +592,16 @@ namespace adapters {
     explicit json2cppJsonAdapter(const json2cpp::json &value) : BasicAdapter(json2cppJsonValue{ value }) {}
   };
 
+  /**
+   * @brief   Key and value of an object member, as BasicAdapter expects from a
+   *          std::pair, without owning a copy of the key.
+   */
+  struct json2cppJsonObjectMember
+  {
+    json2cppJsonObjectKey first;
+    json2cppJsonAdapter second;
+  };
+
   /**
    * @brief   Class for iterating over values held in a JSON array.
    *
@@ -466,12 +621,12 @@ namespace adapters {
     using reference = json2cppJsonAdapter &;
 
     /**
-     * @brief   Construct a new json2cppJsonArrayValueIterator using an existing
-     *          json2cppJson iterator.
+     * @brief   Construct a new json2cppJsonArrayValueIterator pointing at an
+     *          element of a json2cppJson array.
      *
-     * @param   itr  json2cppJson iterator to store
+     * @param   itr  pointer to the element
      */
-    explicit json2cppJsonArrayValueIterator(const json2cpp::json::const_iterator &itr) : m_itr(itr) {}
+    explicit json2cppJsonArrayValueIterator(const json2cpp::json *itr) : m_itr(itr) {}
 
     /// Returns a json2cppJsonAdapter that contains the value of the current
     /// element.
@@ -522,7 +677,7 @@ namespace adapters {
     void advance(std::ptrdiff_t n) { m_itr += n; }
 
   private:
-    json2cpp::json::const_iterator m_itr;
+    const json2cpp::json *m_itr;
   };
 
 
@@ -539,24 +694,29 @@ namespace adapters {
   class json2cppJsonObjectMemberIterator
   {
   public:
-    using iterator_category = std::bidirectional_iterator_tag;
+    using iterator_category = std::forward_iterator_tag;
     using value_type = json2cppJsonObjectMember;
     using difference_type = json2cppJsonObjectMember;
     using pointer = json2cppJsonObjectMember *;
     using reference = json2cppJsonObjectMember &;
 
     /**
-     * @brief   Construct an iterator from a json2cppJson iterator.
+     * @brief   Construct an iterator from a json2cppJson items iterator.
      *
-     * @param   itr  json2cppJson iterator to store
+     * @param   itr  json2cppJson items iterator to store
      */
-    explicit json2cppJsonObjectMemberIterator(const json2cpp::json::const_iterator &itr) : m_itr(itr) {}
+    explicit json2cppJsonObjectMemberIterator(const json2cpp::items_t::iterator &itr) : m_itr(itr) {}
 
     /**
      * @brief   Returns a json2cppJsonObjectMember that contains the key and value
      *          belonging to the object member identified by the iterator.
      */
-    json2cppJsonObjectMember operator*() const { return json2cppJsonObjectMember(m_itr.key(), m_itr.value()); }
+    json2cppJsonObjectMember operator*() const
+    {
+      const auto member = *m_itr;
+      return json2cppJsonObjectMember{ json2cppJsonObjectKey{ member.first.getString() },
+        json2cppJsonAdapter{ member.second } };
+    }
 
     DerefProxy<json2cppJsonObjectMember> operator->() const { return DerefProxy<json2cppJsonObjectMember>(**this); }
 
@@ -591,17 +751,9 @@ namespace adapters {
       return iterator_pre;
     }
 
-    // cppcheck-suppress functionConst
-    const json2cppJsonObjectMemberIterator &operator--()
-    {
-      --m_itr;
-
-      return *this;
-    }
-
   private:
     /// Iternal copy of the original json2cppJson iterator
-    json2cpp::json::const_iterator m_itr;
+    json2cpp::items_t::iterator m_itr;
   };
 
   /// Specialisation of the AdapterTraits template struct for json2cppJsonAdapter.
@@ -614,7 +766,24 @@ namespace adapters {
 
   inline bool json2cppJsonFrozenValue::equalTo(const Adapter &other, bool strict) const
   {
-    return json2cppJsonAdapter(m_value).equalTo(other, strict);
+    return json2cppJsonAdapter(*m_value).equalTo(other, strict);
+  }
+
+  // Classes deriving from json2cppJsonFrozenValue have a different size and go to the global heap.
+  inline void *json2cppJsonFrozenValue::operator new(std::size_t size)
+  {
+    if (size != sizeof(json2cppJsonFrozenValue)) { return ::operator new(size); }
+    return json2cppJsonFrozenValuePool::allocate();
+  }
+
+  inline void json2cppJsonFrozenValue::operator delete(void *ptr, std::size_t size) noexcept
+  {
+    if (ptr == nullptr) { return; }
+    if (size != sizeof(json2cppJsonFrozenValue)) {
+      ::operator delete(ptr);
+      return;
+    }
+    json2cppJsonFrozenValuePool::release(ptr);
   }
 
   inline json2cppJsonArrayValueIterator json2cppJsonArray::begin() const
@@ -629,17 +798,19 @@ namespace adapters {
 
   inline json2cppJsonObjectMemberIterator json2cppJsonObject::begin() const
   {
-    return json2cppJsonObjectMemberIterator{ m_value.begin() };
+    return json2cppJsonObjectMemberIterator{ m_value.items().begin() };
   }
 
   inline json2cppJsonObjectMemberIterator json2cppJsonObject::end() const
   {
-    return json2cppJsonObjectMemberIterator{ m_value.end() };
+    return json2cppJsonObjectMemberIterator{ m_value.items().end() };
   }
 
   inline json2cppJsonObjectMemberIterator json2cppJsonObject::find(const std::string_view propertyName) const
   {
-    return json2cppJsonObjectMemberIterator{ m_value.find(propertyName) };
+    const auto items = m_value.items();
+    const auto entry = m_value.find_entry(propertyName);
+    return json2cppJsonObjectMemberIterator{ entry ? items.iterator_at(entry.first.index) : items.end() };
   }
 
 }// namespace adapters
@@ -0,0 +1,303 @@
+/*
+MIT License
+
+Copyright (c) 2026 Jason Turner, Regis Duflaut-Averty
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef JSON2CPP_DUMP_HPP_INCLUDED
+#define JSON2CPP_DUMP_HPP_INCLUDED
+
+// Minified JSON text of compiled values. Strings keep their UTF-8 or UTF-16 text and escape quotes, backslashes and
+// control characters as nlohmann::json::dump() does; floats take their shortest round-trip form and keep a ".0"
+// when integral. Subtrees whose text the generator precomputed (--precompute-text) are copied in one piece.
+
+#include <json2cpp/json2cpp.hpp>
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace json2cpp {
+
+// Minified text of the subtree at a JSON pointer, emitted by the generator.
+template<typename CharType> struct basic_precomputed_text_t
+{
+  std::basic_string_view<CharType> pointer;
+  std::basic_string_view<CharType> text;
+};
+
+namespace detail {
+  // Shortest round-trip text of a number; the generator writes precomputed texts with the same functions.
+  inline std::string_view format_number(double value, std::array<char, 32> &buffer) noexcept
+  {
+    if (!std::isfinite(value)) return "null";
+    const auto end = std::to_chars(buffer.data(), buffer.data() + buffer.size() - 2, value).ptr;
+    std::string_view text(buffer.data(), static_cast<size_t>(end - buffer.data()));
+    if (text.find_first_of(".e") == std::string_view::npos) {
+      buffer[text.size()] = '.';
+      buffer[text.size() + 1] = '0';
+      text = std::string_view(buffer.data(), text.size() + 2);
+    }
+    return text;
+  }
+
+  template<typename Integer> std::string_view format_number(Integer value, std::array<char, 32> &buffer) noexcept
+  {
+    const auto end = std::to_chars(buffer.data(), buffer.data() + buffer.size(), value).ptr;
+    return { buffer.data(), static_cast<size_t>(end - buffer.data()) };
+  }
+
+  template<typename CharType> void append_ascii(std::basic_string<CharType> &out, std::string_view text)
+  {
+    out.append(text.begin(), text.end());
+  }
+
+  template<typename CharType> [[nodiscard]] constexpr bool needs_escape(CharType c) noexcept
+  {
+    return static_cast<std::make_unsigned_t<CharType>>(c) < 0x20u || c == CharType('"') || c == CharType('\\');
+  }
+
+  // Whether any of the code units packed in word needs escaping, testing all of them at once (SWAR): a lane below
+  // 0x20, or equal to '"' or '\\' once xored, borrows into its top bit.
+  template<typename CharType> [[nodiscard]] constexpr bool word_needs_escape(uint64_t word) noexcept
+  {
+    static_assert(sizeof(CharType) == 1 || sizeof(CharType) == 2);
+    constexpr uint64_t ones = sizeof(CharType) == 1 ? 0x0101010101010101ull : 0x0001000100010001ull;
+    constexpr uint64_t high = ones << (8u * sizeof(CharType) - 1u);
+    const auto below = [&](uint64_t value, uint64_t limit) { return (value - ones * limit) & ~value & high; };
+    return (below(word, 0x20u) | below(word ^ (ones * '"'), 1u) | below(word ^ (ones * '\\'), 1u)) != 0;
+  }
+
+  template<typename CharType>
+  void append_escaped(std::basic_string<CharType> &out, std::basic_string_view<CharType> text)
+  {
+    constexpr size_t lanes = sizeof(uint64_t) / sizeof(CharType);
+    out.push_back(CharType('"'));
+    size_t run = 0;
+    for (size_t i = 0; i < text.size();) {
+      if (i + lanes <= text.size()) {
+        uint64_t word = 0;
+        std::memcpy(&word, text.data() + i, sizeof(word));
+        if (!word_needs_escape<CharType>(word)) {
+          i += lanes;
+          continue;
+        }
+      }
+      const auto c = text[i];
+      if (!needs_escape(c)) {
+        ++i;
+        continue;
+      }
+      out.append(text.data() + run, i - run);
+      out.push_back(CharType('\\'));
+      switch (c) {
+      case CharType('"'):
+      case CharType('\\'):
+        out.push_back(c);
+        break;
+      case CharType('\b'):
+        out.push_back(CharType('b'));
+        break;
+      case CharType('\f'):
+        out.push_back(CharType('f'));
+        break;
+      case CharType('\n'):
+        out.push_back(CharType('n'));
+        break;
+      case CharType('\r'):
+        out.push_back(CharType('r'));
+        break;
+      case CharType('\t'):
+        out.push_back(CharType('t'));
+        break;
+      default: {
+        constexpr std::string_view digits = "0123456789abcdef";
+        const auto code = static_cast<unsigned>(c);
+        append_ascii(out, "u00");
+        out.push_back(CharType(digits[code >> 4u]));
+        out.push_back(CharType(digits[code & 0xFu]));
+        break;
+      }
+      }
+      run = ++i;
+    }
+    out.append(text.data() + run, text.size() - run);
+    out.push_back(CharType('"'));
+  }
+}// namespace detail
+
+// Precomputed texts of one document, found by the node they were computed for.
+template<typename CharType> class basic_text_index
+{
+public:
+  basic_text_index() = default;
+
+  basic_text_index(const basic_json<CharType> &document, std::span<const basic_precomputed_text_t<CharType>> texts)
+  {
+    for (const auto &entry : texts) {
+      if (const auto *node = resolve(document, entry.pointer)) add(*node, entry.text);
+    }
+  }
+
+  // Arrays and objects are found by the storage they point to, shared by every copy of the node.
+  void add(const basic_json<CharType> &node, std::basic_string_view<CharType> text)
+  {
+    if (const auto *address = node.node_address()) texts_.insert_or_assign(address, text);
+  }
+
+  [[nodiscard]] const std::basic_string_view<CharType> *find(const basic_json<CharType> &node) const noexcept
+  {
+    if (texts_.empty()) return nullptr;
+    const auto found = texts_.find(node.node_address());
+    return found == texts_.end() ? nullptr : &found->second;
+  }
+
+  [[nodiscard]] size_t size() const noexcept { return texts_.size(); }
+
+private:
+  static const basic_json<CharType> *resolve(const basic_json<CharType> &document,
+    std::basic_string_view<CharType> pointer)
+  {
+    const auto *node = &document;
+    while (!pointer.empty()) {
+      if (pointer.front() != CharType('/')) return nullptr;
+      pointer.remove_prefix(1);
+      const auto end = std::min(pointer.find(CharType('/')), pointer.size());
+      std::basic_string<CharType> token;
+      for (size_t i = 0; i < end; ++i) {
+        const bool escaped = pointer[i] == CharType('~') && i + 1 < end
+                             && (pointer[i + 1] == CharType('0') || pointer[i + 1] == CharType('1'));
+        if (escaped) {
+          token.push_back(pointer[++i] == CharType('0') ? CharType('~') : CharType('/'));
+        } else {
+          token.push_back(pointer[i]);
+        }
+      }
+      pointer.remove_prefix(end);
+
+      if (node->is_array()) {
+        size_t index = 0;
+        for (const auto c : token) { index = index * 10 + static_cast<size_t>(c - CharType('0')); }
+        if (index >= node->size()) return nullptr;
+        node = &node->at(index);
+      } else if (node->is_object() && node->contains(token)) {
+        node = &node->at(std::basic_string_view<CharType>(token));
+      } else {
+        return nullptr;
+      }
+    }
+    return node;
+  }
+
+  std::unordered_map<const void *, std::basic_string_view<CharType>> texts_;
+};
+
+// Appends the minified text of value to out.
+template<typename CharType>
+void dump_to(const basic_json<CharType> &value,
+  std::basic_string<CharType> &out,
+  const basic_text_index<CharType> *texts = nullptr)
+{
+  using Type = typename basic_json<CharType>::Type;
+  std::array<char, 32> buffer{};
+  switch (value.type()) {
+  case Type::Null:
+    detail::append_ascii(out, "null");
+    return;
+  case Type::Boolean:
+    detail::append_ascii(out, value.template get<bool>() ? "true" : "false");
+    return;
+  case Type::Integer:
+    detail::append_ascii(out, detail::format_number(value.template get<int64_t>(), buffer));
+    return;
+  case Type::UInteger:
+    detail::append_ascii(out, detail::format_number(value.template get<uint64_t>(), buffer));
+    return;
+  case Type::Float:
+    detail::append_ascii(out, detail::format_number(value.getNumber(), buffer));
+    return;
+  case Type::String:
+    if (value.is_compressed_string()) {
+      std::basic_string<CharType> text(value.size(), CharType{});
+      value.decompress_to(text.data());
+      detail::append_escaped(out, std::basic_string_view<CharType>(text));
+    } else {
+      detail::append_escaped(out, value.getString());
+    }
+    return;
+  case Type::Array:
+  case Type::Object:
+    break;
+  }
+
+  if (texts != nullptr) {
+    if (const auto *text = texts->find(value)) {
+      out.append(*text);
+      return;
+    }
+  }
+
+  if (value.is_array()) {
+    out.push_back(CharType('['));
+    bool first = true;
+    for (const auto &element : value) {
+      if (!first) out.push_back(CharType(','));
+      first = false;
+      dump_to(element, out, texts);
+    }
+    out.push_back(CharType(']'));
+    return;
+  }
+
+  out.push_back(CharType('{'));
+  bool first = true;
+  for (const auto &[key, member] : value.items()) {
+    if (!first) out.push_back(CharType(','));
+    first = false;
+    detail::append_escaped(out, key.getString());
+    out.push_back(CharType(':'));
+    dump_to(member, out, texts);
+  }
+  out.push_back(CharType('}'));
+}
+
+template<typename CharType>
+[[nodiscard]] std::basic_string<CharType> dump(const basic_json<CharType> &value,
+  const basic_text_index<CharType> *texts = nullptr)
+{
+  std::basic_string<CharType> out;
+  dump_to(value, out, texts);
+  return out;
+}
+
+using precomputed_text_t = basic_precomputed_text_t<basicType>;
+using text_index = basic_text_index<basicType>;
+
+}// namespace json2cpp
+
+#endif
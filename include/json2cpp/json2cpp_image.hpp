@@ -0,0 +1,302 @@
+/*
+MIT License
+
+Copyright (c) 2026 Jason Turner, Regis Duflaut-Averty
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef JSON2CPP_IMAGE_HPP_INCLUDED
+#define JSON2CPP_IMAGE_HPP_INCLUDED
+
+// Documents loaded at runtime from an image written by json2cpp --image. The image holds the basic_json nodes
+// exactly as they are laid out in memory, with image offsets in place of pointers. Loading maps the file privately,
+// adds the mapping address to every pointer listed in its relocation table, checks that every node reached from the
+// root lies in the mapping, and then makes it read-only. Nodes come before strings in the file, so only node pages are
+// copied on write; string pages are read from the file on demand. Objects are always in the regular layout.
+
+#include <json2cpp/json2cpp.hpp>
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace json2cpp {
+
+namespace detail {
+  inline constexpr std::array<char, 8> image_magic{ 'J', '2', 'C', 'I', 'M', 'A', 'G', 'E' };
+  // Bumped whenever the header or the node layout changes; older images are refused.
+  inline constexpr uint32_t image_version = 1;
+
+  // Start of every image. Offsets are from the start of the file; the relocation table is an array of
+  // relocation_count uint64_t offsets of pointer-sized slots, each holding the offset it points to.
+  struct image_header_t
+  {
+    std::array<char, 8> magic;
+    uint32_t version;
+    uint32_t char_size;
+    uint32_t node_size;
+    uint32_t little_endian;
+    uint64_t file_size;
+    uint64_t root;
+    uint64_t relocations;
+    uint64_t relocation_count;
+  };
+
+  // Node layout the images rely on: the length and metadata words, then the pointer or inline value.
+  inline constexpr size_t image_node_size = 16;
+  inline constexpr size_t image_node_alignment = 8;
+  inline constexpr size_t image_metadata_offset = 4;
+  inline constexpr size_t image_payload_offset = 8;
+
+  template<typename CharType> constexpr void check_image_layout() noexcept
+  {
+    static_assert(sizeof(basic_json<CharType>) == image_node_size
+                  && alignof(basic_json<CharType>) == image_node_alignment);
+    static_assert(sizeof(basic_value_pair_t<CharType>) == 2 * image_node_size);
+    static_assert(std::is_trivially_copyable_v<basic_json<CharType>>);
+    static_assert(sizeof(void *) == sizeof(uint64_t), "images store 64-bit pointers");
+  }
+}// namespace detail
+
+template<typename CharType> class basic_image
+{
+public:
+  explicit basic_image(const std::filesystem::path &filename)
+  {
+    detail::check_image_layout<CharType>();
+    map(filename);
+    try {
+      relocate();
+    } catch (...) {
+      unmap();
+      throw;
+    }
+  }
+
+  basic_image(basic_image &&other) noexcept
+    : data_(std::exchange(other.data_, nullptr)), size_(std::exchange(other.size_, 0)), root_(other.root_),
+      filename_(std::move(other.filename_))
+  {}
+
+  basic_image &operator=(basic_image &&other) noexcept
+  {
+    if (this != &other) {
+      unmap();
+      data_ = std::exchange(other.data_, nullptr);
+      size_ = std::exchange(other.size_, 0);
+      root_ = other.root_;
+      filename_ = std::move(other.filename_);
+    }
+    return *this;
+  }
+
+  basic_image(const basic_image &) = delete;
+  basic_image &operator=(const basic_image &) = delete;
+
+  ~basic_image() { unmap(); }
+
+  // Valid as long as the image is; every value and string reached from it points into the mapping.
+  [[nodiscard]] const basic_json<CharType> &root() const noexcept { return *root_; }
+
+  [[nodiscard]] size_t size_bytes() const noexcept { return size_; }
+
+private:
+  [[noreturn]] static void fail(const std::filesystem::path &filename, const char *what)
+  {
+    throw std::runtime_error("json2cpp image '" + filename.string() + "': " + what);
+  }
+
+  void map(const std::filesystem::path &filename)
+  {
+#ifdef _WIN32
+    const HANDLE file = CreateFileW(
+      filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) fail(filename, "cannot be opened");
+    LARGE_INTEGER file_size{};
+    if (!GetFileSizeEx(file, &file_size)
+        || file_size.QuadPart < static_cast<LONGLONG>(sizeof(detail::image_header_t))) {
+      CloseHandle(file);
+      fail(filename, "is too small");
+    }
+    const HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+    CloseHandle(file);
+    if (mapping == nullptr) fail(filename, "cannot be mapped");
+    data_ = static_cast<std::byte *>(MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0));
+    CloseHandle(mapping);
+    if (data_ == nullptr) fail(filename, "cannot be mapped");
+    size_ = static_cast<size_t>(file_size.QuadPart);
+#else
+    const int file = ::open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+    if (file < 0) fail(filename, "cannot be opened");
+    struct stat status{};
+    if (::fstat(file, &status) != 0 || status.st_size < static_cast<off_t>(sizeof(detail::image_header_t))) {
+      ::close(file);
+      fail(filename, "is too small");
+    }
+    size_ = static_cast<size_t>(status.st_size);
+    // Private and writable so that relocating copies the node pages instead of writing to the file.
+    void *data = ::mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_PRIVATE, file, 0);
+    ::close(file);
+    if (data == MAP_FAILED) fail(filename, "cannot be mapped");
+    data_ = static_cast<std::byte *>(data);
+#endif
+    filename_ = filename;
+  }
+
+  void relocate()
+  {
+    detail::image_header_t header{};
+    std::memcpy(&header, data_, sizeof(header));
+    if (header.magic != detail::image_magic) fail(filename_, "is not a json2cpp image");
+    if (header.version != detail::image_version) fail(filename_, "was written by another version of json2cpp");
+    if (header.char_size != sizeof(CharType)) fail(filename_, "holds strings of another character type");
+    const bool little_endian = std::endian::native == std::endian::little;
+    if (header.node_size != detail::image_node_size || (header.little_endian != 0) != little_endian) {
+      fail(filename_, "was written for another platform");
+    }
+    const auto fits = [&](uint64_t offset, uint64_t bytes) { return offset <= size_ && bytes <= size_ - offset; };
+    if (header.file_size != size_ || header.root % detail::image_node_alignment != 0
+        || !fits(header.root, detail::image_node_size)
+        || header.relocation_count > size_ / sizeof(uint64_t)
+        || !fits(header.relocations, header.relocation_count * sizeof(uint64_t))) {
+      fail(filename_, "is truncated or corrupt");
+    }
+
+    const auto base = reinterpret_cast<uint64_t>(data_);
+    for (uint64_t i = 0; i < header.relocation_count; ++i) {
+      uint64_t slot = 0;
+      std::memcpy(&slot, data_ + header.relocations + i * sizeof(uint64_t), sizeof(slot));
+      uint64_t target = 0;
+      if (!fits(slot, sizeof(target))) fail(filename_, "has a relocation outside the image");
+      std::memcpy(&target, data_ + slot, sizeof(target));
+      if (target >= size_) fail(filename_, "has a pointer outside the image");
+      target += base;
+      std::memcpy(data_ + slot, &target, sizeof(target));
+    }
+    root_ = reinterpret_cast<const basic_json<CharType> *>(data_ + header.root);
+    check_nodes();
+
+#ifdef _WIN32
+    DWORD previous = 0;
+    VirtualProtect(data_, size_, PAGE_READONLY, &previous);
+#else
+    ::mprotect(data_, size_, PROT_READ);
+#endif
+  }
+
+  // Relocated pointers lie in the image, but the lengths next to them are not checked yet: follows every array, object
+  // and long string from the root and checks that its elements, members or characters lie in the image too. Each node
+  // is checked once, however many arrays or objects share it.
+  void check_nodes() const
+  {
+    using node_type = basic_json<CharType>;
+    const auto base = reinterpret_cast<uint64_t>(data_);
+    // Aligned, and count elements of element_size from address lie in the image.
+    const auto within = [&](const void *address, uint64_t count, size_t element_size, size_t alignment) {
+      const auto offset = reinterpret_cast<uint64_t>(address) - base;
+      return offset % alignment == 0 && offset <= size_ && count <= (size_ - offset) / element_size;
+    };
+    std::vector<bool> checked(size_ / alignof(node_type));
+    std::vector<const node_type *> pending{ root_ };
+    const auto visit = [&](const node_type &node) {
+      const auto index = (reinterpret_cast<uint64_t>(&node) - base) / alignof(node_type);
+      if (!checked[index]) {
+        checked[index] = true;
+        pending.push_back(&node);
+      }
+    };
+    while (!pending.empty()) {
+      const node_type &node = *pending.back();
+      pending.pop_back();
+      uint32_t metadata = 0;
+      std::memcpy(
+        &metadata, reinterpret_cast<const std::byte *>(&node) + detail::image_metadata_offset, sizeof(metadata));
+      if (node.is_string()) {
+        // The writer never compresses strings, and a compressed one has no characters to check.
+        if ((metadata & node_type::compressed_string_mask) != 0) fail(filename_, "has a compressed string");
+        if (node.size() > sizeof(uint64_t) / sizeof(CharType)
+            && !within(node.getString().data(), node.size(), sizeof(CharType), alignof(CharType))) {
+          fail(filename_, "has a string outside the image");
+        }
+      } else if (node.is_array() && node.size() != 0) {
+        const auto *elements = static_cast<const node_type *>(node.node_address());
+        if (!within(elements, node.size(), sizeof(node_type), alignof(node_type))) {
+          fail(filename_, "has an array outside the image");
+        }
+        for (size_t i = 0; i < node.size(); ++i) visit(elements[i]);
+      } else if (node.is_object() && node.size() != 0) {
+        if ((metadata & (node_type::object_layout_mask | node_type::key_filter_mask)) != 0) {
+          fail(filename_, "has an object in a layout images do not use");
+        }
+        const auto *members = static_cast<const basic_value_pair_t<CharType> *>(node.node_address());
+        if (!within(members, node.size(), sizeof(basic_value_pair_t<CharType>), alignof(node_type))) {
+          fail(filename_, "has an object outside the image");
+        }
+        for (size_t i = 0; i < node.size(); ++i) {
+          if (!members[i].first.is_string()) fail(filename_, "has an object key that is not a string");
+          visit(members[i].first);
+          visit(members[i].second);
+        }
+      }
+    }
+  }
+
+  void unmap() noexcept
+  {
+    if (data_ == nullptr) return;
+#ifdef _WIN32
+    UnmapViewOfFile(data_);
+#else
+    ::munmap(data_, size_);
+#endif
+    data_ = nullptr;
+  }
+
+  std::byte *data_ = nullptr;
+  size_t size_ = 0;
+  const basic_json<CharType> *root_ = nullptr;
+  std::filesystem::path filename_;
+};
+
+using image = basic_image<basicType>;
+
+}// namespace json2cpp
+
+#endif
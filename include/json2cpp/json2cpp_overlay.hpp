@@ -0,0 +1,528 @@
+/*
+MIT License
+
+Copyright (c) 2026 Jason Turner, Regis Duflaut-Averty
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef JSON2CPP_OVERLAY_HPP_INCLUDED
+#define JSON2CPP_OVERLAY_HPP_INCLUDED
+
+// Copy-on-write overrides layered over a compiled document. Only the patched paths are stored, as a tree of small
+// hash maps; every other lookup is forwarded to the compiled data after one pointer check.
+
+#include <json2cpp/json2cpp.hpp>
+
+#include <algorithm>
+#include <concepts>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace json2cpp {
+
+namespace detail {
+  template<typename CharType> struct overlay_key_hash
+  {
+    using is_transparent = void;
+    [[nodiscard]] size_t operator()(std::basic_string_view<CharType> key) const noexcept
+    {
+      return std::hash<std::basic_string_view<CharType>>{}(key);
+    }
+  };
+
+  // The overrides at and below one node of the document.
+  template<typename CharType> struct overlay_patch
+  {
+    using member_map = std::unordered_map<std::basic_string<CharType>,
+      std::unique_ptr<overlay_patch>,
+      overlay_key_hash<CharType>,
+      std::equal_to<>>;
+
+    // Current value of the node: the compiled one, or its replacement.
+    const basic_json<CharType> *value = nullptr;
+    bool replaced = false;
+    // An object member removed from value.
+    bool erased = false;
+    // Members once the patches below are applied; arrays keep their size.
+    size_t size = 0;
+    member_map members;
+    // Members value does not have, in the order they were added.
+    std::vector<const typename member_map::value_type *> added;
+    std::unordered_map<size_t, std::unique_ptr<overlay_patch>> elements;
+
+    [[nodiscard]] bool has_children() const noexcept { return !members.empty() || !elements.empty(); }
+    [[nodiscard]] const overlay_patch *if_patched() const noexcept { return has_children() ? this : nullptr; }
+  };
+}// namespace detail
+
+template<typename CharType> class basic_overlay;
+template<typename CharType> struct basic_overlay_item_t;
+
+// A node seen through an overlay. Nodes without patches below them carry no patch and forward to the compiled node.
+template<typename CharType> class basic_overlay_value
+{
+public:
+  using json_type = basic_json<CharType>;
+  using patch_type = detail::overlay_patch<CharType>;
+
+  struct array_iterator
+  {
+    const json_type *node = nullptr;
+    const patch_type *patch = nullptr;
+    size_t index = 0;
+
+    using value_type = basic_overlay_value;
+    using difference_type = std::ptrdiff_t;
+    using iterator_concept = std::input_iterator_tag;
+
+    [[nodiscard]] value_type operator*() const { return basic_overlay_value(*node, patch).at(index); }
+    array_iterator &operator++() noexcept
+    {
+      ++index;
+      return *this;
+    }
+    void operator++(int) noexcept { ++index; }
+    bool operator==(const array_iterator &other) const noexcept { return index == other.index; }
+  };
+
+  class items_t
+  {
+  public:
+    using base_iterator = typename basic_items_t<CharType>::iterator;
+
+    struct iterator
+    {
+      base_iterator base;
+      base_iterator base_end;
+      const patch_type *patch = nullptr;
+      // Patch of the member base is on, if any.
+      const patch_type *member = nullptr;
+      size_t added = 0;
+
+      using value_type = basic_overlay_item_t<CharType>;
+      using difference_type = std::ptrdiff_t;
+      using iterator_concept = std::input_iterator_tag;
+
+      [[nodiscard]] value_type operator*() const
+      {
+        if (!(base == base_end)) {
+          const auto item = *base;
+          if (member == nullptr) return { item.first.getString(), basic_overlay_value(item.second, nullptr) };
+          return { item.first.getString(), basic_overlay_value(*member->value, member->if_patched()) };
+        }
+        const auto &entry = *patch->added[added];
+        return { entry.first, basic_overlay_value(*entry.second->value, entry.second->if_patched()) };
+      }
+
+      iterator &operator++()
+      {
+        if (base == base_end) {
+          ++added;
+        } else {
+          ++base;
+          settle();
+        }
+        return *this;
+      }
+      void operator++(int) { ++(*this); }
+
+      bool operator==(const iterator &other) const noexcept { return base == other.base && added == other.added; }
+
+      // Skips the erased members and finds the patch of the member base is on.
+      void settle()
+      {
+        member = nullptr;
+        if (patch == nullptr) return;
+        for (; !(base == base_end); ++base) {
+          const auto found = patch->members.find((*base).first.getString());
+          if (found == patch->members.end()) return;
+          if (!found->second->erased) {
+            member = found->second.get();
+            return;
+          }
+        }
+      }
+    };
+
+    items_t(const json_type &node, const patch_type *patch) : base_(node.items()), patch_(patch) {}
+
+    [[nodiscard]] iterator begin() const
+    {
+      iterator result{ base_.begin(), base_.end(), patch_, nullptr, 0 };
+      result.settle();
+      return result;
+    }
+    [[nodiscard]] iterator end() const
+    {
+      return { base_.end(), base_.end(), patch_, nullptr, patch_ == nullptr ? 0u : patch_->added.size() };
+    }
+
+  private:
+    basic_items_t<CharType> base_;
+    const patch_type *patch_;
+  };
+
+  basic_overlay_value(const json_type &node, const patch_type *patch) noexcept : node_(&node), patch_(patch) {}
+
+  // The compiled node, or the value that replaced it, without the patches below it.
+  [[nodiscard]] const json_type &node() const noexcept { return *node_; }
+  [[nodiscard]] bool patched() const noexcept { return patch_ != nullptr; }
+
+  [[nodiscard]] typename json_type::Type type() const noexcept { return node_->type(); }
+  [[nodiscard]] bool is_object() const noexcept { return node_->is_object(); }
+  [[nodiscard]] bool is_array() const noexcept { return node_->is_array(); }
+  [[nodiscard]] bool is_string() const noexcept { return node_->is_string(); }
+  [[nodiscard]] bool is_compressed_string() const noexcept { return node_->is_compressed_string(); }
+  [[nodiscard]] bool is_boolean() const noexcept { return node_->is_boolean(); }
+  [[nodiscard]] bool is_null() const noexcept { return node_->is_null(); }
+  [[nodiscard]] bool is_number() const noexcept { return node_->is_number(); }
+  [[nodiscard]] bool is_number_integer() const noexcept { return node_->is_number_integer(); }
+  [[nodiscard]] bool is_number_unsigned() const noexcept { return node_->is_number_unsigned(); }
+  [[nodiscard]] bool is_number_float() const noexcept { return node_->is_number_float(); }
+
+  [[nodiscard]] size_t size() const noexcept { return patch_ == nullptr ? node_->size() : patch_->size; }
+  [[nodiscard]] bool empty() const noexcept { return size() == 0; }
+
+  [[nodiscard]] std::basic_string_view<CharType> getString() const { return node_->getString(); }
+  [[nodiscard]] double getNumber() const { return node_->getNumber(); }
+  template<typename T> [[nodiscard]] T get() const { return node_->template get<T>(); }
+
+  template<size_t N> [[nodiscard]] basic_overlay_value at(const CharType (&key)[N]) const
+  {
+    if (patch_ == nullptr) [[likely]]
+      return { node_->at(key), nullptr };
+    return patched_member(std::basic_string_view<CharType>(key, N - 1));
+  }
+
+  [[nodiscard]] basic_overlay_value at(std::basic_string_view<CharType> key) const
+  {
+    if (patch_ == nullptr) [[likely]]
+      return { node_->at(key), nullptr };
+    return patched_member(key);
+  }
+
+  [[nodiscard]] basic_overlay_value at(std::integral auto index) const
+  {
+    if (patch_ == nullptr) [[likely]]
+      return { node_->at(index), nullptr };
+    return patched_element(static_cast<size_t>(index));
+  }
+
+  template<size_t N> [[nodiscard]] basic_overlay_value operator[](const CharType (&key)[N]) const { return at(key); }
+  [[nodiscard]] basic_overlay_value operator[](std::basic_string_view<CharType> key) const { return at(key); }
+  [[nodiscard]] basic_overlay_value operator[](std::integral auto index) const { return at(index); }
+
+  [[nodiscard]] bool contains(std::basic_string_view<CharType> key) const
+  {
+    if (patch_ == nullptr) [[likely]]
+      return node_->contains(key);
+    if (const auto found = patch_->members.find(key); found != patch_->members.end()) return !found->second->erased;
+    return node_->contains(key);
+  }
+
+  [[nodiscard]] items_t items() const { return { *node_, patch_ }; }
+
+  [[nodiscard]] array_iterator begin() const noexcept { return { node_, patch_, 0 }; }
+  [[nodiscard]] array_iterator end() const noexcept { return { node_, patch_, is_array() ? size() : 0u }; }
+
+private:
+  inline static constexpr json_type null_node{ nullptr };
+
+  [[nodiscard]] basic_overlay_value patched_member(std::basic_string_view<CharType> key) const
+  {
+    const auto found = patch_->members.find(key);
+    if (found == patch_->members.end()) return { node_->at(key), nullptr };
+    if (found->second->erased) [[unlikely]] {
+      detail::throw_exception<std::out_of_range>("Key not found");
+      return { null_node, nullptr };
+    }
+    return { *found->second->value, found->second->if_patched() };
+  }
+
+  [[nodiscard]] basic_overlay_value patched_element(size_t index) const
+  {
+    if (node_->is_object()) {
+      // Members by position, added ones last, as items() visits them.
+      if (index < patch_->size) {
+        auto current = items().begin();
+        for (size_t i = 0; i < index; ++i) { ++current; }
+        return (*current).second;
+      }
+      detail::throw_exception<std::out_of_range>("Index out of range");
+      return { null_node, nullptr };
+    }
+    const auto found = patch_->elements.find(index);
+    if (found == patch_->elements.end()) return { node_->at(index), nullptr };
+    return { *found->second->value, found->second->if_patched() };
+  }
+
+  const json_type *node_;
+  const patch_type *patch_;
+};
+
+template<typename CharType> struct basic_overlay_item_t
+{
+  std::basic_string_view<CharType> first;
+  basic_overlay_value<CharType> second;
+};
+
+// Overrides set at JSON pointers over a compiled document, which stays untouched. Reads may run concurrently with
+// each other but not with set(), erase() or clear(). Values passed to set() are copied, strings included; the
+// arrays and objects they hold are referenced, so they must outlive the overlay, as compiled documents do.
+template<typename CharType> class basic_overlay
+{
+public:
+  using json_type = basic_json<CharType>;
+  using value_type = basic_overlay_value<CharType>;
+  using string_type = std::basic_string<CharType>;
+  using string_view_type = std::basic_string_view<CharType>;
+
+  explicit basic_overlay(const json_type &base) : base_(&base) { reset_root(); }
+
+  basic_overlay(const basic_overlay &) = delete;
+  basic_overlay &operator=(const basic_overlay &) = delete;
+
+  [[nodiscard]] const json_type &base() const noexcept { return *base_; }
+  [[nodiscard]] value_type root() const noexcept { return { *root_.value, root_.if_patched() }; }
+  [[nodiscard]] bool empty() const noexcept { return !root_.replaced && !root_.has_children(); }
+
+  // The node at a JSON pointer (RFC 6901), patches applied.
+  [[nodiscard]] value_type at(string_view_type pointer) const
+  {
+    auto current = root();
+    for (const auto &token : split(pointer)) {
+      current = current.is_array() ? current.at(parse_index(token)) : current.at(string_view_type(token));
+    }
+    return current;
+  }
+
+  // Replaces the value at pointer, or adds it to the parent object. Array elements can be replaced, not added.
+  void set(string_view_type pointer, const json_type &value)
+  {
+    const auto tokens = split(pointer);
+    if (tokens.empty()) {
+      replace(root_, store(value));
+      return;
+    }
+
+    auto &parent = *resolve_path(tokens).back();
+    const auto &token = tokens.back();
+    if (parent.value->is_array()) {
+      const auto index = parse_index(token);
+      if (index >= parent.size) throw std::out_of_range("Index out of range");
+      auto &element = parent.elements[index];
+      if (!element) element = std::make_unique<patch_type>();
+      replace(*element, store(value));
+      return;
+    }
+
+    const auto *stored = store(value);
+
+    auto [found, inserted] = parent.members.try_emplace(token);
+    if (inserted) {
+      found->second = std::make_unique<patch_type>();
+      if (!parent.value->contains(string_view_type(token))) {
+        parent.added.push_back(&*found);
+        ++parent.size;
+      }
+    } else if (found->second->erased) {
+      ++parent.size;
+    }
+    replace(*found->second, stored);
+  }
+
+  // Removes an object member.
+  void erase(string_view_type pointer)
+  {
+    const auto tokens = split(pointer);
+    if (tokens.empty()) throw std::invalid_argument("The document root cannot be erased");
+    auto path = resolve_path(tokens);
+    auto &parent = *path.back();
+    if (!parent.value->is_object()) throw std::domain_error("Only object members can be erased");
+
+    const auto &key = tokens.back();
+    const auto found = parent.members.find(string_view_type(key));
+    if (found == parent.members.end()) {
+      if (!parent.value->contains(string_view_type(key))) throw std::out_of_range("Key not found");
+      auto erased = std::make_unique<patch_type>();
+      erased->erased = true;
+      parent.members.emplace(key, std::move(erased));
+    } else if (found->second->erased) {
+      throw std::out_of_range("Key not found");
+    } else if (const auto added = std::ranges::find(parent.added, &*found); added != parent.added.end()) {
+      parent.added.erase(added);
+      parent.members.erase(found);
+    } else {
+      *found->second = patch_type{};
+      found->second->erased = true;
+    }
+    --parent.size;
+    prune(path, tokens);
+  }
+
+  // Drops every patch.
+  void clear()
+  {
+    reset_root();
+    values_.clear();
+    strings_.clear();
+  }
+
+private:
+  using patch_type = detail::overlay_patch<CharType>;
+
+  void reset_root()
+  {
+    root_ = patch_type{};
+    root_.value = base_;
+    root_.size = base_->size();
+  }
+
+  [[nodiscard]] const json_type *store(const json_type &value)
+  {
+    if (value.is_string() && !value.is_compressed_string()) {
+      const auto &text = strings_.emplace_back(value.getString());
+      return &values_.emplace_back(string_view_type(text));
+    }
+    return &values_.emplace_back(value);
+  }
+
+  static void replace(patch_type &patch, const json_type *value)
+  {
+    patch = patch_type{};
+    patch.value = value;
+    patch.replaced = true;
+    patch.size = value->size();
+  }
+
+  static std::vector<string_type> split(string_view_type pointer)
+  {
+    std::vector<string_type> tokens;
+    if (pointer.empty()) return tokens;
+    if (pointer.front() != CharType('/')) throw std::invalid_argument("A JSON pointer must start with '/'");
+
+    for (size_t begin = 1;;) {
+      const auto end = std::min(pointer.find(CharType('/'), begin), pointer.size());
+      string_type token;
+      for (size_t i = begin; i < end; ++i) {
+        if (pointer[i] == CharType('~') && i + 1 < end && pointer[i + 1] == CharType('1')) {
+          token.push_back(CharType('/'));
+          ++i;
+        } else if (pointer[i] == CharType('~') && i + 1 < end && pointer[i + 1] == CharType('0')) {
+          token.push_back(CharType('~'));
+          ++i;
+        } else {
+          token.push_back(pointer[i]);
+        }
+      }
+      tokens.push_back(std::move(token));
+      if (end == pointer.size()) return tokens;
+      begin = end + 1;
+    }
+  }
+
+  static size_t parse_index(const string_type &token)
+  {
+    if (token.empty() || (token.size() > 1 && token.front() == CharType('0'))) {
+      throw std::invalid_argument("Invalid array index in JSON pointer");
+    }
+    size_t index = 0;
+    for (const auto c : token) {
+      if (c < CharType('0') || c > CharType('9')) throw std::invalid_argument("Invalid array index in JSON pointer");
+      index = index * 10 + static_cast<size_t>(c - CharType('0'));
+    }
+    return index;
+  }
+
+  // Patch of the child named by token, created from the current value of the child if needed.
+  static patch_type &child(patch_type &parent, const string_type &token)
+  {
+    if (parent.value->is_array()) {
+      const auto index = parse_index(token);
+      if (index >= parent.size) throw std::out_of_range("Index out of range");
+      auto &element = parent.elements[index];
+      if (!element) {
+        element = std::make_unique<patch_type>();
+        element->value = &parent.value->at(index);
+        element->size = element->value->size();
+      }
+      return *element;
+    }
+    if (!parent.value->is_object()) throw std::domain_error("JSON value is not an array or object");
+
+    const auto found = parent.members.find(string_view_type(token));
+    if (found != parent.members.end()) {
+      if (found->second->erased) throw std::out_of_range("Key not found");
+      return *found->second;
+    }
+    if (!parent.value->contains(string_view_type(token))) throw std::out_of_range("Key not found");
+    auto member = std::make_unique<patch_type>();
+    member->value = &parent.value->at(string_view_type(token));
+    member->size = member->value->size();
+    return *parent.members.emplace(token, std::move(member)).first->second;
+  }
+
+  // Patches from the root to the parent of the last token.
+  std::vector<patch_type *> resolve_path(const std::vector<string_type> &tokens)
+  {
+    std::vector<patch_type *> path{ &root_ };
+    for (size_t i = 0; i + 1 < tokens.size(); ++i) { path.push_back(&child(*path.back(), tokens[i])); }
+    if (!path.back()->value->is_object() && !path.back()->value->is_array()) {
+      throw std::domain_error("JSON value is not an array or object");
+    }
+    return path;
+  }
+
+  // Removes the patches left with nothing to apply, so untouched subtrees take the fast path again.
+  static void prune(const std::vector<patch_type *> &path, const std::vector<string_type> &tokens)
+  {
+    for (size_t i = path.size() - 1; i > 0; --i) {
+      const auto &patch = *path[i];
+      if (patch.replaced || patch.erased || patch.has_children()) return;
+      auto &parent = *path[i - 1];
+      if (parent.value->is_array()) {
+        parent.elements.erase(parse_index(tokens[i - 1]));
+      } else {
+        parent.members.erase(parent.members.find(string_view_type(tokens[i - 1])));
+      }
+    }
+  }
+
+  const json_type *base_;
+  patch_type root_;
+  // Replacement values and the strings they view; deques keep them in place as they grow.
+  std::deque<json_type> values_;
+  std::deque<string_type> strings_;
+};
+
+using overlay = basic_overlay<basicType>;
+using overlay_value = basic_overlay_value<basicType>;
+using overlay_item_t = basic_overlay_item_t<basicType>;
+
+}// namespace json2cpp
+
+#endif
@@ -0,0 +1,258 @@
+/*
+MIT License
+
+Copyright (c) 2026 Jason Turner, Regis Duflaut-Averty
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef JSON2CPP_REGISTRY_HPP_INCLUDED
+#define JSON2CPP_REGISTRY_HPP_INCLUDED
+
+// Hot-reloadable document images. The current image sits behind an atomic pointer, and a reload swaps it in one
+// store. Readers pin it without locking: a pin publishes the epoch it started in, in one of a fixed set of reader
+// slots. An old image is unmapped once no slot holds an epoch from before it was replaced.
+
+#include <json2cpp/json2cpp_image.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stop_token>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace json2cpp {
+
+template<typename CharType> class basic_document_registry
+{
+  struct version_t
+  {
+    basic_image<CharType> image;
+    uint64_t generation;
+  };
+
+  struct alignas(64) reader_slot_t
+  {
+    // Epoch the pinning reader started in; 0 while the slot is free.
+    std::atomic<uint64_t> epoch{ 0 };
+  };
+
+public:
+  // A pinned image: it stays mapped, and root() valid, until the pin is destroyed. Pins must not outlive the registry.
+  class pinned_document
+  {
+  public:
+    pinned_document(pinned_document &&other) noexcept
+      : slot_(std::exchange(other.slot_, nullptr)), version_(other.version_)
+    {}
+    pinned_document &operator=(pinned_document &&) = delete;
+    pinned_document(const pinned_document &) = delete;
+    pinned_document &operator=(const pinned_document &) = delete;
+
+    ~pinned_document()
+    {
+      if (slot_ != nullptr) slot_->epoch.store(0, std::memory_order_release);
+    }
+
+    [[nodiscard]] const basic_json<CharType> &root() const noexcept { return version_->image.root(); }
+    [[nodiscard]] const basic_json<CharType> *operator->() const noexcept { return &root(); }
+    // 1 for the image the registry was created with, incremented by every successful reload.
+    [[nodiscard]] uint64_t generation() const noexcept { return version_->generation; }
+
+  private:
+    friend class basic_document_registry;
+    pinned_document(reader_slot_t *slot, const version_t *version) noexcept : slot_(slot), version_(version) {}
+
+    reader_slot_t *slot_;
+    const version_t *version_;
+  };
+
+  // Loads filename; at most max_readers pins can be held at the same time, further pin() calls wait for a free slot.
+  explicit basic_document_registry(std::filesystem::path filename, size_t max_readers = 64)
+    : filename_(std::move(filename)), slots_(std::max<size_t>(max_readers, 1))
+  {
+    auto first = std::make_unique<version_t>(version_t{ basic_image<CharType>(filename_), 1 });
+    watched_ = file_state();
+    current_.store(first.release(), std::memory_order_release);
+  }
+
+  basic_document_registry(const basic_document_registry &) = delete;
+  basic_document_registry &operator=(const basic_document_registry &) = delete;
+
+  ~basic_document_registry()
+  {
+    stop_watching();
+    delete current_.load(std::memory_order_acquire);
+    for (auto &[epoch, version] : retired_) delete version;
+  }
+
+  [[nodiscard]] pinned_document pin() const noexcept
+  {
+    auto *slot = claim_slot();
+    return { slot, current_.load(std::memory_order_seq_cst) };
+  }
+
+  [[nodiscard]] uint64_t generation() const noexcept
+  {
+    return current_.load(std::memory_order_acquire)->generation;
+  }
+
+  // Maps the file again and swaps it in. A file that cannot be loaded (missing, truncated while being written...)
+  // throws and leaves the current image in place. Replace images by renaming a complete file over the old one:
+  // writing into a mapped file in place changes what readers see.
+  void reload()
+  {
+    std::lock_guard lock(writer_mutex_);
+    const auto state = file_state();
+    auto next = std::make_unique<version_t>(
+      version_t{ basic_image<CharType>(filename_), current_.load(std::memory_order_relaxed)->generation + 1 });
+    auto *previous = current_.exchange(next.release(), std::memory_order_seq_cst);
+    retired_.emplace_back(epoch_.fetch_add(1, std::memory_order_seq_cst), previous);
+    watched_ = state;
+    collect_locked();
+  }
+
+  // Unmaps the replaced images no reader can still see; returns how many are still pinned.
+  size_t collect()
+  {
+    std::lock_guard lock(writer_mutex_);
+    collect_locked();
+    return retired_.size();
+  }
+
+  // Polls the file's modification time and size every interval from a background thread, and reloads it when they
+  // change. Errors of a reload are passed to on_error and the change is tried again at the next poll.
+  void watch(std::chrono::milliseconds interval = std::chrono::milliseconds(500),
+    std::function<void(const std::exception &)> on_error = {})
+  {
+    stop_watching();
+    watcher_ = std::jthread([this, interval, on_error = std::move(on_error)](std::stop_token stop) {
+      std::mutex sleep_mutex;
+      std::condition_variable_any wake;
+      std::unique_lock sleep_lock(sleep_mutex);
+      while (!wake.wait_for(sleep_lock, stop, interval, [&stop] { return stop.stop_requested(); })) {
+        try {
+          if (changed()) reload();
+          collect();
+        } catch (const std::exception &e) {
+          if (on_error) on_error(e);
+        }
+      }
+    });
+  }
+
+  void stop_watching()
+  {
+    if (!watcher_.joinable()) return;
+    watcher_.request_stop();
+    watcher_.join();
+  }
+
+  [[nodiscard]] const std::filesystem::path &filename() const noexcept { return filename_; }
+
+private:
+  struct file_state_t
+  {
+    std::filesystem::file_time_type modified{};
+    std::uintmax_t size = 0;
+
+    bool operator==(const file_state_t &) const = default;
+  };
+
+  [[nodiscard]] file_state_t file_state() const
+  {
+    std::error_code time_error;
+    std::error_code size_error;
+    const file_state_t state{ std::filesystem::last_write_time(filename_, time_error),
+      std::filesystem::file_size(filename_, size_error) };
+    return time_error || size_error ? file_state_t{} : state;
+  }
+
+  [[nodiscard]] bool changed() const
+  {
+    const auto state = file_state();
+    std::lock_guard lock(writer_mutex_);
+    return state != file_state_t{} && state != watched_;
+  }
+
+  // Publishes the current epoch in a free slot. The epoch is read again after publishing: if a reload advanced it in
+  // between, its collection may have missed this slot, so the newer epoch is published instead.
+  reader_slot_t *claim_slot() const noexcept
+  {
+    const auto start = std::hash<std::thread::id>{}(std::this_thread::get_id());
+    for (;;) {
+      for (size_t i = 0; i < slots_.size(); ++i) {
+        auto &slot = slots_[(start + i) % slots_.size()];
+        auto epoch = epoch_.load(std::memory_order_seq_cst);
+        uint64_t free = 0;
+        if (!slot.epoch.compare_exchange_strong(free, epoch, std::memory_order_seq_cst)) continue;
+        for (auto current = epoch_.load(std::memory_order_seq_cst); current != epoch;
+             current = epoch_.load(std::memory_order_seq_cst)) {
+          epoch = current;
+          slot.epoch.store(epoch, std::memory_order_seq_cst);
+        }
+        return &slot;
+      }
+      std::this_thread::yield();
+    }
+  }
+
+  void collect_locked()
+  {
+    uint64_t oldest = UINT64_MAX;
+    for (const auto &slot : slots_) {
+      const auto epoch = slot.epoch.load(std::memory_order_seq_cst);
+      if (epoch != 0) oldest = std::min(oldest, epoch);
+    }
+    // An image retired at epoch E could only be loaded by pins published at E or before.
+    std::erase_if(retired_, [&](const auto &entry) {
+      if (entry.first < oldest) {
+        delete entry.second;
+        return true;
+      }
+      return false;
+    });
+  }
+
+  std::filesystem::path filename_;
+  std::atomic<const version_t *> current_{ nullptr };
+  // Starts at 1 so that 0 marks a free slot.
+  std::atomic<uint64_t> epoch_{ 1 };
+  mutable std::vector<reader_slot_t> slots_;
+  mutable std::mutex writer_mutex_;
+  std::vector<std::pair<uint64_t, const version_t *>> retired_;
+  file_state_t watched_;
+  std::jthread watcher_;
+};
+
+using document_registry = basic_document_registry<basicType>;
+
+}// namespace json2cpp
+
+#endif
@@ -0,0 +1,707 @@
+/*
+MIT License
+
+Copyright (c) 2026 Jason Turner, Regis Duflaut-Averty
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef JSON2CPP_SCHEMA_HPP_INCLUDED
+#define JSON2CPP_SCHEMA_HPP_INCLUDED
+
+#include <json2cpp/json2cpp.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Validation tables generated by `json2cpp --schema` from a JSON Schema document, and a validator walking a document
+// against them. The schema is never parsed at runtime and validation does not allocate.
+//
+// Supported keywords: type, enum, const, minimum, maximum, exclusiveMinimum, exclusiveMaximum (number or draft-04
+// boolean), multipleOf, minLength, maxLength, properties, patternProperties (".*" and "^.*\\S.*$" only),
+// additionalProperties, required, minProperties, maxProperties, items (single schema), minItems, maxItems, allOf,
+// anyOf, oneOf and not. The generator rejects schemas relying on other validation keywords.
+
+namespace json2cpp {
+
+namespace schema {
+  enum type_bits : uint8_t {
+    null_type = 1u << 0,
+    boolean_type = 1u << 1,
+    integer_type = 1u << 2,
+    // Numbers with a fractional part; "number" in a schema allows integer_type | number_type.
+    number_type = 1u << 3,
+    string_type = 1u << 4,
+    array_type = 1u << 5,
+    object_type = 1u << 6,
+  };
+  inline constexpr uint8_t any_type = 0x7fu;
+
+  enum node_flags : uint16_t {
+    has_minimum = 1u << 0,
+    has_maximum = 1u << 1,
+    exclusive_minimum = 1u << 2,
+    exclusive_maximum = 1u << 3,
+    has_multiple_of = 1u << 4,
+    has_enum = 1u << 5,
+  };
+
+  // Node index meaning "no subschema": anything is accepted.
+  inline constexpr uint32_t no_node = 0xFFFFFFFFu;
+  inline constexpr uint32_t unlimited = 0xFFFFFFFFu;
+  inline constexpr uint32_t max_required = 64;
+
+  enum class pattern_kind : uint8_t { any, non_blank };
+
+  struct pattern_property_t
+  {
+    pattern_kind kind = pattern_kind::any;
+    uint32_t node = no_node;
+  };
+
+  // Values of a node's property map: subschema index in the low half, required slot + 1 (0 if optional) in the high
+  // half. Required keys missing from "properties" map to no_node and fall through to the patterns.
+  [[nodiscard]] constexpr uint64_t pack_property(uint32_t node, uint32_t required_slot) noexcept
+  {
+    return (uint64_t{ required_slot } << 32u) | node;
+  }
+  [[nodiscard]] constexpr uint32_t property_node(uint64_t packed) noexcept { return static_cast<uint32_t>(packed); }
+  [[nodiscard]] constexpr uint32_t property_required_slot(uint64_t packed) noexcept
+  {
+    return static_cast<uint32_t>(packed >> 32u);
+  }
+
+  // First failure found, innermost first. reason is a static string.
+  struct error_t
+  {
+    std::string_view reason;
+    uint32_t node = no_node;
+  };
+
+  // How the validator reads a document value; specialize for other document types. The members are:
+  //   type(v)                          one of the type_bits
+  //   number(v)                        numeric value as a double
+  //   size(v)                          element or member count
+  //   string_length(v)                 length in code points
+  //   enum_contains(v, strings)        whether the string value is a key of the compiled object strings
+  //   enum_equals(v, value)            whether the non-numeric v equals the compiled value
+  //   for_each_element(v, f)           f(child) -> bool, stops at the first false
+  //   for_each_member(v, f)            f(key, hash, child) -> bool, stops at the first false, hash as calc_hash()
+  template<typename Value> struct value_traits;
+
+  template<typename CharType> [[nodiscard]] constexpr size_t code_point_count(std::basic_string_view<CharType> str)
+  {
+    size_t count = 0;
+    for (const auto unit : str) {
+      const auto value = static_cast<uint32_t>(static_cast<std::make_unsigned_t<CharType>>(unit));
+      if constexpr (sizeof(CharType) == 1) {
+        if ((value & 0xC0u) != 0x80u) ++count;
+      } else {
+        if (value < 0xDC00u || value > 0xDFFFu) ++count;
+      }
+    }
+    return count;
+  }
+
+  template<typename CharType> [[nodiscard]] constexpr bool matches(pattern_kind kind, std::basic_string_view<CharType> key)
+  {
+    if (kind == pattern_kind::any) return true;
+    for (const auto unit : key) {
+      if (unit != CharType(' ') && unit != CharType('\t') && unit != CharType('\n') && unit != CharType('\v')
+          && unit != CharType('\f') && unit != CharType('\r'))
+        return true;
+    }
+    return false;
+  }
+
+  // Equality as JSON Schema defines it for enum and const: numbers compare by value, so 1 equals 1.0, and objects
+  // match member by member whatever their order. basic_json::operator== compares types and member order instead.
+  template<typename CharType>
+  [[nodiscard]] constexpr bool instance_equals(const basic_json<CharType> &lhs, const basic_json<CharType> &rhs)
+  {
+    if (lhs.is_number() && rhs.is_number()) return lhs.template get<double>() == rhs.template get<double>();
+    if (lhs.is_array() && rhs.is_array()) {
+      if (lhs.size() != rhs.size()) return false;
+      for (size_t index = 0; index < lhs.size(); ++index) {
+        if (!instance_equals(lhs[index], rhs[index])) return false;
+      }
+      return true;
+    }
+    if (lhs.is_object() && rhs.is_object()) {
+      if (lhs.size() != rhs.size()) return false;
+      for (const auto &[key, child] : lhs.items()) {
+        const auto entry = rhs.find_entry(key.getString(), key.hash());
+        if (!entry || !instance_equals(child, *entry.second)) return false;
+      }
+      return true;
+    }
+    return lhs == rhs;
+  }
+
+  template<typename CharType> struct value_traits<basic_json<CharType>>
+  {
+    using value_type = basic_json<CharType>;
+
+    static uint8_t type(const value_type &value) noexcept
+    {
+      if (value.is_object()) return object_type;
+      if (value.is_array()) return array_type;
+      if (value.is_string()) return string_type;
+      if (value.is_number_integer()) return integer_type;
+      if (value.is_number_float()) return number_type;
+      if (value.is_boolean()) return boolean_type;
+      return null_type;
+    }
+
+    static double number(const value_type &value) { return value.template get<double>(); }
+
+    static size_t size(const value_type &value) noexcept { return value.size(); }
+
+    // Compressed strings have no view to count from, so they are decompressed, which is the one case that allocates.
+    static size_t string_length(const value_type &value)
+    {
+      if (!value.is_compressed_string()) return code_point_count(value.getString());
+      std::basic_string<CharType> text(value.size(), CharType{});
+      value.decompress_to(text.data());
+      return code_point_count(std::basic_string_view<CharType>{ text });
+    }
+
+    static bool enum_contains(const value_type &value, const basic_json<CharType> &strings)
+    {
+      if (!value.is_compressed_string()) return strings.contains(value.getString());
+      for (const auto &[key, unused] : strings.items()) {
+        if (value == key.getString()) return true;
+      }
+      return false;
+    }
+
+    static bool enum_equals(const value_type &value, const basic_json<CharType> &other)
+    {
+      return instance_equals(value, other);
+    }
+
+    template<typename Function> static bool for_each_element(const value_type &value, Function &&function)
+    {
+      for (const auto &child : value) {
+        if (!function(child)) return false;
+      }
+      return true;
+    }
+
+    template<typename Function> static bool for_each_member(const value_type &value, Function &&function)
+    {
+      for (const auto &[key, child] : value.items()) {
+        if (!function(key.getString(), key.hash(), child)) return false;
+      }
+      return true;
+    }
+  };
+
+  // A scalar read from an event stream, see basic_schema_stream_t. Strings are views valid for the call only.
+  template<typename CharType> struct scalar_t
+  {
+    uint8_t type = null_type;
+    bool boolean = false;
+    double number = 0.0;
+    std::basic_string_view<CharType> string{};
+  };
+
+  template<typename CharType> struct value_traits<scalar_t<CharType>>
+  {
+    using value_type = scalar_t<CharType>;
+
+    static uint8_t type(const value_type &value) noexcept { return value.type; }
+
+    static double number(const value_type &value) noexcept { return value.number; }
+
+    static size_t size(const value_type &) noexcept { return 0; }
+
+    static size_t string_length(const value_type &value) { return code_point_count(value.string); }
+
+    static bool enum_contains(const value_type &value, const basic_json<CharType> &strings)
+    {
+      return strings.contains(value.string);
+    }
+
+    static bool enum_equals(const value_type &value, const basic_json<CharType> &other) noexcept
+    {
+      if (value.type == null_type) return other.is_null();
+      return value.type == boolean_type && other.is_boolean() && other.template get<bool>() == value.boolean;
+    }
+
+    template<typename Function> static bool for_each_element(const value_type &, Function &&) noexcept { return true; }
+
+    template<typename Function> static bool for_each_member(const value_type &, Function &&) noexcept { return true; }
+  };
+}// namespace schema
+
+template<typename CharType> struct basic_schema_node_t
+{
+  uint8_t types = schema::any_type;
+  uint16_t flags = 0;
+  uint32_t required_count = 0;
+  double minimum = 0.0;
+  double maximum = 0.0;
+  double multiple_of = 0.0;
+  uint32_t min_length = 0;
+  uint32_t max_length = schema::unlimited;
+  uint32_t min_items = 0;
+  uint32_t max_items = schema::unlimited;
+  uint32_t min_properties = 0;
+  uint32_t max_properties = schema::unlimited;
+  // Object keyed by property name, see schema::pack_property.
+  const basic_json<CharType> *properties = nullptr;
+  std::span<const schema::pattern_property_t> pattern_properties{};
+  uint32_t additional_properties = schema::no_node;
+  uint32_t items = schema::no_node;
+  // String enum values as the keys of an object, the other ones as an array.
+  const basic_json<CharType> *enum_strings = nullptr;
+  const basic_json<CharType> *enum_values = nullptr;
+  std::span<const uint32_t> all_of{};
+  std::span<const uint32_t> any_of{};
+  std::span<const uint32_t> one_of{};
+  uint32_t not_node = schema::no_node;
+};
+
+template<typename CharType> struct basic_schema_t
+{
+  using node_type = basic_schema_node_t<CharType>;
+
+  std::span<const node_type> nodes;
+
+  template<typename Value> [[nodiscard]] bool validate(const Value &value) const
+  {
+    return validate_node(0, value, nullptr);
+  }
+
+  template<typename Value> [[nodiscard]] bool validate(const Value &value, schema::error_t &error) const
+  {
+    return validate_node(0, value, &error);
+  }
+
+  template<typename Value>
+  [[nodiscard]] bool validate_node(uint32_t index, const Value &value, schema::error_t *error) const
+  {
+    if (index == schema::no_node) return true;
+    using traits = schema::value_traits<Value>;
+    const auto &node = nodes[index];
+    const auto fail = [&](std::string_view reason) {
+      if (error != nullptr && error->node == schema::no_node) *error = { reason, index };
+      return false;
+    };
+
+    const auto type = traits::type(value);
+    if ((node.types & type) == 0) {
+      const bool integral_number = type == schema::number_type && (node.types & schema::integer_type) != 0
+                                   && std::trunc(traits::number(value)) == traits::number(value);
+      if (!integral_number) return fail("type");
+    }
+
+    if ((node.flags & schema::has_enum) != 0 && !in_enum<Value>(node, value, type)) return fail("enum");
+
+    if (type == schema::integer_type || type == schema::number_type) {
+      if (!check_number(node, traits::number(value))) return fail("numeric bounds");
+    } else if (type == schema::string_type) {
+      if (node.min_length != 0 || node.max_length != schema::unlimited) {
+        const auto length = traits::string_length(value);
+        if (length < node.min_length || length > node.max_length) return fail("string length");
+      }
+    } else if (type == schema::array_type) {
+      const auto size = traits::size(value);
+      if (size < node.min_items || size > node.max_items) return fail("item count");
+      if (node.items != schema::no_node
+          && !traits::for_each_element(value, [&](const auto &child) { return validate_node(node.items, child, error); }))
+        return fail("items");
+    } else if (type == schema::object_type) {
+      const auto size = traits::size(value);
+      if (size < node.min_properties || size > node.max_properties) return fail("property count");
+      if (!validate_members(node, value, error)) return fail("properties");
+    }
+
+    return validate_combinators(index, value, error);
+  }
+
+private:
+  template<typename Value>
+  [[nodiscard]] static bool in_enum(const node_type &node, const Value &value, uint8_t type)
+  {
+    using traits = schema::value_traits<Value>;
+    if (type == schema::string_type)
+      return node.enum_strings != nullptr && traits::enum_contains(value, *node.enum_strings);
+    if (node.enum_values == nullptr) return false;
+    // Numbers compare by value, so 1, 1u and 1.0 all match an enum entry of 1.
+    const bool number = type == schema::integer_type || type == schema::number_type;
+    for (const auto &candidate : *node.enum_values) {
+      if (number ? candidate.is_number() && candidate.template get<double>() == traits::number(value)
+                 : traits::enum_equals(value, candidate))
+        return true;
+    }
+    return false;
+  }
+
+  [[nodiscard]] static bool check_number(const node_type &node, double value)
+  {
+    if ((node.flags & schema::has_minimum) != 0) {
+      if ((node.flags & schema::exclusive_minimum) != 0 ? !(value > node.minimum) : !(value >= node.minimum))
+        return false;
+    }
+    if ((node.flags & schema::has_maximum) != 0) {
+      if ((node.flags & schema::exclusive_maximum) != 0 ? !(value < node.maximum) : !(value <= node.maximum))
+        return false;
+    }
+    if ((node.flags & schema::has_multiple_of) != 0 && !is_multiple_of(value, node.multiple_of)) return false;
+    return true;
+  }
+
+  // Integral operands divide exactly. Decimal ones are inexact in binary (0.3 / 0.1 is 2.9999999999999996), so the
+  // quotient only has to be within a few ulps of a whole number.
+  [[nodiscard]] static bool is_multiple_of(double value, double multiple_of)
+  {
+    // 2^53, past which doubles skip integers.
+    constexpr double integer_limit = 9007199254740992.0;
+    if (std::trunc(value) == value && std::trunc(multiple_of) == multiple_of && std::abs(value) <= integer_limit
+        && multiple_of <= integer_limit) {
+      return static_cast<int64_t>(value) % static_cast<int64_t>(multiple_of) == 0;
+    }
+    const auto quotient = value / multiple_of;
+    const auto tolerance = 4.0 * std::numeric_limits<double>::epsilon() * std::max(1.0, std::abs(quotient));
+    return std::abs(quotient - std::round(quotient)) <= tolerance;
+  }
+
+  template<typename Value>
+  [[nodiscard]] bool validate_members(const node_type &node, const Value &value, schema::error_t *error) const
+  {
+    using traits = schema::value_traits<Value>;
+    uint64_t seen_required = 0;
+    const bool members_valid =
+      traits::for_each_member(value, [&](std::basic_string_view<CharType> key, uint32_t hash, const auto &child) {
+        bool matched = false;
+        if (node.properties != nullptr) {
+          if (const auto entry = node.properties->find_entry(key, hash)) {
+            const auto packed = entry.second->template get<uint64_t>();
+            if (const auto slot = schema::property_required_slot(packed); slot != 0)
+              seen_required |= uint64_t{ 1 } << (slot - 1u);
+            if (const auto child_node = schema::property_node(packed); child_node != schema::no_node) {
+              matched = true;
+              if (!validate_node(child_node, child, error)) return false;
+            }
+          }
+        }
+        for (const auto &pattern : node.pattern_properties) {
+          if (!schema::matches(pattern.kind, key)) continue;
+          matched = true;
+          if (!validate_node(pattern.node, child, error)) return false;
+        }
+        return matched || validate_node(node.additional_properties, child, error);
+      });
+    if (!members_valid) return false;
+
+    const auto required_mask =
+      node.required_count == schema::max_required ? ~uint64_t{ 0 } : (uint64_t{ 1 } << node.required_count) - 1u;
+    return seen_required == required_mask;
+  }
+
+  template<typename Value>
+  [[nodiscard]] bool validate_combinators(uint32_t index, const Value &value, schema::error_t *error) const
+  {
+    const auto &node = nodes[index];
+    const auto fail = [&](std::string_view reason) {
+      if (error != nullptr && error->node == schema::no_node) *error = { reason, index };
+      return false;
+    };
+
+    for (const auto branch : node.all_of) {
+      if (!validate_node(branch, value, error)) return fail("allOf");
+    }
+    // Alternatives are tried without reporting, only the combinator itself fails.
+    if (!node.any_of.empty()) {
+      bool any = false;
+      for (const auto branch : node.any_of) {
+        if (validate_node(branch, value, nullptr)) {
+          any = true;
+          break;
+        }
+      }
+      if (!any) return fail("anyOf");
+    }
+    if (!node.one_of.empty()) {
+      size_t matched = 0;
+      for (const auto branch : node.one_of) {
+        if (validate_node(branch, value, nullptr) && ++matched > 1) break;
+      }
+      if (matched != 1) return fail("oneOf");
+    }
+    if (node.not_node != schema::no_node && validate_node(node.not_node, value, nullptr)) return fail("not");
+    return true;
+  }
+};
+
+// Validates a document read as a stream of events, in document order, without building it: one evaluation is kept
+// per subschema applying to each open array or object, so memory grows with the nesting depth and not with the
+// document size. Scalars are checked as they arrive, and arrays and objects when they end.
+//
+// Enums listing arrays or objects cannot be compared without the value and are rejected with std::runtime_error.
+template<typename CharType> class basic_schema_stream_t
+{
+public:
+  using schema_type = basic_schema_t<CharType>;
+  using scalar_type = schema::scalar_t<CharType>;
+
+  explicit basic_schema_stream_t(const schema_type &schema) : schema_(schema) {}
+
+  void scalar(const scalar_type &value)
+  {
+    for (const auto &request : take_requests()) {
+      const bool valid = schema_.validate_node(request.node, value, request.report ? &error_ : nullptr);
+      if (!valid && request.report) valid_ = false;
+      fold(request.parent, request.how, valid);
+    }
+  }
+
+  void begin_object() { begin_container(schema::object_type); }
+
+  void begin_array() { begin_container(schema::array_type); }
+
+  void key(std::basic_string_view<CharType> name)
+  {
+    const auto hash = basic_json<CharType>::calc_hash(name);
+    const auto frame = frames_.back();
+    for (auto index = frame.begin; index < frame.end; ++index) {
+      ++evaluations_[index].size;
+      if (!evaluations_[index].ok) continue;
+      const auto &node = schema_.nodes[evaluations_[index].node];
+      bool matched = false;
+      if (node.properties != nullptr) {
+        if (const auto entry = node.properties->find_entry(name, hash)) {
+          const auto packed = entry.second->template get<uint64_t>();
+          if (const auto slot = schema::property_required_slot(packed); slot != 0)
+            evaluations_[index].seen_required |= uint64_t{ 1 } << (slot - 1u);
+          if (const auto child = schema::property_node(packed); child != schema::no_node) {
+            matched = true;
+            request(child, index, role::member);
+          }
+        }
+      }
+      for (const auto &pattern : node.pattern_properties) {
+        if (!schema::matches(pattern.kind, name)) continue;
+        matched = true;
+        request(pattern.node, index, role::member);
+      }
+      if (!matched) request(node.additional_properties, index, role::member);
+    }
+  }
+
+  void end_object() { end_container(); }
+
+  void end_array() { end_container(); }
+
+  // Whether the document read so far is valid. Once false, the rest of the document cannot make it valid again.
+  [[nodiscard]] bool valid() const noexcept { return valid_; }
+
+  // First failure found, innermost first.
+  [[nodiscard]] const schema::error_t &error() const noexcept { return error_; }
+
+private:
+  // How the result of an evaluation combines into the evaluation it belongs to.
+  enum class role : uint8_t { member, all_of, any_of, one_of, negated };
+
+  static constexpr size_t no_parent = static_cast<size_t>(-1);
+
+  // A subschema to check the next value against. Only failures on paths of members and allOf branches from the root
+  // are reported; the others may be overruled by a sibling branch.
+  struct request_t
+  {
+    uint32_t node;
+    size_t parent;
+    role how;
+    bool report;
+  };
+
+  struct evaluation_t
+  {
+    uint32_t node;
+    size_t parent;
+    role how;
+    bool report;
+    uint8_t type;
+    bool ok = true;
+    uint32_t any_matched = 0;
+    uint32_t one_matched = 0;
+    uint64_t seen_required = 0;
+    size_t size = 0;
+  };
+
+  // Evaluations of an open array or object; its members' evaluations follow them.
+  struct frame_t
+  {
+    size_t begin;
+    size_t end;
+    uint8_t type;
+  };
+
+  void request(uint32_t node, size_t parent, role how)
+  {
+    if (node == schema::no_node) {
+      fold(parent, how, true);
+      return;
+    }
+    const bool report =
+      parent == no_parent || (evaluations_[parent].report && (how == role::member || how == role::all_of));
+    pending_.push_back({ node, parent, how, report });
+  }
+
+  // The requests for the value starting now; array elements ask for them here, object members in key().
+  const std::vector<request_t> &take_requests()
+  {
+    if (frames_.empty()) {
+      request(0, no_parent, role::member);
+    } else if (frames_.back().type == schema::array_type) {
+      const auto frame = frames_.back();
+      for (auto index = frame.begin; index < frame.end; ++index) {
+        ++evaluations_[index].size;
+        if (evaluations_[index].ok) request(schema_.nodes[evaluations_[index].node].items, index, role::member);
+      }
+    }
+    taken_.clear();
+    taken_.swap(pending_);
+    return taken_;
+  }
+
+  void begin_container(uint8_t type)
+  {
+    const auto begin = evaluations_.size();
+    for (const auto &request : take_requests()) {
+      expand(request.node, request.parent, request.how, request.report, type);
+    }
+    frames_.push_back({ begin, evaluations_.size(), type });
+  }
+
+  void expand(uint32_t node_index, size_t parent, role how, bool report, uint8_t type)
+  {
+    const auto index = evaluations_.size();
+    evaluations_.push_back({ .node = node_index, .parent = parent, .how = how, .report = report, .type = type });
+    const auto &node = schema_.nodes[node_index];
+    if ((node.types & type) == 0) {
+      fail(index, "type");
+      return;
+    }
+    if ((node.flags & schema::has_enum) != 0) {
+      if (node.enum_values != nullptr) {
+        for (const auto &candidate : *node.enum_values) {
+          if (candidate.is_array() || candidate.is_object())
+            throw std::runtime_error("an enum of arrays or objects cannot be checked while streaming");
+        }
+      }
+      fail(index, "enum");
+      return;
+    }
+    for (const auto branch : node.all_of) expand(branch, index, role::all_of, report, type);
+    for (const auto branch : node.any_of) expand(branch, index, role::any_of, false, type);
+    for (const auto branch : node.one_of) expand(branch, index, role::one_of, false, type);
+    if (node.not_node != schema::no_node) expand(node.not_node, index, role::negated, false, type);
+  }
+
+  void end_container()
+  {
+    const auto frame = frames_.back();
+    frames_.pop_back();
+    // Branches come after the evaluation they belong to, so they are finished first.
+    for (auto index = evaluations_.size(); index-- > frame.begin;) finish(index);
+    evaluations_.resize(frame.begin);
+  }
+
+  void finish(size_t index)
+  {
+    auto &evaluation = evaluations_[index];
+    const auto &node = schema_.nodes[evaluation.node];
+    if (evaluation.ok && evaluation.type == schema::array_type) {
+      if (evaluation.size < node.min_items || evaluation.size > node.max_items) fail(index, "item count");
+    } else if (evaluation.ok) {
+      const auto required_mask =
+        node.required_count == schema::max_required ? ~uint64_t{ 0 } : (uint64_t{ 1 } << node.required_count) - 1u;
+      if (evaluation.size < node.min_properties || evaluation.size > node.max_properties) {
+        fail(index, "property count");
+      } else if (evaluation.seen_required != required_mask) {
+        fail(index, "properties");
+      }
+    }
+    if (evaluation.ok && !node.any_of.empty() && evaluation.any_matched == 0) fail(index, "anyOf");
+    if (evaluation.ok && !node.one_of.empty() && evaluation.one_matched != 1) fail(index, "oneOf");
+    fold(evaluation.parent, evaluation.how, evaluation.ok);
+  }
+
+  void fail(size_t index, std::string_view reason)
+  {
+    auto &evaluation = evaluations_[index];
+    if (!evaluation.ok) return;
+    evaluation.ok = false;
+    if (!evaluation.report) return;
+    valid_ = false;
+    if (error_.node == schema::no_node) error_ = { reason, evaluation.node };
+  }
+
+  void fold(size_t parent, role how, bool ok)
+  {
+    if (parent == no_parent) {
+      if (!ok) valid_ = false;
+      return;
+    }
+    switch (how) {
+    case role::member:
+      if (!ok) fail(parent, evaluations_[parent].type == schema::array_type ? "items" : "properties");
+      break;
+    case role::all_of:
+      if (!ok) fail(parent, "allOf");
+      break;
+    case role::any_of:
+      if (ok) ++evaluations_[parent].any_matched;
+      break;
+    case role::one_of:
+      if (ok) ++evaluations_[parent].one_matched;
+      break;
+    case role::negated:
+      if (ok) fail(parent, "not");
+      break;
+    }
+  }
+
+  const schema_type &schema_;
+  std::vector<evaluation_t> evaluations_;
+  std::vector<frame_t> frames_;
+  std::vector<request_t> pending_;
+  std::vector<request_t> taken_;
+  schema::error_t error_{};
+  bool valid_ = true;
+};
+
+using schema_node_t = basic_schema_node_t<basicType>;
+using schema_t = basic_schema_t<basicType>;
+using schema_stream_t = basic_schema_stream_t<basicType>;
+
+}// namespace json2cpp
+
+#endif
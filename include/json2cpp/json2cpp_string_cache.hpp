@@ -0,0 +1,158 @@
+/*
+MIT License
+
+Copyright (c) 2026 Jason Turner, Regis Duflaut-Averty
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef JSON2CPP_STRING_CACHE_HPP_INCLUDED
+#define JSON2CPP_STRING_CACHE_HPP_INCLUDED
+
+#include <json2cpp/json2cpp.hpp>
+
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace json2cpp {
+
+// Text of a string value. Plain strings are viewed in place; decompressed ones are kept alive by storage even after
+// the cache evicts them.
+template<typename CharType> struct basic_cached_string_t
+{
+  std::shared_ptr<const std::basic_string<CharType>> storage;
+  std::basic_string_view<CharType> view;
+
+  [[nodiscard]] std::basic_string_view<CharType> get() const noexcept { return view; }
+  operator std::basic_string_view<CharType>() const noexcept { return view; }
+};
+
+// Bounded, thread-safe LRU cache of decompressed string values, keyed by the compressed data they were built from.
+template<typename CharType> class basic_string_cache
+{
+public:
+  using string_type = std::basic_string<CharType>;
+  using handle_type = basic_cached_string_t<CharType>;
+
+  explicit basic_string_cache(size_t capacity_bytes = size_t{ 1 } << 20) noexcept : capacity_bytes_(capacity_bytes) {}
+
+  basic_string_cache(const basic_string_cache &) = delete;
+  basic_string_cache &operator=(const basic_string_cache &) = delete;
+
+  [[nodiscard]] handle_type get(const basic_json<CharType> &value)
+  {
+    if (!value.is_string()) throw std::domain_error("JSON value is not a string");
+    if (!value.is_compressed_string()) return { nullptr, value.getString() };
+
+    const auto *key = value.compressed_data();
+    {
+      std::lock_guard lock(mutex_);
+      if (auto cached = find_locked(key)) return { cached, *cached };
+    }
+
+    // Decompress outside the lock; if another thread won the race its copy is kept and ours is dropped.
+    auto decompressed = std::make_shared<string_type>(value.size(), CharType{});
+    value.decompress_to(decompressed->data());
+
+    std::lock_guard lock(mutex_);
+    if (auto cached = find_locked(key)) return { cached, *cached };
+    const auto bytes = entry_bytes(*decompressed);
+    if (bytes <= capacity_bytes_) {
+      entries_.push_front({ key, decompressed });
+      index_.emplace(key, entries_.begin());
+      size_bytes_ += bytes;
+      evict_locked();
+    }
+    std::shared_ptr<const string_type> result = std::move(decompressed);
+    return { result, *result };
+  }
+
+  void clear() noexcept
+  {
+    std::lock_guard lock(mutex_);
+    entries_.clear();
+    index_.clear();
+    size_bytes_ = 0;
+  }
+
+  [[nodiscard]] size_t size_bytes() const noexcept
+  {
+    std::lock_guard lock(mutex_);
+    return size_bytes_;
+  }
+
+  [[nodiscard]] size_t capacity_bytes() const noexcept { return capacity_bytes_; }
+
+private:
+  struct entry
+  {
+    const uint8_t *key;
+    std::shared_ptr<const string_type> value;
+  };
+
+  static size_t entry_bytes(const string_type &value) noexcept { return value.size() * sizeof(CharType); }
+
+  std::shared_ptr<const string_type> find_locked(const uint8_t *key)
+  {
+    const auto it = index_.find(key);
+    if (it == index_.end()) return nullptr;
+    entries_.splice(entries_.begin(), entries_, it->second);
+    return it->second->value;
+  }
+
+  void evict_locked() noexcept
+  {
+    while (size_bytes_ > capacity_bytes_ && !entries_.empty()) {
+      size_bytes_ -= entry_bytes(*entries_.back().value);
+      index_.erase(entries_.back().key);
+      entries_.pop_back();
+    }
+  }
+
+  size_t capacity_bytes_;
+  size_t size_bytes_ = 0;
+  mutable std::mutex mutex_;
+  std::list<entry> entries_;
+  std::unordered_map<const uint8_t *, typename std::list<entry>::iterator> index_;
+};
+
+template<typename CharType> basic_string_cache<CharType> &default_string_cache()
+{
+  static basic_string_cache<CharType> cache;
+  return cache;
+}
+
+// Reads any string value, decompressing through the shared default cache when needed.
+template<typename CharType> [[nodiscard]] basic_cached_string_t<CharType> get_string(const basic_json<CharType> &value)
+{
+  return default_string_cache<CharType>().get(value);
+}
+
+using string_cache = basic_string_cache<basicType>;
+using cached_string_t = basic_cached_string_t<basicType>;
+
+}// namespace json2cpp
+
+#endif
@@ -0,0 +1,320 @@
+/*
+MIT License
+
+Copyright (c) 2026 Jason Turner, Regis Duflaut-Averty
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "autotune.hpp"
+
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <stdexcept>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+constexpr std::string_view candidate_name = "autotune_candidate";
+
+// Resolves every lookup of the file named by argv[1] on the candidate document, argv[2] times, and prints the best
+// nanoseconds per lookup. Paths are parsed once, before timing, so only the json2cpp lookups are measured.
+constexpr std::string_view driver_source = R"(#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "autotune_candidate.hpp"
+
+struct step
+{
+  bool is_index = false;
+  std::size_t index = 0;
+  std::basic_string<json2cpp::basicType> key;
+};
+
+static void replace_all(std::string &text, const std::string &from, const std::string &to)
+{
+  for (auto at = text.find(from); at != std::string::npos; at = text.find(from, at + to.size())) {
+    text.replace(at, from.size(), to);
+  }
+}
+
+int main(int argc, char **argv)
+{
+  if (argc < 3) { return 2; }
+  const auto &root = compiled_json::autotune_candidate::get();
+
+  std::vector<std::vector<step>> paths;
+  std::size_t steps = 0;
+  std::ifstream input(argv[1]);
+  for (std::string line; std::getline(input, line);) {
+    std::vector<step> path;
+    const json2cpp::json *node = &root;
+    for (std::size_t begin = 0; begin < line.size();) {
+      auto end = line.find('/', begin + 1);
+      if (end == std::string::npos) { end = line.size(); }
+      auto token = line.substr(begin + 1, end - begin - 1);
+      replace_all(token, "~1", "/");
+      replace_all(token, "~0", "~");
+      if (node->is_array()) {
+        path.push_back({ true, std::stoul(token), {} });
+        node = &node->at(path.back().index);
+      } else {
+        path.push_back({ false, 0, { token.begin(), token.end() } });
+        node = &node->at(path.back().key);
+      }
+      begin = end;
+    }
+    steps += path.size();
+    paths.push_back(std::move(path));
+  }
+
+  // Short lookup lists are swept several times per timed run to stay well above the clock resolution.
+  const auto sweeps = std::max<std::size_t>(1, 100000 / std::max<std::size_t>(1, steps));
+  const auto repetitions = std::stoul(argv[2]);
+  auto best = std::numeric_limits<double>::max();
+  volatile std::size_t sink = 0;
+  for (std::size_t repetition = 0; repetition < repetitions; ++repetition) {
+    std::size_t found = 0;
+    const auto start = std::chrono::steady_clock::now();
+    for (std::size_t sweep = 0; sweep < sweeps; ++sweep) {
+      for (const auto &path : paths) {
+        const json2cpp::json *node = &root;
+        for (const auto &current : path) {
+          node = current.is_index ? &node->at(current.index) : &node->at(current.key);
+        }
+        found += node->size();
+      }
+    }
+    const std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    sink = sink + found;
+    best = std::min(best, elapsed.count() / static_cast<double>(sweeps * std::max<std::size_t>(1, paths.size())));
+  }
+  std::printf("%f\n", best);
+}
+)";
+
+struct measurement
+{
+  double ns_per_lookup = 0;
+  std::uintmax_t binary_size = 0;
+};
+
+// A threshold and the values the search tries for it; apply() stores one of them into a configuration.
+struct parameter
+{
+  std::string_view name;
+  std::vector<double> values;
+  void (*apply)(layout_thresholds &, double);
+};
+
+const std::vector<parameter> &parameters()
+{
+  static const std::vector<parameter> all{
+    { "min_shared_object_size",
+      { 2, 3, 4, 8 },
+      [](layout_thresholds &t, double v) { t.min_shared_object_size = static_cast<std::size_t>(v); } },
+    { "min_shared_array_size",
+      { 2, 3, 4, 8 },
+      [](layout_thresholds &t, double v) { t.min_shared_array_size = static_cast<std::size_t>(v); } },
+    { "min_scalar_references",
+      { 2, 3, 4, 8 },
+      [](layout_thresholds &t, double v) { t.min_scalar_references = static_cast<int>(v); } },
+    { "min_compact_savings",
+      { 0, 16, 32, 64, 128, 256 },
+      [](layout_thresholds &t, double v) { t.min_compact_savings = v; } },
+    // 256 is above the largest perfect hash, so it disables them.
+    { "min_mphf_size",
+      { 16, 32, 64, 128, 256 },
+      [](layout_thresholds &t, double v) { t.min_mphf_size = static_cast<std::size_t>(v); } },
+    { "mphf_prefix_keys",
+      { 0, 4, 8, 16 },
+      [](layout_thresholds &t, double v) { t.mphf_prefix_keys = static_cast<std::size_t>(v); } },
+    { "small_object_size",
+      { 0, 2, 4, 8 },
+      [](layout_thresholds &t, double v) { t.small_object_size = static_cast<std::size_t>(v); } },
+    { "small_object_min_uses",
+      { 4, 8, 12, 24 },
+      [](layout_thresholds &t, double v) { t.small_object_min_uses = static_cast<std::size_t>(v); } },
+    // 0 disables the key filters.
+    { "min_key_filter_size",
+      { 0, 8, 16, 32, 64 },
+      [](layout_thresholds &t, double v) { t.min_key_filter_size = static_cast<std::size_t>(v); } },
+  };
+  return all;
+}
+
+std::string quote(const std::filesystem::path &path) { return fmt::format("\"{}\"", path.string()); }
+
+// Keeps the lookups that resolve in the document, one JSON pointer per line.
+std::vector<std::string> read_lookups(const std::filesystem::path &filename, const nlohmann::ordered_json &document)
+{
+  std::ifstream input(filename);
+  if (!input) throw std::runtime_error(fmt::format("Unable to open lookups '{}'", filename.string()));
+
+  std::vector<std::string> lookups;
+  for (std::string line; std::getline(input, line);) {
+    if (!line.empty() && line.back() == '\r') line.pop_back();
+    if (line.empty() || line.front() == '#') continue;
+    if (!document.contains(nlohmann::ordered_json::json_pointer(line))) {
+      spdlog::warn("Lookup '{}' does not resolve in the document, skipped", line);
+      continue;
+    }
+    lookups.push_back(std::move(line));
+  }
+  if (lookups.empty()) throw std::runtime_error(fmt::format("No usable lookups in '{}'", filename.string()));
+  return lookups;
+}
+
+class candidate_runner
+{
+public:
+  candidate_runner(const nlohmann::ordered_json &document, compile_options options, const autotune_options &tuning)
+    : document_(document), options_(std::move(options)), tuning_(tuning)
+  {
+    options_.report.clear();
+    std::ofstream(tuning_.work_dir / "autotune_driver.cpp") << driver_source;
+  }
+
+  [[nodiscard]] std::size_t builds() const noexcept { return builds_; }
+
+  measurement run(const layout_thresholds &thresholds)
+  {
+    options_.thresholds = thresholds;
+    const auto level = spdlog::get_level();
+    spdlog::set_level(spdlog::level::warn);
+    const auto results = compile(candidate_name, document_, options_);
+    spdlog::set_level(level);
+
+    // Neighbouring thresholds often produce the same code; reuse its measurement instead of rebuilding.
+    std::string code;
+    for (const auto &line : results.impl) { code += line; }
+    const auto key = std::hash<std::string>{}(code);
+    if (const auto cached = measured_.find(key); cached != measured_.end()) return cached->second;
+
+    const auto &work = tuning_.work_dir;
+    write_compilation(candidate_name, results, work / candidate_name);
+    const auto binary = work / "autotune_bench";
+    const auto build = fmt::format("{} -std=c++23 -O2 -I{} -I{} {} {} -o {}",
+      tuning_.compiler,
+      quote(tuning_.include_dir),
+      quote(work),
+      quote(work / "autotune_driver.cpp"),
+      quote(work / "autotune_candidate.cpp"),
+      quote(binary));
+    if (std::system(build.c_str()) != 0) throw std::runtime_error(fmt::format("Candidate build failed: {}", build));
+    ++builds_;
+
+    const auto output = work / "autotune_result.txt";
+    const auto bench = fmt::format(
+      "{} {} {} > {}", quote(binary), quote(work / "autotune_lookups.txt"), tuning_.repetitions, quote(output));
+    if (std::system(bench.c_str()) != 0) throw std::runtime_error(fmt::format("Candidate run failed: {}", bench));
+
+    measurement result;
+    std::ifstream(output) >> result.ns_per_lookup;
+    result.binary_size = std::filesystem::file_size(binary);
+    measured_.emplace(key, result);
+    return result;
+  }
+
+private:
+  const nlohmann::ordered_json &document_;
+  compile_options options_;
+  const autotune_options &tuning_;
+  std::unordered_map<std::size_t, measurement> measured_;
+  std::size_t builds_ = 0;
+};
+
+// Faster by more than the timing noise, or as fast and smaller.
+bool better(const measurement &candidate, const measurement &best)
+{
+  constexpr double noise = 0.01;
+  if (candidate.ns_per_lookup < best.ns_per_lookup * (1 - noise)) return true;
+  return candidate.ns_per_lookup <= best.ns_per_lookup * (1 + noise) && candidate.binary_size < best.binary_size;
+}
+
+}// namespace
+
+layout_thresholds autotune(const std::filesystem::path &input_file_name,
+  const compile_options &options,
+  const autotune_options &tuning)
+{
+  if (!std::filesystem::exists(tuning.include_dir / "json2cpp" / "json2cpp.hpp")) {
+    throw std::runtime_error(
+      fmt::format("'{}' does not hold json2cpp/json2cpp.hpp, set it with --tune-include", tuning.include_dir.string()));
+  }
+
+  std::ifstream input(input_file_name);
+  if (!input) throw std::runtime_error(fmt::format("Unable to open '{}'", input_file_name.string()));
+  nlohmann::ordered_json document;
+  input >> document;
+  // Lookups outside the kept subtrees are skipped like any other missing path.
+  if (!options.keep.empty()) document = keep_subtrees(document, options.keep);
+
+  std::filesystem::create_directories(tuning.work_dir);
+  {
+    std::ofstream lookups(tuning.work_dir / "autotune_lookups.txt");
+    for (const auto &lookup : read_lookups(tuning.lookups, document)) { lookups << lookup << '\n'; }
+  }
+
+  candidate_runner runner(document, options, tuning);
+  auto best_thresholds = options.thresholds;
+  auto best = runner.run(best_thresholds);
+  spdlog::info("Autotune start: {:.2f} ns/lookup, {} bytes", best.ns_per_lookup, best.binary_size);
+
+  // Coordinate descent: try every value of one threshold with the others fixed at their best, then the next
+  // threshold, and sweep again while a sweep still improves something. The sweep limit stops a search that only
+  // trades measurements within the noise, which no longer builds anything.
+  constexpr std::size_t max_sweeps = 4;
+  bool improved = true;
+  for (std::size_t sweep = 0; improved && sweep < max_sweeps && runner.builds() < tuning.max_candidates; ++sweep) {
+    improved = false;
+    for (const auto &current : parameters()) {
+      for (const auto value : current.values) {
+        if (runner.builds() >= tuning.max_candidates) break;
+        auto candidate_thresholds = best_thresholds;
+        current.apply(candidate_thresholds, value);
+        const auto candidate = runner.run(candidate_thresholds);
+        spdlog::info("Autotune {}={}: {:.2f} ns/lookup, {} bytes",
+          current.name,
+          value,
+          candidate.ns_per_lookup,
+          candidate.binary_size);
+        if (better(candidate, best)) {
+          best = candidate;
+          best_thresholds = candidate_thresholds;
+          improved = true;
+        }
+      }
+    }
+  }
+
+  spdlog::info("Autotune kept {:.2f} ns/lookup, {} bytes after {} builds",
+    best.ns_per_lookup,
+    best.binary_size,
+    runner.builds());
+  return best_thresholds;
+}
@@ -0,0 +1,56 @@
+/*
+MIT License
+
+Copyright (c) 2026 Jason Turner, Regis Duflaut-Averty
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef JSON2CPP_AUTOTUNE_HPP
+#define JSON2CPP_AUTOTUNE_HPP
+
+#include <filesystem>
+#include <string>
+
+#include "json2cpp.hpp"
+
+struct autotune_options
+{
+  // JSON pointers of the lookups to time, one per line; empty lines and lines starting with '#' are skipped.
+  std::filesystem::path lookups;
+  // Compiler run on every candidate, and the directory holding json2cpp/json2cpp.hpp.
+  std::string compiler = "c++";
+  std::filesystem::path include_dir;
+  // Where candidates are generated and built.
+  std::filesystem::path work_dir;
+  // Candidates built at most, the starting configuration included. Thresholds producing the same code as an earlier
+  // candidate reuse its measurement and are not counted.
+  std::size_t max_candidates = 40;
+  // Timed sweeps over the lookups per candidate; the fastest one is kept.
+  std::size_t repetitions = 20;
+};
+
+// Searches the layout thresholds one at a time, starting from options.thresholds. Every candidate is generated,
+// compiled with a driver resolving the lookups and timed; a change is kept when the lookups get faster, or as fast
+// with a smaller binary.
+layout_thresholds autotune(const std::filesystem::path &input_file_name,
+  const compile_options &options,
+  const autotune_options &tuning);
+
+#endif
@@ -0,0 +1,124 @@
+/*
+MIT License
+
+Copyright (c) 2026 Jason Turner, Regis Duflaut-Averty
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+// Counts heap allocations along the valijson validation path of schema_validator --internal: parsing the compiled
+// Energy+ schema, then validating a document. Frozen values used to cost one allocation each; they now come from
+// json2cppJsonFrozenValuePool, and the report shows both figures.
+
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <new>
+#include <string_view>
+
+#include <CLI/CLI.hpp>
+#include <spdlog/spdlog.h>
+
+#include <json2cpp/json2cpp_adapter.hpp>
+#include <valijson/adapters/nlohmann_json_adapter.hpp>
+#include <valijson/schema.hpp>
+#include <valijson/schema_parser.hpp>
+#include <valijson/validator.hpp>
+
+#include "schema.hpp"
+
+namespace {
+std::atomic<std::size_t> heap_allocations{ 0 };
+}
+
+void *operator new(std::size_t size)
+{
+  heap_allocations.fetch_add(1, std::memory_order_relaxed);
+  if (void *ptr = std::malloc(size == 0 ? 1 : size)) { return ptr; }
+  throw std::bad_alloc{};
+}
+
+void operator delete(void *ptr) noexcept { std::free(ptr); }
+
+void operator delete(void *ptr, std::size_t) noexcept { std::free(ptr); }
+
+struct allocation_counts
+{
+  std::size_t heap = 0;
+  std::size_t frozen_values = 0;
+  std::size_t pool_chunks = 0;
+};
+
+template<typename Function> allocation_counts count_allocations(Function function)
+{
+  using valijson::adapters::json2cppJsonFrozenValuePool;
+  const auto heap = heap_allocations.load();
+  const auto frozen_values = json2cppJsonFrozenValuePool::allocations();
+  const auto pool_chunks = json2cppJsonFrozenValuePool::chunks();
+  function();
+  return { heap_allocations.load() - heap,
+    json2cppJsonFrozenValuePool::allocations() - frozen_values,
+    json2cppJsonFrozenValuePool::chunks() - pool_chunks };
+}
+
+void report(std::string_view phase, const allocation_counts &counts)
+{
+  // Without the pool every frozen value is a heap allocation of its own, and there are no chunks.
+  const auto before = counts.heap - counts.pool_chunks + counts.frozen_values;
+  spdlog::info("{:>9}: {} heap allocations ({} before pooling), {} frozen values from {} pool chunks",
+    phase,
+    counts.heap,
+    before,
+    counts.frozen_values,
+    counts.pool_chunks);
+}
+
+int main(int argc, const char **argv)
+{
+  try {
+    CLI::App app("frozen_value_benchmark version 0.0.1");
+
+    std::filesystem::path document_to_validate;
+    app.add_option("<document_to_validate>", document_to_validate)->required();
+    CLI11_PARSE(app, argc, argv);
+
+    nlohmann::json document;
+    std::ifstream input_file(document_to_validate);
+    input_file >> document;
+
+    valijson::Schema schema;
+    report("parse", count_allocations([&] {
+      valijson::SchemaParser parser;
+      const valijson::adapters::json2cppJsonAdapter schema_adapter(compiled_json::energyplus_schema::get());
+      parser.populateSchema(schema_adapter, schema);
+    }));
+
+    bool result = false;
+    report("validate", count_allocations([&] {
+      valijson::Validator validator;
+      const valijson::adapters::NlohmannJsonAdapter target_adapter(document);
+      result = validator.validate(schema, target_adapter, nullptr);
+    }));
+    spdlog::info("validation result {}", result);
+  } catch (const std::exception &e) {
+    spdlog::error("Unhandled exception in main: {}", e.what());
+  }
+}
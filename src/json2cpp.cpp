@@ -24,13 +24,22 @@ SOFTWARE.
 
 #include <algorithm>
 #include <array>
+#include <bit>
 #include <cctype>
+#include <chrono>
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
+#include <deque>
 #include <filesystem>
 #include <fmt/format.h>
 #include <fstream>
 #include <functional>
+#include <json2cpp/json2cpp.hpp>
+#include <json2cpp/json2cpp_dump.hpp>
+#include <json2cpp/json2cpp_image.hpp>
+#include <limits>
+#include <map>
 #include <nlohmann/json.hpp>
 #include <set>
 #include <spdlog/spdlog.h>
@@ -40,11 +49,7 @@ SOFTWARE.
 #include <utility>
 #include <vector>
 
-struct compile_results
-{
-  std::vector<std::string> hpp;
-  std::vector<std::string> impl;
-};
+#include "json2cpp.hpp"
 
 namespace {
 
@@ -63,6 +68,11 @@ std::string sanitize_identifier(std::string_view name)
   return result.empty() ? "json_doc" : result;
 }
 
+double elapsed_ms(const std::chrono::steady_clock::time_point start)
+{
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
 std::string escape_string(const std::string &str)
 {
   std::string result;
@@ -161,6 +171,83 @@ size_t utf16_length(std::string_view str)
   return length;
 }
 
+std::vector<std::uint32_t> utf16_units(std::string_view str)
+{
+  std::vector<std::uint32_t> units;
+  units.reserve(str.size());
+  for (size_t i = 0; i < str.size();) {
+    const auto c = static_cast<uint8_t>(str[i++]);
+    uint32_t cp = c;
+    if ((c & 0x80u) != 0u) {
+      const size_t extra = (c & 0xE0u) == 0xC0u ? 1u : ((c & 0xF0u) == 0xE0u ? 2u : 3u);
+      cp = c & (0x7Fu >> extra);
+      for (size_t j = 0; j < extra && i < str.size(); ++j) {
+        cp = (cp << 6) | (static_cast<uint8_t>(str[i++]) & 0x3Fu);
+      }
+    }
+    if (cp <= 0xFFFFu) {
+      units.push_back(cp);
+    } else {
+      cp -= 0x10000u;
+      units.push_back(0xD800u + (cp >> 10));
+      units.push_back(0xDC00u + (cp & 0x3FFu));
+    }
+  }
+  return units;
+}
+
+// Greedy LZ77 encoder producing the sequence format read by json2cpp::detail::lz_decode.
+std::vector<std::uint8_t> lz_compress(const std::vector<std::uint32_t> &units, const std::size_t unit_size)
+{
+  constexpr std::size_t min_match = 4;
+  constexpr std::size_t max_offset = 0xFFFF;
+
+  std::vector<std::uint8_t> out;
+  const auto write_length = [&](std::size_t value) {
+    for (; value >= 255; value -= 255) out.push_back(255);
+    out.push_back(static_cast<std::uint8_t>(value));
+  };
+  const auto write_sequence = [&](std::size_t literal_start, std::size_t literal_end, std::size_t offset, std::size_t match) {
+    const auto literals = literal_end - literal_start;
+    const auto match_code = match == 0 ? 0 : match - min_match;
+    out.push_back(static_cast<std::uint8_t>((std::min<std::size_t>(literals, 15) << 4) | std::min<std::size_t>(match_code, 15)));
+    if (literals >= 15) write_length(literals - 15);
+    for (auto i = literal_start; i < literal_end; ++i) {
+      for (std::size_t byte = 0; byte < unit_size; ++byte) out.push_back(static_cast<std::uint8_t>(units[i] >> (8 * byte)));
+    }
+    if (match == 0) return;
+    out.push_back(static_cast<std::uint8_t>(offset));
+    out.push_back(static_cast<std::uint8_t>(offset >> 8));
+    if (match_code >= 15) write_length(match_code - 15);
+  };
+  const auto key_at = [&](std::size_t pos) {
+    std::uint64_t key = 0;
+    for (std::size_t i = 0; i < min_match; ++i) key = (key << 16) | units[pos + i];
+    return key;
+  };
+
+  std::unordered_map<std::uint64_t, std::size_t> last_seen;
+  std::size_t literal_start = 0;
+  std::size_t pos = 0;
+  while (pos + min_match <= units.size()) {
+    auto [found, inserted] = last_seen.try_emplace(key_at(pos), pos);
+    const auto candidate = std::exchange(found->second, pos);
+    if (inserted || pos - candidate > max_offset) {
+      ++pos;
+      continue;
+    }
+
+    std::size_t match = min_match;
+    while (pos + match < units.size() && units[candidate + match] == units[pos + match]) ++match;
+    write_sequence(literal_start, pos, pos - candidate, match);
+    for (auto i = pos + 1; i < pos + match && i + min_match <= units.size(); ++i) last_seen[key_at(i)] = i;
+    pos += match;
+    literal_start = pos;
+  }
+  if (literal_start < units.size()) write_sequence(literal_start, units.size(), 0, 0);
+  return out;
+}
+
 inline void hash_combine(std::size_t &seed, std::size_t value)
 {
   seed ^= value + 0x9e3779b9 + (seed << 6) + (seed >> 2);
@@ -208,9 +295,32 @@ struct JsonHasher
   }
 };
 
+// Unlike nlohmann's operator==, 1, 1u and 1.0 (or 0.0 and -0.0) are different values here: they are emitted as
+// different json types, so neither pooling nor sharing may merge them.
 struct JsonEqual
 {
-  bool operator()(const nlohmann::ordered_json &a, const nlohmann::ordered_json &b) const { return a == b; }
+  bool operator()(const nlohmann::ordered_json &a, const nlohmann::ordered_json &b) const
+  {
+    if (a.type() != b.type()) return false;
+    switch (a.type()) {
+    case nlohmann::ordered_json::value_t::object:
+      if (a.size() != b.size()) return false;
+      for (auto lhs = a.begin(), rhs = b.begin(); lhs != a.end(); ++lhs, ++rhs) {
+        if (lhs.key() != rhs.key() || !(*this)(lhs.value(), rhs.value())) return false;
+      }
+      return true;
+    case nlohmann::ordered_json::value_t::array:
+      if (a.size() != b.size()) return false;
+      for (std::size_t i = 0; i < a.size(); ++i) {
+        if (!(*this)(a[i], b[i])) return false;
+      }
+      return true;
+    case nlohmann::ordered_json::value_t::number_float:
+      return std::bit_cast<std::uint64_t>(a.get<double>()) == std::bit_cast<std::uint64_t>(b.get<double>());
+    default:
+      return a == b;
+    }
+  }
 };
 
 struct StringHash
@@ -269,27 +379,93 @@ struct DuplicateTracker : ReuseTrackerBase
   }
 };
 
+// Pool of repeated scalars of every type, referenced as s[n]. Values are keyed by type as well (see JsonEqual).
+// Only the values some node ends up referencing are emitted: references are written as tokens and renumbered by
+// resolve() once emission is done.
 struct ScalarTracker : ReuseTrackerBase
 {
+  static constexpr char token_delimiter = '\n';
+
   int min_references = 2;
   std::unordered_map<nlohmann::ordered_json, std::uint32_t, JsonHasher, JsonEqual> value_to_index;
   std::vector<nlohmann::ordered_json> pooled_values;
+  std::vector<nlohmann::ordered_json> first_seen;
+  std::vector<char> referenced;
+  std::vector<std::uint32_t> emitted_index;
 
   using ReuseTrackerBase::ReuseTrackerBase;
 
   void track(const nlohmann::ordered_json &value)
   {
-    if (value.is_string()) ++counts[value];
+    if (value.is_discarded()) return;
+    if (++counts[value] == 1) first_seen.push_back(value);
   }
 
   void prepare_variables()
   {
-    prepare_reuse_variables([this](int count) { return count >= min_references; });
-    pooled_values.reserve(value_to_var.size());
-    for (const auto &[value, _] : value_to_var) {
-      value_to_index.emplace(value, static_cast<std::uint32_t>(pooled_values.size()));
-      pooled_values.emplace_back(value);
+    // Most referenced first, so that common values get the 8-bit indices the indexed perfect-hash layout needs.
+    std::vector<const nlohmann::ordered_json *> candidates;
+    for (const auto &value : first_seen) {
+      if (counts.at(value) >= min_references) candidates.push_back(&value);
+    }
+    std::ranges::stable_sort(
+      candidates, std::greater<>{}, [this](const nlohmann::ordered_json *value) { return counts.at(*value); });
+
+    pooled_values.reserve(candidates.size());
+    for (const auto *value : candidates) {
+      value_to_var.emplace(*value, fmt::format("{}{}", prefix, counter++));
+      value_to_index.emplace(*value, static_cast<std::uint32_t>(pooled_values.size()));
+      pooled_values.emplace_back(*value);
+    }
+    referenced.assign(pooled_values.size(), 0);
+  }
+
+  // Placeholder for the index of a pooled value, replaced by resolve().
+  std::string index_reference(const nlohmann::ordered_json &value)
+  {
+    const auto index = get_pool_index(value);
+    referenced[index] = 1;
+    return fmt::format("{}S{}{}", token_delimiter, index, token_delimiter);
+  }
+
+  // Drops the unreferenced values. Kept values keep their relative order, so an index never grows.
+  void finalize()
+  {
+    emitted_index.assign(pooled_values.size(), 0);
+    std::uint32_t next = 0;
+    for (std::size_t i = 0; i < pooled_values.size(); ++i) {
+      if (referenced[i] != 0) emitted_index[i] = next++;
+    }
+  }
+
+  bool is_referenced(std::size_t index) const { return referenced[index] != 0; }
+
+  std::size_t referenced_count(bool (nlohmann::ordered_json::*is_type)() const noexcept) const
+  {
+    std::size_t count = 0;
+    for (std::size_t i = 0; i < pooled_values.size(); ++i) {
+      if (is_referenced(i) && (pooled_values[i].*is_type)()) ++count;
+    }
+    return count;
+  }
+
+  // Rewrites the index tokens of a line, leaving the string arena's tokens for StringArena::resolve.
+  std::string resolve(const std::string &line) const
+  {
+    constexpr std::string_view token_start{ "\nS" };
+    if (line.find(token_start) == std::string::npos) return line;
+
+    std::string result;
+    std::size_t position = 0;
+    for (auto start = line.find(token_start); start != std::string::npos; start = line.find(token_start, position)) {
+      result.append(line, position, start - position);
+      const auto id_start = start + token_start.size();
+      const auto end = line.find(token_delimiter, id_start);
+      result += std::to_string(emitted_index[std::stoull(line.substr(id_start, end - id_start))]);
+      position = end + 1;
     }
+    result.append(line, position);
+    return result;
   }
 
   std::uint32_t get_pool_index(const nlohmann::ordered_json &value) const { return value_to_index.at(value); }
@@ -310,6 +486,17 @@ enum class ObjectLayout {
   IndexedPerfectHashBlobByReference,
 };
 
+// Sizes of the runtime types the layouts are made of, in the char build the cost model assumes.
+constexpr std::size_t pair_size = sizeof(json2cpp::basic_value_pair_t<char>);
+constexpr std::size_t compact_pair_size = sizeof(json2cpp::basic_compact_value_pair_t<char>);
+constexpr std::size_t key_descriptor_size = sizeof(json2cpp::basic_key_descriptor<char>);
+constexpr std::size_t ref_pair_size = sizeof(json2cpp::basic_ref_value_pair_t<char>);
+constexpr std::size_t blob_pair_size = sizeof(json2cpp::basic_blob_ref_value_pair_t<char>);
+constexpr std::size_t indexed_pair_size = sizeof(json2cpp::basic_indexed_blob_ref_value_pair_t<char>);
+constexpr std::size_t mphf_object_size = sizeof(json2cpp::detail::basic_mphf8_blob_ref_object_t<char>);
+constexpr std::size_t indexed_mphf_object_size = sizeof(json2cpp::detail::basic_indexed_mphf8_blob_ref_object_t<char>);
+constexpr std::size_t json_size = sizeof(json2cpp::basic_json<char>);
+
 struct KeyLayoutTracker
 {
   std::unordered_map<std::string, std::size_t, StringHash, std::equal_to<>> layout_counts;
@@ -353,23 +540,26 @@ struct KeyLayoutTracker
   {
     if (!value.is_object() || value.empty()) return 0.0;
 
+    constexpr auto entry_savings = static_cast<double>(pair_size - compact_pair_size);
+    constexpr auto descriptor_size = static_cast<double>(key_descriptor_size);
     double key_savings = 0.0;
     for (auto itr = value.begin(); itr != value.end(); ++itr) {
       const auto key_count = static_cast<double>(key_use_count(itr.key()));
       if (key_count == 0.0) return -1.0;
-      key_savings += 8.0 - (16.0 / key_count);
+      key_savings += entry_savings - (descriptor_size / key_count);
     }
 
     const auto layout_count = static_cast<double>(layout_counts.at(make_layout_signature(value)));
-    const auto layout_savings = static_cast<double>(value.size()) * ((layout_count * 8.0) - 16.0);
+    const auto layout_savings = static_cast<double>(value.size()) * ((layout_count * entry_savings) - descriptor_size);
     return std::max(key_savings, layout_savings);
   }
 
-  std::string ensure_key_definition(const std::string &key, std::vector<std::string> &lines)
+  template<typename Formatter>
+  std::string ensure_key_definition(const std::string &key, std::vector<std::string> &lines, Formatter &&format_key)
   {
     auto [it, _] = key_to_var.try_emplace(key, fmt::format("k{}", counter++));
     if (emitted_keys.insert(key).second) {
-      lines.emplace_back(fmt::format("constexpr key_descriptor_t {}{{{}}};", it->second, format_json_string(key)));
+      lines.emplace_back(fmt::format("constexpr key_descriptor_t {}{{{}}};", it->second, format_key(key)));
     }
     return it->second;
   }
@@ -392,6 +582,8 @@ struct Mphf8Plan
   std::uint8_t bucket_count = 0;
   std::uint8_t seed1 = 0;
   std::uint8_t seed2 = 0;
+  // Bucket count and seed pairs tried until this plan was found, or until the search gave up.
+  std::size_t attempts = 0;
 };
 
 struct Mphf8TableInfo
@@ -415,6 +607,495 @@ void analyze_json(const nlohmann::ordered_json &value, TrackerSet &trackers)
   }
 }
 
+// Strings that fit the inline storage of a json node in both encodings never need backing text.
+bool fits_short_string(std::string_view str) { return str.size() <= 8 && utf16_length(str) <= 4; }
+
+struct StringArena
+{
+  struct Placement
+  {
+    std::size_t chunk = 0;
+    std::size_t offset = 0;
+    std::size_t utf16_offset = 0;
+  };
+
+  struct Chunk
+  {
+    std::vector<std::size_t> pieces;
+    std::size_t size = 0;
+    std::size_t utf16_size = 0;
+  };
+
+  // Each chunk becomes one literal, kept well below the 64KiB MSVC concatenated literal limit.
+  static constexpr std::size_t max_chunk_size = 16384;
+  // References are resolved once every string is placed. A raw newline never survives escape_string(), so it
+  // cannot collide with string contents on the same line.
+  static constexpr char token_delimiter = '\n';
+
+  std::unordered_map<std::string, std::size_t, StringHash, std::equal_to<>> string_ids;
+  std::vector<std::string> strings;
+  std::vector<Placement> placements;
+  std::vector<Chunk> chunks;
+  std::size_t merged_count = 0;
+
+  std::size_t intern(std::string_view str)
+  {
+    const auto [it, inserted] = string_ids.try_emplace(std::string(str), strings.size());
+    if (inserted) strings.emplace_back(str);
+    return it->second;
+  }
+
+  std::string view_reference(std::string_view str)
+  {
+    return fmt::format("{}V{}{}", token_delimiter, intern(str), token_delimiter);
+  }
+  std::string pointer_reference(std::string_view str)
+  {
+    return fmt::format("{}P{}{}", token_delimiter, intern(str), token_delimiter);
+  }
+
+  void finalize()
+  {
+    // Sorting by reversed text puts every string right after the longest string it is a suffix of, so a single
+    // pass finds all tail merges; exact duplicates were already folded by intern().
+    std::vector<std::size_t> order(strings.size());
+    for (std::size_t i = 0; i < order.size(); ++i) order[i] = i;
+    std::sort(order.begin(), order.end(), [&](const std::size_t lhs, const std::size_t rhs) {
+      return std::lexicographical_compare(
+        strings[rhs].rbegin(), strings[rhs].rend(), strings[lhs].rbegin(), strings[lhs].rend());
+    });
+
+    placements.assign(strings.size(), {});
+    std::size_t container = strings.size();
+    for (const auto index : order) {
+      const auto &str = strings[index];
+      if (container != strings.size() && strings[container].ends_with(str)) {
+        const auto &outer = placements[container];
+        placements[index] = { outer.chunk,
+          outer.offset + strings[container].size() - str.size(),
+          outer.utf16_offset + utf16_length(strings[container]) - utf16_length(str) };
+        ++merged_count;
+        continue;
+      }
+
+      if (chunks.empty() || (chunks.back().size != 0 && chunks.back().size + str.size() > max_chunk_size))
+        chunks.emplace_back();
+      auto &chunk = chunks.back();
+      placements[index] = { chunks.size() - 1, chunk.size, chunk.utf16_size };
+      chunk.pieces.emplace_back(index);
+      chunk.size += str.size();
+      chunk.utf16_size += utf16_length(str);
+      container = index;
+    }
+  }
+
+  void emit_definitions(std::vector<std::string> &lines) const
+  {
+    for (std::size_t i = 0; i < chunks.size(); ++i) {
+      lines.emplace_back(fmt::format("  constexpr basicType t{}[] = J2C(", i));
+      for (const auto index : chunks[i].pieces) lines.emplace_back(fmt::format("    \"{}\"", escape_string(strings[index])));
+      lines.emplace_back("  );");
+    }
+  }
+
+  std::string resolve(const std::string &line) const
+  {
+    if (line.find(token_delimiter) == std::string::npos) return line;
+
+    std::string result;
+    std::size_t position = 0;
+    for (auto start = line.find(token_delimiter); start != std::string::npos;
+         start = line.find(token_delimiter, position)) {
+      result.append(line, position, start - position);
+      const auto kind = line[start + 1];
+      const auto id_start = start + 2;
+      const auto end = line.find(token_delimiter, id_start);
+      const auto index = static_cast<std::size_t>(std::stoull(line.substr(id_start, end - id_start)));
+      const auto &placement = placements[index];
+      const auto &str = strings[index];
+      if (kind == 'P') {
+        result += fmt::format("J2T({}, {}, {})", placement.chunk, placement.offset, placement.offset - placement.utf16_offset);
+      } else {
+        result += fmt::format("J2S({}, {}, {}, {}, {})",
+          placement.chunk,
+          placement.offset,
+          placement.offset - placement.utf16_offset,
+          str.size(),
+          str.size() - utf16_length(str));
+      }
+      position = end + 1;
+    }
+    result.append(line, position);
+    return result;
+  }
+
+  std::size_t total_size() const
+  {
+    std::size_t total = 0;
+    for (const auto &str : strings) total += str.size();
+    return total;
+  }
+
+  std::size_t arena_size() const
+  {
+    std::size_t total = 0;
+    for (const auto &chunk : chunks) total += chunk.size;
+    return total;
+  }
+};
+
+struct StringCompressor
+{
+  std::size_t min_size = 0;
+  std::unordered_map<std::string, std::string, StringHash, std::equal_to<>> string_reprs;
+  std::vector<std::string> lines;
+  std::size_t counter = 0;
+  std::size_t raw_bytes = 0;
+  std::size_t compressed_bytes = 0;
+
+  static void emit_bytes(const std::string &name, const std::vector<std::uint8_t> &bytes, std::vector<std::string> &out)
+  {
+    out.emplace_back(fmt::format("  constexpr std::uint8_t {}[] = {{", name));
+    for (std::size_t i = 0; i < bytes.size(); i += 32) {
+      std::string line = "    ";
+      for (auto j = i; j < std::min(bytes.size(), i + 32); ++j) line += fmt::format("{},", bytes[j]);
+      out.emplace_back(std::move(line));
+    }
+    out.emplace_back("  };");
+  }
+
+  // Returns the compressed_t initializer for str, or an empty string when it should stay plain.
+  std::string reference(const std::string &str)
+  {
+    if (min_size == 0 || str.size() <= min_size) return {};
+    if (const auto it = string_reprs.find(str); it != string_reprs.end()) return it->second;
+
+    std::vector<std::uint32_t> utf8_units(str.begin(), str.end());
+    for (auto &unit : utf8_units) unit &= 0xFFu;
+    const auto utf16 = utf16_units(str);
+    const auto utf8_bytes = lz_compress(utf8_units, 1);
+    const auto utf16_bytes = lz_compress(utf16, 2);
+    if (utf8_bytes.size() >= str.size() || utf16_bytes.size() >= utf16.size() * 2) {
+      return string_reprs.emplace(str, std::string{}).first->second;
+    }
+
+    const auto name = fmt::format("c{}", counter++);
+    lines.emplace_back("  #ifdef JSON2CPP_USE_UTF16");
+    emit_bytes(name, utf16_bytes, lines);
+    lines.emplace_back("  #else");
+    emit_bytes(name, utf8_bytes, lines);
+    lines.emplace_back("  #endif");
+    raw_bytes += str.size();
+    compressed_bytes += utf8_bytes.size();
+
+    return string_reprs
+      .emplace(str,
+        fmt::format("compressed_t{{{}, J2D({}, {}), J2H({}, {})}}",
+          name,
+          str.size(),
+          str.size() - utf16.size(),
+          hash_utf8(str),
+          hash_utf16(str)))
+      .first->second;
+  }
+};
+
+// Access counts written by json2cpp::write_access_profile, folded onto distinct container values so that every
+// occurrence of a deduplicated subtree contributes to the single copy that is emitted.
+struct AccessProfile
+{
+  std::unordered_map<std::string, std::uint64_t> pointer_counts;
+  std::unordered_map<nlohmann::ordered_json, std::uint64_t, JsonHasher, JsonEqual> node_counts;
+  std::unordered_map<nlohmann::ordered_json,
+    std::unordered_map<std::string, std::uint64_t, StringHash, std::equal_to<>>,
+    JsonHasher,
+    JsonEqual>
+    entry_counts;
+  std::size_t matched_count = 0;
+
+  static void append_pointer_token(std::string &path, std::string_view key)
+  {
+    path += '/';
+    for (const char c : key) {
+      if (c == '~') {
+        path += "~0";
+      } else if (c == '/') {
+        path += "~1";
+      } else {
+        path += c;
+      }
+    }
+  }
+
+  void load(const std::filesystem::path &filename)
+  {
+    std::ifstream input(filename);
+    if (!input) throw std::runtime_error(fmt::format("Unable to open profile '{}'", filename.string()));
+    std::string line;
+    while (std::getline(input, line)) {
+      if (line.empty() || line.front() == '#') continue;
+      const auto separator = line.find(' ');
+      if (separator == std::string::npos) continue;
+      pointer_counts[line.substr(separator + 1)] += std::stoull(line.substr(0, separator));
+    }
+  }
+
+  void resolve(const nlohmann::ordered_json &value, std::string &path)
+  {
+    if (!value.is_object() && !value.is_array()) return;
+    if (path.empty() && pointer_counts.contains(path)) ++matched_count;
+    if (const auto it = pointer_counts.find(path); it != pointer_counts.end()) node_counts[value] += it->second;
+
+    const auto path_size = path.size();
+    if (value.is_object()) {
+      for (auto itr = value.begin(); itr != value.end(); ++itr) {
+        append_pointer_token(path, itr.key());
+        if (const auto it = pointer_counts.find(path); it != pointer_counts.end()) {
+          entry_counts[value][itr.key()] += it->second;
+          ++matched_count;
+        }
+        resolve(itr.value(), path);
+        path.resize(path_size);
+      }
+    } else {
+      for (std::size_t i = 0; i < value.size(); ++i) {
+        path += '/';
+        path += std::to_string(i);
+        if (pointer_counts.contains(path)) ++matched_count;
+        resolve(value[i], path);
+        path.resize(path_size);
+      }
+    }
+  }
+
+  bool is_hot(const nlohmann::ordered_json &value) const
+  {
+    return !node_counts.empty() && node_counts.contains(value);
+  }
+
+  std::uint64_t entry_count(const nlohmann::ordered_json &value, std::string_view key) const
+  {
+    const auto entries = entry_counts.find(value);
+    if (entries == entry_counts.end()) return 0;
+    const auto it = entries->second.find(key);
+    return it == entries->second.end() ? 0 : it->second;
+  }
+};
+
+std::string_view layout_name(const ObjectLayout layout)
+{
+  switch (layout) {
+  case ObjectLayout::Regular:
+    return "regular";
+  case ObjectLayout::CompactInline:
+    return "compact-inline";
+  case ObjectLayout::ValueByReference:
+    return "value-ref";
+  case ObjectLayout::BlobByReference:
+    return "blob-ref";
+  case ObjectLayout::PerfectHashBlobByReference:
+    return "perfect-hash";
+  case ObjectLayout::IndexedPerfectHashBlobByReference:
+    return "indexed-perfect-hash";
+  }
+  return "regular";
+}
+
+// Layout --object-layout asks for; the automatic choice has none and maps to Regular.
+ObjectLayout forced_object_layout(const object_layout forced)
+{
+  switch (forced) {
+  case object_layout::automatic:
+  case object_layout::regular:
+    return ObjectLayout::Regular;
+  case object_layout::compact_inline:
+    return ObjectLayout::CompactInline;
+  case object_layout::value_by_reference:
+    return ObjectLayout::ValueByReference;
+  case object_layout::blob_by_reference:
+    return ObjectLayout::BlobByReference;
+  case object_layout::perfect_hash:
+    return ObjectLayout::PerfectHashBlobByReference;
+  case object_layout::indexed_perfect_hash:
+    return ObjectLayout::IndexedPerfectHashBlobByReference;
+  }
+  return ObjectLayout::Regular;
+}
+
+// Layout decisions and sizes of the emitted objects, written by --report. Objects are identified by the JSON pointer
+// of their first occurrence; the tables of --schema are not part of the document and have no pointer.
+struct LayoutReport
+{
+  std::unordered_map<const nlohmann::ordered_json *, std::string> paths;
+  nlohmann::ordered_json objects = nlohmann::ordered_json::array();
+
+  void collect_paths(const nlohmann::ordered_json &value, std::string &path)
+  {
+    const auto path_size = path.size();
+    if (value.is_object()) {
+      paths.try_emplace(&value, path);
+      for (auto itr = value.begin(); itr != value.end(); ++itr) {
+        AccessProfile::append_pointer_token(path, itr.key());
+        collect_paths(itr.value(), path);
+        path.resize(path_size);
+      }
+    } else if (value.is_array()) {
+      for (std::size_t i = 0; i < value.size(); ++i) {
+        path += '/';
+        path += std::to_string(i);
+        collect_paths(value[i], path);
+        path.resize(path_size);
+      }
+    }
+  }
+
+  nlohmann::ordered_json path_of(const nlohmann::ordered_json &value) const
+  {
+    const auto it = paths.find(&value);
+    return it == paths.end() ? nlohmann::ordered_json() : nlohmann::ordered_json(it->second);
+  }
+
+  nlohmann::ordered_json layout_totals() const
+  {
+    auto totals = nlohmann::ordered_json::object();
+    for (const auto layout : { ObjectLayout::Regular,
+           ObjectLayout::CompactInline,
+           ObjectLayout::ValueByReference,
+           ObjectLayout::BlobByReference,
+           ObjectLayout::PerfectHashBlobByReference,
+           ObjectLayout::IndexedPerfectHashBlobByReference }) {
+      totals[std::string(layout_name(layout))] = { { "objects", 0 }, { "members", 0 }, { "bytes", 0 } };
+    }
+    for (const auto &object : objects) {
+      auto &total = totals[object["layout"].get<std::string>()];
+      total["objects"] = total["objects"].get<std::size_t>() + 1;
+      total["members"] = total["members"].get<std::size_t>() + object["members"].get<std::size_t>();
+      total["bytes"] = total["bytes"].get<std::size_t>() + object["bytes"].get<std::size_t>();
+    }
+    return totals;
+  }
+};
+
+// Node definitions collected one block per d{n} so they can be written in an order other than the post-order the
+// recursive emission produces. Definitions shared by many nodes (k{n}, h{n}) go to the prelude instead.
+struct NodeBlocks
+{
+  static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+  struct Block
+  {
+    std::vector<std::string> lines;
+    std::vector<std::size_t> references;
+  };
+
+  std::vector<Block> blocks;
+  std::vector<std::string> prelude;
+  std::vector<std::size_t> roots;
+  std::unordered_map<std::string, std::size_t, StringHash, std::equal_to<>> shared_blocks;
+  std::size_t current = npos;
+
+  void add_reference(const std::size_t block)
+  {
+    auto &references = current == npos ? roots : blocks[current].references;
+    if (std::ranges::find(references, block) == references.end()) references.push_back(block);
+  }
+
+  // Top-down visiting order; every block appears once, under the first node that references it.
+  std::vector<std::size_t> top_down_order(const layout_order order) const
+  {
+    std::vector<std::size_t> result;
+    std::vector<char> seen(blocks.size(), 0);
+    if (order == layout_order::bfs) {
+      std::vector<std::size_t> queue;
+      for (const auto root : roots) {
+        if (!std::exchange(seen[root], 1)) queue.push_back(root);
+      }
+      for (std::size_t i = 0; i < queue.size(); ++i) {
+        for (const auto child : blocks[queue[i]].references) {
+          if (!std::exchange(seen[child], 1)) queue.push_back(child);
+        }
+      }
+      return queue;
+    }
+
+    // Spanning tree of first references, shared by the depth-first and van Emde Boas orders.
+    std::vector<std::vector<std::size_t>> children(blocks.size());
+    std::vector<std::size_t> tree_roots;
+    const auto build = [&](const auto &self, const std::size_t block) -> void {
+      for (const auto child : blocks[block].references) {
+        if (std::exchange(seen[child], 1)) continue;
+        children[block].push_back(child);
+        self(self, child);
+      }
+    };
+    for (const auto root : roots) {
+      if (std::exchange(seen[root], 1)) continue;
+      tree_roots.push_back(root);
+      build(build, root);
+    }
+
+    const auto preorder = [&](const auto &self, const std::size_t block) -> void {
+      result.push_back(block);
+      for (const auto child : children[block]) self(self, child);
+    };
+    if (order == layout_order::dfs_preorder) {
+      for (const auto root : tree_roots) preorder(preorder, root);
+      return result;
+    }
+
+    std::vector<std::size_t> heights(blocks.size(), 0);
+    const auto height = [&](const auto &self, const std::size_t block) -> std::size_t {
+      std::size_t max_child = 0;
+      for (const auto child : children[block]) max_child = std::max(max_child, self(self, child));
+      return heights[block] = max_child + 1;
+    };
+    const auto collect_at_depth = [&](const auto &self,
+                                    const std::size_t block,
+                                    const std::size_t depth,
+                                    std::vector<std::size_t> &out) -> void {
+      if (depth == 0) {
+        out.push_back(block);
+        return;
+      }
+      for (const auto child : children[block]) self(self, child, depth - 1, out);
+    };
+    // Lay out the top half of the levels recursively, then each subtree hanging below it.
+    const auto van_emde_boas = [&](const auto &self, const std::size_t block, const std::size_t levels) -> void {
+      if (levels <= 1 || children[block].empty()) {
+        if (levels <= 1) {
+          result.push_back(block);
+        } else {
+          self(self, block, 1);
+        }
+        return;
+      }
+      const auto top = levels / 2;
+      self(self, block, top);
+      std::vector<std::size_t> bottoms;
+      collect_at_depth(collect_at_depth, block, top, bottoms);
+      for (const auto bottom : bottoms) self(self, bottom, levels - top);
+    };
+    for (const auto root : tree_roots) van_emde_boas(van_emde_boas, root, height(height, root));
+    return result;
+  }
+
+  // Definitions must follow everything they reference, so the top-down order is reversed and any block still
+  // missing a dependency (a subtree shared with a later parent) pulls that dependency in first.
+  std::vector<std::string> ordered_lines(const layout_order order) const
+  {
+    auto top_down = top_down_order(order);
+    std::vector<char> emitted(blocks.size(), 0);
+    std::vector<std::string> result = prelude;
+    const auto emit = [&](const auto &self, const std::size_t block) -> void {
+      if (std::exchange(emitted[block], 1)) return;
+      for (const auto reference : blocks[block].references) self(self, reference);
+      result.insert(result.end(), blocks[block].lines.begin(), blocks[block].lines.end());
+    };
+    for (auto it = top_down.rbegin(); it != top_down.rend(); ++it) emit(emit, *it);
+    return result;
+  }
+};
+
 struct EmitContext
 {
   struct LayoutUsage
@@ -425,6 +1106,7 @@ struct EmitContext
     bool uses_mphf8_blob_ref = false;
     bool uses_indexed_mphf8_blob_ref = false;
     bool uses_scalar_pool = false;
+    bool uses_key_filter = false;
   };
 
   std::size_t &node_count;
@@ -433,32 +1115,108 @@ struct EmitContext
   LayoutUsage &layout_usage;
   std::unordered_map<std::string, Mphf8TableInfo> mphf8_tables;
   std::size_t mphf8_table_count = 0;
+  // Key filter words by key layout signature, shared by the objects with the same keys.
+  std::unordered_map<std::string, std::string> key_filters{};
+  StringArena *string_arena = nullptr;
+  StringCompressor *string_compressor = nullptr;
+  const AccessProfile *profile = nullptr;
+  std::size_t hot_node_count = 0;
+  NodeBlocks *node_blocks = nullptr;
+  object_layout forced_layout = object_layout::automatic;
+  // Objects that could not take the forced layout, by the layout they got instead.
+  std::map<std::string_view, std::size_t> forced_layout_fallbacks{};
+  LayoutReport *report = nullptr;
+  optimization_goal goal = optimization_goal::size;
+  layout_thresholds thresholds{};
+  bool precompute_metadata = false;
+  // Define the node arrays, perfect-hash descriptors and indexed storage as constinit const rather than constexpr.
+  bool constinit_nodes = false;
+
+  std::vector<std::string> &shared_lines() { return node_blocks == nullptr ? lines : node_blocks->prelude; }
 };
 
+// The specifiers of a node definition, after its placement.
+std::string node_storage(const EmitContext &ctx) { return ctx.constinit_nodes ? "constinit const " : "constexpr "; }
+
+// Places the definition of an accessed node in the hot section so the working set stays on a few pages.
+std::string placement_prefix(const nlohmann::ordered_json &value, EmitContext &ctx)
+{
+  if (ctx.profile == nullptr || !ctx.profile->is_hot(value)) return {};
+  ++ctx.hot_node_count;
+  return "J2HOT ";
+}
+
+std::string format_string(const std::string &str, EmitContext &ctx)
+{
+  const auto view = ctx.string_arena == nullptr || fits_short_string(str) ? format_json_string(str)
+                                                                     : ctx.string_arena->view_reference(str);
+  if (!ctx.precompute_metadata) return view;
+  return fmt::format("json::prehashed_string({}, J2H({}, {}))", view, hash_utf8(str), hash_utf16(str));
+}
+
+std::string format_key_descriptor_string(const std::string &str, EmitContext &ctx)
+{
+  const auto view = ctx.string_arena == nullptr ? format_json_string(str) : ctx.string_arena->view_reference(str);
+  if (!ctx.precompute_metadata) return view;
+  return fmt::format("{}, J2H({}, {})", view, hash_utf8(str), hash_utf16(str));
+}
+
+// The sorted flag of an object with these keys, which differs between encodings when UTF-16 surrogates reorder keys.
+std::string format_sorted_flag(const nlohmann::ordered_json &value)
+{
+  bool utf8_sorted = true;
+  bool utf16_sorted = true;
+  for (auto itr = value.begin(); itr != value.end() && std::next(itr) != value.end(); ++itr) {
+    const auto &key = itr.key();
+    const auto &next = std::next(itr).key();
+    if (next < key) utf8_sorted = false;
+    if (utf16_units(next) < utf16_units(key)) utf16_sorted = false;
+  }
+  if (utf8_sorted == utf16_sorted) return utf8_sorted ? "true" : "false";
+  return fmt::format("J2H({}, {})", utf8_sorted, utf16_sorted);
+}
+
 std::string emit_value(const nlohmann::ordered_json &value, EmitContext &ctx);
 std::string emit_node_body(const nlohmann::ordered_json &value, EmitContext &ctx);
 
 template<typename Tracker, typename ValueEmitter>
 std::string ensure_emitted(Tracker &tracker,
   const nlohmann::ordered_json &value,
-  std::vector<std::string> &lines,
+  EmitContext &ctx,
   ValueEmitter emit_initializer)
 {
   const auto &var_name = tracker.get_var_name(value);
   if (!tracker.is_processed(var_name)) {
     tracker.mark_as_processed(var_name);
-    lines.emplace_back(fmt::format("constexpr auto {} = json{{{{ {} }}}};", var_name, emit_initializer()));
+    if (ctx.node_blocks == nullptr) {
+      ctx.lines.emplace_back(fmt::format("constexpr auto {} = json{{{{ {} }}}};", var_name, emit_initializer()));
+    } else {
+      // The shared json lives with the node it wraps so that every user depends on that one block.
+      const auto block = ctx.node_blocks->blocks.size();
+      const auto initializer = emit_initializer();
+      ctx.node_blocks->blocks[block].lines.emplace_back(
+        fmt::format("constexpr auto {} = json{{{{ {} }}}};", var_name, initializer));
+      ctx.node_blocks->shared_blocks.emplace(var_name, block);
+    }
+  } else if (ctx.node_blocks != nullptr) {
+    ctx.node_blocks->add_reference(ctx.node_blocks->shared_blocks.at(var_name));
   }
   return var_name;
 }
 
-std::string emit_scalar_value(const nlohmann::ordered_json &value)
+std::string emit_scalar_value(const nlohmann::ordered_json &value, EmitContext &ctx)
 {
   if (value.is_number_float()) return fmt::format("double{{{}}}", value.get<double>());
   if (value.is_number_unsigned()) return fmt::format("std::uint64_t{{{}}}", value.get<std::uint64_t>());
   if (value.is_number_integer()) return fmt::format("std::int64_t{{{}}}", value.get<std::int64_t>());
   if (value.is_boolean()) return fmt::format("bool{{{}}}", value.get<bool>());
-  if (value.is_string()) return format_json_string(value.get<std::string>());
+  if (value.is_string()) {
+    const auto &str = value.get_ref<const std::string &>();
+    if (ctx.string_compressor != nullptr) {
+      if (auto compressed = ctx.string_compressor->reference(str); !compressed.empty()) return compressed;
+    }
+    return format_string(str, ctx);
+  }
   if (value.is_null()) return "std::nullptr_t{}";
   return "unhandled";
 }
@@ -472,13 +1230,14 @@ std::pair<std::uint32_t, std::uint32_t> value_hashes(const nlohmann::ordered_jso
 
 double estimate_value_ref_entry_savings(const nlohmann::ordered_json &value, const EmitContext &ctx)
 {
-  if (value.is_object()) return ctx.trackers.object_tracker.is_shared(value) ? 8.0 : -1.0e18;
-  if (value.is_array()) return ctx.trackers.array_tracker.is_shared(value) ? 8.0 : -1.0e18;
+  constexpr auto entry_savings = static_cast<double>(pair_size - ref_pair_size);
+  if (value.is_object()) return ctx.trackers.object_tracker.is_shared(value) ? entry_savings : -1.0e18;
+  if (value.is_array()) return ctx.trackers.array_tracker.is_shared(value) ? entry_savings : -1.0e18;
   if (!ctx.trackers.scalar_tracker.is_shared(value)) return -1.0e18;
 
   const auto value_count = static_cast<double>(ctx.trackers.scalar_tracker.use_count(value));
   if (value_count == 0.0) return -1.0e18;
-  return 8.0 - (16.0 / value_count);
+  return entry_savings - (static_cast<double>(json_size) / value_count);
 }
 
 bool can_use_indexed_mphf_values(const nlohmann::ordered_json &value, const EmitContext &ctx)
@@ -487,7 +1246,7 @@ bool can_use_indexed_mphf_values(const nlohmann::ordered_json &value, const Emit
   if (ctx.trackers.scalar_tracker.pooled_values.size() > 0xFFFFu) return false;
   std::size_t key_offset = 0;
   for (auto itr = value.begin(); itr != value.end(); ++itr) {
-    if (!itr.value().is_string() || !ctx.trackers.scalar_tracker.is_shared(itr.value())) return false;
+    if (!ctx.trackers.scalar_tracker.is_shared(itr.value())) return false;
     if (ctx.trackers.scalar_tracker.get_pool_index(itr.value()) > 0xFFu) return false;
     if (itr.key().size() > 0xFFu) return false;
     key_offset += itr.key().size();
@@ -573,11 +1332,22 @@ bool try_build_mphf8_plan(const std::vector<std::uint32_t> &hashes,
   return true;
 }
 
-bool build_mphf8_plan(const nlohmann::ordered_json &value, const bool utf16, Mphf8Plan &plan)
+// Entries the runtime scans before probing a perfect hash table when the prefix mask matches.
+constexpr std::size_t mphf_linear_prefix = 16;
+
+bool can_use_mphf(const nlohmann::ordered_json &value, const layout_thresholds &thresholds)
+{
+  return value.is_object() && value.size() >= std::max<std::size_t>(thresholds.min_mphf_size, 1)
+         && value.size() <= 0xFFu;
+}
+
+bool build_mphf8_plan(const nlohmann::ordered_json &value,
+  const bool utf16,
+  const layout_thresholds &thresholds,
+  Mphf8Plan &plan)
 {
-  constexpr std::size_t min_mphf_size = 64;
   constexpr std::size_t max_mphf_attempts = 1'000'000;
-  if (!value.is_object() || value.size() < min_mphf_size || value.size() > 0xFFu) return false;
+  if (!can_use_mphf(value, thresholds)) return false;
 
   std::vector<std::uint32_t> hashes;
   hashes.reserve(value.size());
@@ -593,7 +1363,8 @@ bool build_mphf8_plan(const nlohmann::ordered_json &value, const bool utf16, Mph
   for (std::uint16_t bucket_count = min_buckets; bucket_count <= size; ++bucket_count)
     for (std::uint16_t seed1 = 0; seed1 <= 0xFFu; ++seed1)
       for (std::uint16_t seed2 = 0; seed2 <= 0xFFu; ++seed2) {
-        if (++attempts > max_mphf_attempts) return false;
+        plan.attempts = ++attempts;
+        if (attempts > max_mphf_attempts) return false;
         if (try_build_mphf8_plan(hashes,
               plan,
               static_cast<std::uint8_t>(bucket_count),
@@ -636,18 +1407,49 @@ void emit_mphf8_table_arrays(const std::string &table_name,
   lines.emplace_back("#endif");
 }
 
-std::uint64_t make_mphf_prefix_mask(const nlohmann::ordered_json &value, const bool utf16)
+// Keys outside the mask skip the linear prefix and go straight to the table, which finds every key.
+std::uint64_t make_mphf_prefix_mask(const nlohmann::ordered_json &value,
+  const bool utf16,
+  const std::size_t prefix_keys,
+  const std::vector<std::uint8_t> &prefix_order = {})
 {
-  constexpr std::size_t linear_prefix = 16;
   std::uint64_t mask = 0;
   std::size_t index = 0;
-  for (auto itr = value.begin(); itr != value.end() && index < linear_prefix; ++itr, ++index) {
+  for (auto itr = value.begin(); itr != value.end(); ++itr, ++index) {
+    const bool in_prefix = prefix_order.empty() ? index < std::min(prefix_keys, mphf_linear_prefix)
+                                                : std::ranges::contains(prefix_order, index);
+    if (!in_prefix) continue;
     const auto hash = utf16 ? hash_utf16(itr.key()) : hash_utf8(itr.key());
     mask |= std::uint64_t{ 1 } << (hash & 63u);
   }
   return mask;
 }
 
+// Entries scanned before the table probe: the most accessed keys first, then the leading entries. Empty when the
+// profile has nothing for this object, which keeps the default leading-entry prefix.
+std::vector<std::uint8_t> make_hot_prefix_order(const nlohmann::ordered_json &value, const EmitContext &ctx)
+{
+  if (ctx.profile == nullptr) return {};
+  std::vector<std::pair<std::uint64_t, std::uint8_t>> counts;
+  std::uint8_t index = 0;
+  for (auto itr = value.begin(); itr != value.end(); ++itr, ++index) {
+    if (const auto count = ctx.profile->entry_count(value, itr.key()); count != 0) counts.emplace_back(count, index);
+  }
+  if (counts.empty()) return {};
+
+  std::ranges::stable_sort(counts, std::greater<>{}, &std::pair<std::uint64_t, std::uint8_t>::first);
+  std::vector<std::uint8_t> order;
+  const auto prefix_size = std::min(value.size(), mphf_linear_prefix);
+  for (const auto &entry : counts) {
+    if (order.size() == prefix_size) break;
+    order.push_back(entry.second);
+  }
+  for (std::uint8_t i = 0; order.size() < prefix_size; ++i) {
+    if (!std::ranges::contains(order, i)) order.push_back(i);
+  }
+  return order;
+}
+
 const Mphf8TableInfo &ensure_mphf8_table(const nlohmann::ordered_json &value,
   const Mphf8Plan &utf8_plan,
   const Mphf8Plan &utf16_plan,
@@ -658,21 +1460,29 @@ const Mphf8TableInfo &ensure_mphf8_table(const nlohmann::ordered_json &value,
     it->second.name = fmt::format("h{}", ctx.mphf8_table_count++);
     it->second.utf8 = utf8_plan;
     it->second.utf16 = utf16_plan;
-    emit_mphf8_table_arrays(it->second.name, it->second.utf8, it->second.utf16, ctx.lines);
+    emit_mphf8_table_arrays(it->second.name, it->second.utf8, it->second.utf16, ctx.shared_lines());
   }
   return it->second;
 }
 
+// key_filter names the object's key filter words, or is empty.
 void emit_mphf8_descriptor(const std::string &node_name,
   const std::size_t size,
   const std::uint64_t utf8_prefix_mask,
   const std::uint64_t utf16_prefix_mask,
   const Mphf8TableInfo &table,
+  const std::string &prefix_order,
+  const std::string &key_filter,
+  const std::string &placement,
+  const std::string &storage,
   std::vector<std::string> &lines)
 {
+  const auto filter = key_filter.empty() ? std::string() : fmt::format(", {}", key_filter);
   lines.emplace_back(fmt::format("extern const blob_pair_t {}[];", node_name));
   lines.emplace_back("#ifdef JSON2CPP_USE_UTF16");
-  lines.emplace_back(fmt::format("constexpr mphf8_blob_object_t {}_mphf{{{} + 2, {}, {}, {}, {}, {}, 0x{:016x}ull}};",
+  lines.emplace_back(fmt::format("{}{}mphf8_blob_object_t {}_mphf{{{} + 2, {}, {}, {}, {}, {}, 0x{:016x}ull, {}{}}};",
+    placement,
+    storage,
     node_name,
     node_name,
     table.name,
@@ -680,9 +1490,13 @@ void emit_mphf8_descriptor(const std::string &node_name,
     table.utf16.bucket_count,
     table.utf16.seed1,
     table.utf16.seed2,
-    utf16_prefix_mask));
+    utf16_prefix_mask,
+    prefix_order,
+    filter));
   lines.emplace_back("#else");
-  lines.emplace_back(fmt::format("constexpr mphf8_blob_object_t {}_mphf{{{} + 2, {}, {}, {}, {}, {}, 0x{:016x}ull}};",
+  lines.emplace_back(fmt::format("{}{}mphf8_blob_object_t {}_mphf{{{} + 2, {}, {}, {}, {}, {}, 0x{:016x}ull, {}{}}};",
+    placement,
+    storage,
     node_name,
     node_name,
     table.name,
@@ -690,7 +1504,9 @@ void emit_mphf8_descriptor(const std::string &node_name,
     table.utf8.bucket_count,
     table.utf8.seed1,
     table.utf8.seed2,
-    utf8_prefix_mask));
+    utf8_prefix_mask,
+    prefix_order,
+    filter));
   lines.emplace_back("#endif");
 }
 
@@ -699,12 +1515,19 @@ void emit_indexed_mphf8_descriptor(const std::string &node_name,
   const std::uint64_t utf8_prefix_mask,
   const std::uint64_t utf16_prefix_mask,
   const Mphf8TableInfo &table,
+  const std::string &prefix_order,
+  const std::string &key_filter,
+  const std::string &placement,
+  const std::string &storage,
   std::vector<std::string> &lines)
 {
+  const auto filter = key_filter.empty() ? std::string() : fmt::format(", {}", key_filter);
   lines.emplace_back("#ifdef JSON2CPP_USE_UTF16");
   lines.emplace_back(
-    fmt::format("constexpr indexed_mphf8_blob_object_t {}_mphf{{{}.entries.data(), {}_keys, s, {}.value_hashes.data(), "
-                "{}.prefix_hashes.data(), {}, {}, {}, {}, {}, 0x{:016x}ull}};",
+    fmt::format("{}{}indexed_mphf8_blob_object_t {}_mphf{{{}.entries.data(), {}_keys, s, "
+                "{}.value_hashes.data(), {}.prefix_hashes.data(), {}, {}, {}, {}, {}, 0x{:016x}ull, {}{}}};",
+      placement,
+      storage,
       node_name,
       node_name,
       node_name,
@@ -715,11 +1538,15 @@ void emit_indexed_mphf8_descriptor(const std::string &node_name,
       table.utf16.bucket_count,
       table.utf16.seed1,
       table.utf16.seed2,
-      utf16_prefix_mask));
+      utf16_prefix_mask,
+      prefix_order,
+      filter));
   lines.emplace_back("#else");
   lines.emplace_back(
-    fmt::format("constexpr indexed_mphf8_blob_object_t {}_mphf{{{}.entries.data(), {}_keys, s, {}.value_hashes.data(), "
-                "{}.prefix_hashes.data(), {}, {}, {}, {}, {}, 0x{:016x}ull}};",
+    fmt::format("{}{}indexed_mphf8_blob_object_t {}_mphf{{{}.entries.data(), {}_keys, s, "
+                "{}.value_hashes.data(), {}.prefix_hashes.data(), {}, {}, {}, {}, {}, 0x{:016x}ull, {}{}}};",
+      placement,
+      storage,
       node_name,
       node_name,
       node_name,
@@ -730,64 +1557,235 @@ void emit_indexed_mphf8_descriptor(const std::string &node_name,
       table.utf8.bucket_count,
       table.utf8.seed1,
       table.utf8.seed2,
-      utf8_prefix_mask));
+      utf8_prefix_mask,
+      prefix_order,
+      filter));
   lines.emplace_back("#endif");
 }
 
-ObjectLayout choose_object_layout(const nlohmann::ordered_json &value, const EmitContext &ctx)
+// Bytes each layout saves over the regular one, as estimated from key and value reuse; -1e18 when impossible.
+struct LayoutSavings
 {
-  if (!value.is_object() || value.empty()) return ObjectLayout::Regular;
-  if (value.size() <= 4 && ctx.trackers.key_tracker.layout_use_count(value) >= 12) return ObjectLayout::Regular;
+  double compact_inline = 0.0;
+  double value_ref = 0.0;
+  double blob_ref = -1.0e18;
+  bool value_ref_possible = false;
+};
 
-  const auto inline_savings = ctx.trackers.key_tracker.estimate_inline_object_savings(value);
-  double value_ref_savings = 0.0;
-  bool value_ref_possible = true;
+LayoutSavings estimate_layout_savings(const nlohmann::ordered_json &value, const EmitContext &ctx)
+{
+  LayoutSavings savings;
+  savings.compact_inline = ctx.trackers.key_tracker.estimate_inline_object_savings(value);
+  savings.value_ref_possible = true;
   for (auto itr = value.begin(); itr != value.end(); ++itr) {
     const auto value_entry_savings = estimate_value_ref_entry_savings(itr.value(), ctx);
     if (value_entry_savings < -1.0e17) {
-      value_ref_possible = false;
+      savings.value_ref_possible = false;
     } else {
-      value_ref_savings += value_entry_savings;
+      savings.value_ref += value_entry_savings;
     }
   }
 
-  const auto blob_ref_savings = value_ref_possible && can_use_blob_keys(value)
-                                  ? value_ref_savings + (static_cast<double>(value.size()) * 8.0) - 16.0
-                                  : -1.0e18;
-  if (blob_ref_savings >= ctx.trackers.key_tracker.min_compact_savings && blob_ref_savings > value_ref_savings
-      && blob_ref_savings > inline_savings)
-    return ObjectLayout::BlobByReference;
-  if (value_ref_possible && value_ref_savings >= ctx.trackers.key_tracker.min_compact_savings
-      && value_ref_savings > inline_savings)
-    return ObjectLayout::ValueByReference;
-  if (inline_savings >= ctx.trackers.key_tracker.min_compact_savings) return ObjectLayout::CompactInline;
-  return ObjectLayout::Regular;
+  if (savings.value_ref_possible && can_use_blob_keys(value))
+    savings.blob_ref = savings.value_ref + (static_cast<double>(value.size() * (ref_pair_size - blob_pair_size)))
+                       - static_cast<double>(blob_pair_size);
+  return savings;
 }
 
-std::string emit_value_reference(const nlohmann::ordered_json &value, EmitContext &ctx)
+// Expected cost of a successful lookup, in probes of a regular entry. Linear layouts scan half their entries on
+// average, perfect hashes half their linear prefix and then one slot. Compact entries reach their key through a
+// descriptor; blob entries are half a regular pair and compare a packed hash first, and the indexed prefix compares
+// 16-bit hashes only.
+double estimate_lookup_cost(const std::size_t size, const ObjectLayout layout)
 {
-  if (value.is_object() && ctx.trackers.object_tracker.is_shared(value)) {
-    return fmt::format(
-      "&{}", ensure_emitted(ctx.trackers.object_tracker, value, ctx.lines, [&] { return emit_node_body(value, ctx); }));
-  }
-
-  if (value.is_array() && ctx.trackers.array_tracker.is_shared(value)) {
-    return fmt::format(
-      "&{}", ensure_emitted(ctx.trackers.array_tracker, value, ctx.lines, [&] { return emit_node_body(value, ctx); }));
+  const auto scan = (static_cast<double>(size) + 1.0) / 2.0;
+  const auto prefix_scan = static_cast<double>(std::min(size, mphf_linear_prefix)) / 2.0;
+  switch (layout) {
+  case ObjectLayout::Regular:
+  case ObjectLayout::ValueByReference:
+    return scan;
+  case ObjectLayout::CompactInline:
+    return 1.5 * scan;
+  case ObjectLayout::BlobByReference:
+    return 0.75 * scan;
+  case ObjectLayout::PerfectHashBlobByReference:
+    return 0.75 * (prefix_scan + 1.0);
+  case ObjectLayout::IndexedPerfectHashBlobByReference:
+    return (0.25 * prefix_scan) + 1.0;
   }
-
-  ctx.layout_usage.uses_scalar_pool = true;
-  return fmt::format("&s[{}]", ctx.trackers.scalar_tracker.get_pool_index(value));
+  return scan;
 }
 
-std::string make_blob_literal(const nlohmann::ordered_json &value)
+// Work the compiler spends evaluating an object's definition: one unit per entry plus one per character hashed.
+// Inline pairs hash their key and string value in constexpr constructors; key descriptors and pooled values are
+// hashed once for all their uses; blob entries carry hashes computed here, but the indexed layout hashes its keys
+// again in make_indexed_blob_storage. With precomputed metadata nothing is hashed and only the entries are left.
+double estimate_constexpr_cost(const nlohmann::ordered_json &value, const ObjectLayout layout, const EmitContext &ctx)
 {
-  std::string result = "J2C(";
+  if (ctx.precompute_metadata) return static_cast<double>(value.size());
+  double cost = 0.0;
   for (auto itr = value.begin(); itr != value.end(); ++itr) {
-    result += fmt::format("\"{}\"", escape_string(itr.key()));
+    const auto key_chars = static_cast<double>(itr.key().size());
+    const auto value_chars =
+      itr.value().is_string() ? static_cast<double>(itr.value().get_ref<const std::string &>().size()) : 0.0;
+    const auto key_uses =
+      static_cast<double>(std::max<std::size_t>(1, ctx.trackers.key_tracker.key_use_count(itr.key())));
+    const auto value_uses = static_cast<double>(
+      std::max<std::size_t>(1, static_cast<std::size_t>(ctx.trackers.scalar_tracker.use_count(itr.value()))));
+    cost += 1.0;
+    switch (layout) {
+    case ObjectLayout::Regular:
+      cost += key_chars + value_chars;
+      break;
+    case ObjectLayout::CompactInline:
+      cost += (key_chars / key_uses) + value_chars;
+      break;
+    case ObjectLayout::ValueByReference:
+      cost += key_chars + (value_chars / value_uses);
+      break;
+    case ObjectLayout::IndexedPerfectHashBlobByReference:
+      cost += key_chars + (value_chars / value_uses);
+      break;
+    case ObjectLayout::BlobByReference:
+    case ObjectLayout::PerfectHashBlobByReference:
+      cost += value_chars / value_uses;
+      break;
+    }
   }
-  result += ")";
-  return value.empty() ? "J2C(\"\")" : result;
+  return cost;
+}
+
+struct GoalWeights
+{
+  double bytes = 1.0;
+  double probes = 0.0;
+  double constexpr_work = 0.0;
+};
+
+// Bytes stay in every goal so that equally fast or cheap layouts still resolve to the smaller one. Balanced weighs a
+// probe like half a regular entry and a hashed character like a quarter byte.
+GoalWeights goal_weights(const optimization_goal goal)
+{
+  switch (goal) {
+  case optimization_goal::lookup_speed:
+    return { 0.001, 1.0, 0.0 };
+  case optimization_goal::compile_time:
+    return { 0.001, 0.0, 1.0 };
+  case optimization_goal::balanced:
+    return { 1.0, static_cast<double>(pair_size) / 2.0, 0.25 };
+  case optimization_goal::size:
+    break;
+  }
+  return {};
+}
+
+// Lowest weighted cost among the layouts the object can take, for every goal but size. Blob objects are costed as the
+// perfect hash emit_object will build for them when they have enough members.
+ObjectLayout
+  cheapest_object_layout(const nlohmann::ordered_json &value, const LayoutSavings &savings, const EmitContext &ctx)
+{
+  const auto weights = goal_weights(ctx.goal);
+  const auto regular_bytes = static_cast<double>(value.size() * pair_size);
+  auto best = ObjectLayout::Regular;
+  auto best_cost = std::numeric_limits<double>::max();
+  const auto consider = [&](const ObjectLayout layout, const double bytes) {
+    const auto cost = (weights.bytes * bytes) + (weights.probes * estimate_lookup_cost(value.size(), layout))
+                      + (weights.constexpr_work * estimate_constexpr_cost(value, layout, ctx));
+    if (cost < best_cost) {
+      best = layout;
+      best_cost = cost;
+    }
+  };
+
+  consider(ObjectLayout::Regular, regular_bytes);
+  consider(ObjectLayout::CompactInline, regular_bytes - savings.compact_inline);
+  if (savings.value_ref_possible) consider(ObjectLayout::ValueByReference, regular_bytes - savings.value_ref);
+  if (savings.blob_ref > -1.0e17) {
+    if (can_use_mphf(value, ctx.thresholds)) {
+      // bucket displacements and slots, about 4 / 3 bytes per member
+      const auto table_bytes = static_cast<double>(value.size()) * 4.0 / 3.0;
+      if (can_use_indexed_mphf_values(value, ctx)) {
+        consider(ObjectLayout::IndexedPerfectHashBlobByReference,
+          regular_bytes - savings.blob_ref + static_cast<double>(indexed_mphf_object_size) + table_bytes);
+      } else {
+        consider(ObjectLayout::PerfectHashBlobByReference,
+          regular_bytes - savings.blob_ref + static_cast<double>(mphf_object_size) + table_bytes);
+      }
+    } else {
+      consider(ObjectLayout::BlobByReference, regular_bytes - savings.blob_ref);
+    }
+  }
+
+  if (best == ObjectLayout::PerfectHashBlobByReference || best == ObjectLayout::IndexedPerfectHashBlobByReference)
+    return ObjectLayout::BlobByReference;
+  return best;
+}
+
+ObjectLayout
+  choose_object_layout(const nlohmann::ordered_json &value, const LayoutSavings &savings, const EmitContext &ctx)
+{
+  if (!value.is_object() || value.empty()) return ObjectLayout::Regular;
+  if (ctx.forced_layout == object_layout::automatic && value.size() <= ctx.thresholds.small_object_size
+      && ctx.trackers.key_tracker.layout_use_count(value) >= ctx.thresholds.small_object_min_uses)
+    return ObjectLayout::Regular;
+
+  switch (ctx.forced_layout) {
+  case object_layout::automatic:
+    break;
+  case object_layout::regular:
+    return ObjectLayout::Regular;
+  case object_layout::compact_inline:
+    return ObjectLayout::CompactInline;
+  case object_layout::value_by_reference:
+    if (savings.value_ref_possible) return ObjectLayout::ValueByReference;
+    break;
+  // emit_object turns blob layouts into perfect hash ones when it can build the hash.
+  case object_layout::blob_by_reference:
+  case object_layout::perfect_hash:
+  case object_layout::indexed_perfect_hash:
+    if (savings.blob_ref > -1.0e17) return ObjectLayout::BlobByReference;
+    break;
+  }
+  // Hot objects favor lookup speed over size: large ones try for a perfect hash, the rest keep inline keys.
+  if (ctx.profile != nullptr && ctx.profile->is_hot(value)) {
+    return can_use_mphf(value, ctx.thresholds) && savings.blob_ref > -1.0e17 ? ObjectLayout::BlobByReference
+                                                                            : ObjectLayout::Regular;
+  }
+  if (ctx.goal != optimization_goal::size) return cheapest_object_layout(value, savings, ctx);
+  if (savings.blob_ref >= ctx.trackers.key_tracker.min_compact_savings && savings.blob_ref > savings.value_ref
+      && savings.blob_ref > savings.compact_inline)
+    return ObjectLayout::BlobByReference;
+  if (savings.value_ref_possible && savings.value_ref >= ctx.trackers.key_tracker.min_compact_savings
+      && savings.value_ref > savings.compact_inline)
+    return ObjectLayout::ValueByReference;
+  if (savings.compact_inline >= ctx.trackers.key_tracker.min_compact_savings) return ObjectLayout::CompactInline;
+  return ObjectLayout::Regular;
+}
+
+std::string emit_value_reference(const nlohmann::ordered_json &value, EmitContext &ctx)
+{
+  if (value.is_object() && ctx.trackers.object_tracker.is_shared(value)) {
+    return fmt::format(
+      "&{}", ensure_emitted(ctx.trackers.object_tracker, value, ctx, [&] { return emit_node_body(value, ctx); }));
+  }
+
+  if (value.is_array() && ctx.trackers.array_tracker.is_shared(value)) {
+    return fmt::format(
+      "&{}", ensure_emitted(ctx.trackers.array_tracker, value, ctx, [&] { return emit_node_body(value, ctx); }));
+  }
+
+  ctx.layout_usage.uses_scalar_pool = true;
+  return fmt::format("&s[{}]", ctx.trackers.scalar_tracker.index_reference(value));
+}
+
+std::string make_blob_literal(const nlohmann::ordered_json &value)
+{
+  std::string result = "J2C(";
+  for (auto itr = value.begin(); itr != value.end(); ++itr) {
+    result += fmt::format("\"{}\"", escape_string(itr.key()));
+  }
+  result += ")";
+  return value.empty() ? "J2C(\"\")" : result;
 }
 
 std::string scalar_pool_index(std::string_view value_ref)
@@ -807,12 +1805,100 @@ std::string join_strings(const std::vector<std::string> &values)
   return result;
 }
 
-std::string emit_uint8_std_array(const std::vector<std::uint8_t> &values)
+std::string emit_uint8_std_array(const std::vector<std::string> &values)
+{
+  return fmt::format("std::array<std::uint8_t, {}>{{{}}}", values.size(), join_strings(values));
+}
+
+// The words of the key filter over these keys, see json2cpp::detail::key_filter_probe().
+std::vector<std::uint64_t> make_key_filter(const nlohmann::ordered_json &value, const bool utf16)
+{
+  std::vector<std::uint64_t> words(json2cpp::detail::key_filter_words(value.size()));
+  for (auto itr = value.begin(); itr != value.end(); ++itr) {
+    const auto hash = utf16 ? hash_utf16(itr.key()) : hash_utf8(itr.key());
+    const auto probe = json2cpp::detail::key_filter_probe(hash, value.size());
+    words[probe.word] |= probe.bits;
+  }
+  return words;
+}
+
+// Emits the key filter of an object once for every object with the same keys, and returns its name.
+std::string ensure_key_filter(const nlohmann::ordered_json &value, EmitContext &ctx)
+{
+  auto [it, inserted] = ctx.key_filters.try_emplace(KeyLayoutTracker::make_layout_signature(value));
+  if (inserted) {
+    it->second = fmt::format("f{}", ctx.key_filters.size() - 1);
+    const auto utf8_words = make_key_filter(value, false);
+    const auto utf16_words = make_key_filter(value, true);
+    std::vector<std::string> words;
+    words.reserve(utf8_words.size());
+    for (std::size_t i = 0; i < utf8_words.size(); ++i) {
+      words.emplace_back(fmt::format("J2H(0x{:016x}u, 0x{:016x}u)", utf8_words[i], utf16_words[i]));
+    }
+    ctx.shared_lines().emplace_back(
+      fmt::format("constexpr std::uint64_t {}[] = {{{}}};", it->second, join_strings(words)));
+    ctx.layout_usage.uses_key_filter = true;
+  }
+  return it->second;
+}
+
+// Bytes of the key filter words and of the header entry or descriptor pointer leading to them.
+std::size_t key_filter_bytes(const std::size_t size, const ObjectLayout layout)
 {
-  std::vector<std::string> parts;
-  parts.reserve(values.size());
-  for (const auto value : values) parts.emplace_back(std::to_string(value));
-  return fmt::format("std::array<std::uint8_t, {}>{{{}}}", values.size(), join_strings(parts));
+  const auto words = json2cpp::detail::key_filter_words(size) * sizeof(std::uint64_t);
+  switch (layout) {
+  case ObjectLayout::Regular:
+    return words + pair_size;
+  case ObjectLayout::CompactInline:
+    return words + compact_pair_size;
+  case ObjectLayout::ValueByReference:
+    return words + ref_pair_size;
+  case ObjectLayout::BlobByReference:
+    return words + blob_pair_size;
+  default:
+    return words + sizeof(const std::uint64_t *);
+  }
+}
+
+// What json2cpp::detail::make_indexed_blob_storage computes, written out: the packed entries, the low byte of every
+// value's hash and the low 16 bits of the hashes of the keys scanned before the table, in scan order.
+void emit_indexed_blob_storage(const nlohmann::ordered_json &value,
+  const std::string &node_name,
+  const std::vector<std::string> &value_indices,
+  const std::vector<std::uint8_t> &prefix_order,
+  const std::string &placement,
+  const std::string &storage,
+  std::vector<std::string> &lines)
+{
+  std::vector<std::string> entries;
+  std::vector<std::string> value_hashes_low;
+  std::vector<std::string> key_hashes_low;
+  std::size_t key_offset = 0;
+  std::size_t utf16_key_offset = 0;
+  std::size_t index = 0;
+  for (auto itr = value.begin(); itr != value.end(); ++itr, ++index) {
+    const auto utf16_key_length = utf16_length(itr.key());
+    entries.emplace_back(fmt::format("indexed_pair_t{{J2D({}, {}), J2D({}, {}), 0, 0, {}}}",
+      key_offset,
+      key_offset - utf16_key_offset,
+      itr.key().size(),
+      itr.key().size() - utf16_key_length,
+      value_indices[index]));
+    const auto [value_hash_utf8, value_hash_utf16] = value_hashes(itr.value());
+    value_hashes_low.emplace_back(fmt::format("J2H({}, {})", value_hash_utf8 & 0xFFu, value_hash_utf16 & 0xFFu));
+    key_hashes_low.emplace_back(
+      fmt::format("J2H({}, {})", hash_utf8(itr.key()) & 0xFFFFu, hash_utf16(itr.key()) & 0xFFFFu));
+    key_offset += itr.key().size();
+    utf16_key_offset += utf16_key_length;
+  }
+  std::vector<std::string> prefix_hashes;
+  for (std::size_t i = 0; i < std::min<std::size_t>(value.size(), 16u); ++i)
+    prefix_hashes.push_back(key_hashes_low[prefix_order.empty() ? i : prefix_order[i]]);
+
+  lines.emplace_back(fmt::format("{}{}indexed_storage_t<{}> {}{{", placement, storage, value.size(), node_name));
+  lines.emplace_back(fmt::format("  {{ {} }},", join_strings(entries)));
+  lines.emplace_back(fmt::format("  {{ {} }},", join_strings(value_hashes_low)));
+  lines.emplace_back(fmt::format("  {{ {} }} }};", join_strings(prefix_hashes)));
 }
 
 std::string emit_blob_entry(const std::string &value_ref,
@@ -839,15 +1925,85 @@ std::string emit_blob_entry(const std::string &value_ref,
     value_hash_utf16);
 }
 
+// Size of the arrays and descriptors an object defines for itself in the char build, blob keys included. Strings
+// placed apart, key descriptors, pooled values, hash tables and child nodes are shared or counted on their own.
+std::size_t emitted_object_bytes(const nlohmann::ordered_json &value, const ObjectLayout layout)
+{
+  const auto size = value.size();
+  std::size_t key_bytes = 0;
+  for (auto itr = value.begin(); itr != value.end(); ++itr) key_bytes += itr.key().size();
+  switch (layout) {
+  case ObjectLayout::Regular:
+    return size * pair_size;
+  case ObjectLayout::CompactInline:
+    return size * compact_pair_size;
+  case ObjectLayout::ValueByReference:
+    return size * ref_pair_size;
+  case ObjectLayout::BlobByReference:
+    return ((size + 1) * blob_pair_size) + key_bytes;
+  case ObjectLayout::PerfectHashBlobByReference:
+    return ((size + 2) * blob_pair_size) + key_bytes + mphf_object_size;
+  case ObjectLayout::IndexedPerfectHashBlobByReference:
+    // entries and value hashes, then the 16-bit hashes of the linear prefix
+    return (size * (indexed_pair_size + 1)) + (std::min<std::size_t>(size, mphf_linear_prefix) * sizeof(std::uint16_t))
+           + key_bytes + indexed_mphf_object_size;
+  }
+  return 0;
+}
+
+nlohmann::ordered_json report_savings(const double savings)
+{
+  return savings < -1.0e17 ? nlohmann::ordered_json() : nlohmann::ordered_json(savings);
+}
+
+void report_object(const nlohmann::ordered_json &value,
+  const std::string &node_name,
+  const ObjectLayout layout,
+  const LayoutSavings &savings,
+  const Mphf8Plan &utf8_mphf,
+  const Mphf8Plan &utf16_mphf,
+  const std::vector<std::uint8_t> &prefix_order,
+  const std::size_t bytes,
+  LayoutReport &report)
+{
+  std::vector<std::string> keys;
+  for (auto itr = value.begin(); itr != value.end(); ++itr) keys.push_back(itr.key());
+  nlohmann::ordered_json hot_prefix;
+  for (const auto index : prefix_order) hot_prefix.push_back(keys[index]);
+  report.objects.push_back({ { "node", node_name },
+    { "path", report.path_of(value) },
+    { "members", value.size() },
+    { "layout", layout_name(layout) },
+    { "savings",
+      { { "compact-inline", report_savings(savings.compact_inline) },
+        { "value-ref", savings.value_ref_possible ? report_savings(savings.value_ref) : nlohmann::ordered_json() },
+        { "blob-ref", report_savings(savings.blob_ref) } } },
+    { "mphf",
+      { { "attempted", utf8_mphf.attempts != 0 },
+        { "built",
+          layout == ObjectLayout::PerfectHashBlobByReference
+            || layout == ObjectLayout::IndexedPerfectHashBlobByReference },
+        { "attempts", utf8_mphf.attempts + utf16_mphf.attempts } } },
+    { "hot_prefix", std::move(hot_prefix) },
+    { "bytes", bytes } });
+}
+
 std::string emit_object(const nlohmann::ordered_json &value, EmitContext &ctx, const std::string &node_name)
 {
-  auto layout = choose_object_layout(value, ctx);
+  const auto savings = estimate_layout_savings(value, ctx);
+  auto layout = choose_object_layout(value, savings, ctx);
   Mphf8Plan utf8_mphf, utf16_mphf;
-  const bool use_mphf = layout == ObjectLayout::BlobByReference && build_mphf8_plan(value, false, utf8_mphf)
-                        && build_mphf8_plan(value, true, utf16_mphf);
+  const bool use_mphf = layout == ObjectLayout::BlobByReference
+                        && ctx.forced_layout != object_layout::blob_by_reference
+                        && build_mphf8_plan(value, false, ctx.thresholds, utf8_mphf)
+                        && build_mphf8_plan(value, true, ctx.thresholds, utf16_mphf);
   if (use_mphf)
-    layout = can_use_indexed_mphf_values(value, ctx) ? ObjectLayout::IndexedPerfectHashBlobByReference
-                                                     : ObjectLayout::PerfectHashBlobByReference;
+    layout = ctx.forced_layout != object_layout::perfect_hash && can_use_indexed_mphf_values(value, ctx)
+               ? ObjectLayout::IndexedPerfectHashBlobByReference
+               : ObjectLayout::PerfectHashBlobByReference;
+  if (ctx.forced_layout != object_layout::automatic && !value.empty()
+      && layout != forced_object_layout(ctx.forced_layout))
+    ++ctx.forced_layout_fallbacks[layout_name(layout)];
 
   if (layout == ObjectLayout::CompactInline) ctx.layout_usage.uses_compact_inline = true;
   if (layout == ObjectLayout::ValueByReference) ctx.layout_usage.uses_value_ref = true;
@@ -859,21 +2015,61 @@ std::string emit_object(const nlohmann::ordered_json &value, EmitContext &ctx, c
     ctx.layout_usage.uses_scalar_pool = true;
   }
 
+  const bool use_key_filter =
+    ctx.thresholds.min_key_filter_size != 0 && value.size() >= ctx.thresholds.min_key_filter_size;
+  const auto key_filter = use_key_filter ? ensure_key_filter(value, ctx) : std::string();
+
+  const auto placement = placement_prefix(value, ctx);
+  const auto prefix_order = use_mphf ? make_hot_prefix_order(value, ctx) : std::vector<std::uint8_t>{};
+  const auto prefix_order_name = prefix_order.empty() ? std::string("nullptr") : fmt::format("{}_prefix", node_name);
+  if (ctx.report != nullptr) {
+    auto bytes = emitted_object_bytes(value, layout) + prefix_order.size();
+    if (use_mphf && !ctx.mphf8_tables.contains(KeyLayoutTracker::make_layout_signature(value)))
+      bytes += utf8_mphf.displacements.size() + utf8_mphf.slots.size();
+    if (use_key_filter) bytes += key_filter_bytes(value.size(), layout);
+    report_object(value, node_name, layout, savings, utf8_mphf, utf16_mphf, prefix_order, bytes, *ctx.report);
+  }
+  if (!prefix_order.empty()) {
+    ctx.lines.emplace_back(
+      fmt::format("constexpr std::uint8_t {}[] = {};", prefix_order_name, emit_uint8_array(prefix_order)));
+  }
+
   std::vector<std::string> entries;
-  entries.reserve(value.size()
-                  + (layout == ObjectLayout::PerfectHashBlobByReference ? 2u
-                     : layout == ObjectLayout::BlobByReference          ? 1u
-                                                                        : 0u));
+  entries.reserve(value.size() + 2u);
+  // The key filter header precedes the entries of the scan layouts; perfect-hash descriptors point to the filter.
+  if (use_key_filter) {
+    if (layout == ObjectLayout::Regular) {
+      entries.emplace_back(fmt::format("pair_t{{json::key_filter_header({}), {{}}}},", key_filter));
+    } else if (layout == ObjectLayout::CompactInline) {
+      entries.emplace_back(fmt::format("compact_pair_t{{nullptr, json::key_filter_header({})}},", key_filter));
+    } else if (layout == ObjectLayout::ValueByReference) {
+      entries.emplace_back(fmt::format("ref_pair_t{{json::key_filter_header({}), nullptr}},", key_filter));
+    } else if (layout == ObjectLayout::BlobByReference) {
+      entries.emplace_back(fmt::format("blob_pair_t{{{}, blob_pair_t::header_t{{}}}},", key_filter));
+    }
+  }
+  const auto first_entry = entries.size();
 
   if (layout == ObjectLayout::BlobByReference || layout == ObjectLayout::PerfectHashBlobByReference
       || layout == ObjectLayout::IndexedPerfectHashBlobByReference) {
-    ctx.lines.emplace_back(fmt::format("constexpr basicType {}_keys[] = {};", node_name, make_blob_literal(value)));
+    if (ctx.string_arena != nullptr) {
+      std::string blob;
+      for (auto itr = value.begin(); itr != value.end(); ++itr) blob += itr.key();
+      ctx.lines.emplace_back(
+        fmt::format("constexpr const basicType *{}_keys = {};", node_name, ctx.string_arena->pointer_reference(blob)));
+    } else {
+      ctx.lines.emplace_back(fmt::format("constexpr basicType {}_keys[] = {};", node_name, make_blob_literal(value)));
+    }
     if (layout == ObjectLayout::PerfectHashBlobByReference) {
       emit_mphf8_descriptor(node_name,
         value.size(),
-        make_mphf_prefix_mask(value, false),
-        make_mphf_prefix_mask(value, true),
+        make_mphf_prefix_mask(value, false, ctx.thresholds.mphf_prefix_keys, prefix_order),
+        make_mphf_prefix_mask(value, true, ctx.thresholds.mphf_prefix_keys, prefix_order),
         ensure_mphf8_table(value, utf8_mphf, utf16_mphf, ctx),
+        prefix_order_name,
+        key_filter,
+        placement,
+        node_storage(ctx),
         ctx.lines);
       entries.emplace_back(fmt::format("blob_pair_t{{&{}_mphf, blob_pair_t::header_t{{}}}},", node_name));
     }
@@ -882,10 +2078,14 @@ std::string emit_object(const nlohmann::ordered_json &value, EmitContext &ctx, c
     }
   }
 
+  const auto filtered_object = [&](std::string object) {
+    return use_key_filter ? fmt::format("json::key_filtered({})", object) : object;
+  };
+
   std::size_t key_offset = 0;
   std::size_t utf16_key_offset = 0;
   std::vector<std::string> indexed_lengths;
-  std::vector<std::uint8_t> indexed_value_indices;
+  std::vector<std::string> indexed_value_indices;
   if (layout == ObjectLayout::IndexedPerfectHashBlobByReference) {
     indexed_lengths.reserve(value.size());
     indexed_value_indices.reserve(value.size());
@@ -893,16 +2093,16 @@ std::string emit_object(const nlohmann::ordered_json &value, EmitContext &ctx, c
   for (auto itr = value.begin(); itr != value.end(); ++itr) {
     if (layout == ObjectLayout::CompactInline) {
       const auto value_repr = emit_value(itr.value(), ctx);
-      const auto key_name = ctx.trackers.key_tracker.ensure_key_definition(itr.key(), ctx.lines);
+      const auto key_name = ctx.trackers.key_tracker.ensure_key_definition(
+        itr.key(), ctx.shared_lines(), [&](const std::string &key) { return format_key_descriptor_string(key, ctx); });
       entries.emplace_back(fmt::format("compact_pair_t{{&{}, {}}},", key_name, value_repr));
     } else if (layout == ObjectLayout::ValueByReference) {
       entries.emplace_back(
-        fmt::format("ref_pair_t{{{}, {}}},", format_json_string(itr.key()), emit_value_reference(itr.value(), ctx)));
+        fmt::format("ref_pair_t{{{}, {}}},", format_string(itr.key(), ctx), emit_value_reference(itr.value(), ctx)));
     } else if (layout == ObjectLayout::IndexedPerfectHashBlobByReference) {
       const auto utf16_key_length = utf16_length(itr.key());
       indexed_lengths.emplace_back(fmt::format("J2D({}, {})", itr.key().size(), itr.key().size() - utf16_key_length));
-      indexed_value_indices.emplace_back(
-        static_cast<std::uint8_t>(ctx.trackers.scalar_tracker.get_pool_index(itr.value())));
+      indexed_value_indices.emplace_back(ctx.trackers.scalar_tracker.index_reference(itr.value()));
       key_offset += itr.key().size();
       utf16_key_offset += utf16_key_length;
     } else if (layout == ObjectLayout::BlobByReference || layout == ObjectLayout::PerfectHashBlobByReference) {
@@ -913,26 +2113,39 @@ std::string emit_object(const nlohmann::ordered_json &value, EmitContext &ctx, c
       utf16_key_offset += utf16_key_length;
     } else {
       entries.emplace_back(
-        fmt::format("pair_t{{{}, {}}},", format_json_string(itr.key()), emit_value(itr.value(), ctx)));
+        fmt::format("pair_t{{{}, {}}},", format_string(itr.key(), ctx), emit_value(itr.value(), ctx)));
     }
   }
 
   if (layout == ObjectLayout::IndexedPerfectHashBlobByReference) {
-    ctx.lines.emplace_back(
-      fmt::format("constexpr auto {} = json2cpp::detail::make_indexed_blob_storage({}_keys, std::array<std::uint16_t, "
-                  "{}>{{{}}}, {}, s);",
-        node_name,
-        node_name,
-        indexed_lengths.size(),
-        join_strings(indexed_lengths),
-        emit_uint8_std_array(indexed_value_indices)));
+    if (ctx.precompute_metadata) {
+      emit_indexed_blob_storage(
+        value, node_name, indexed_value_indices, prefix_order, placement, node_storage(ctx), ctx.lines);
+    } else {
+      ctx.lines.emplace_back(
+        fmt::format("{}constexpr auto {} = json2cpp::detail::make_indexed_blob_storage({}_keys, "
+                    "std::array<std::uint16_t, {}>{{{}}}, {}, s, {});",
+          placement,
+          node_name,
+          node_name,
+          indexed_lengths.size(),
+          join_strings(indexed_lengths),
+          emit_uint8_std_array(indexed_value_indices),
+          prefix_order_name));
+    }
     emit_indexed_mphf8_descriptor(node_name,
       value.size(),
-      make_mphf_prefix_mask(value, false),
-      make_mphf_prefix_mask(value, true),
+      make_mphf_prefix_mask(value, false, ctx.thresholds.mphf_prefix_keys, prefix_order),
+      make_mphf_prefix_mask(value, true, ctx.thresholds.mphf_prefix_keys, prefix_order),
       ensure_mphf8_table(value, utf8_mphf, utf16_mphf, ctx),
+      prefix_order_name,
+      key_filter,
+      placement,
+      node_storage(ctx),
       ctx.lines);
-    return fmt::format("&{}_mphf", node_name);
+    if (!ctx.precompute_metadata) return filtered_object(fmt::format("&{}_mphf", node_name));
+    return filtered_object(
+      fmt::format("json::prehashed_perfect_hash_object(&{}_mphf, {})", node_name, value.size()));
   }
 
   const auto entry_type =
@@ -940,18 +2153,28 @@ std::string emit_object(const nlohmann::ordered_json &value, EmitContext &ctx, c
     : layout == ObjectLayout::ValueByReference                                                      ? "ref_pair_t"
     : layout == ObjectLayout::BlobByReference || layout == ObjectLayout::PerfectHashBlobByReference ? "blob_pair_t"
                                                                                                     : "pair_t";
-  ctx.lines.emplace_back(fmt::format("constexpr {} {}[] = {{", entry_type, node_name));
+  ctx.lines.emplace_back(fmt::format("{}{}{} {}[] = {{", placement, node_storage(ctx), entry_type, node_name));
 
   for (const auto &entry : entries) { ctx.lines.emplace_back(fmt::format("  {}", entry)); }
   ctx.lines.emplace_back("};");
-  if (layout == ObjectLayout::PerfectHashBlobByReference) return fmt::format("&{}_mphf", node_name);
+  if (layout == ObjectLayout::PerfectHashBlobByReference) {
+    if (!ctx.precompute_metadata) return filtered_object(fmt::format("&{}_mphf", node_name));
+    return filtered_object(
+      fmt::format("json::prehashed_perfect_hash_object({} + 2, {})", node_name, value.size()));
+  }
   const auto object_type = layout == ObjectLayout::CompactInline      ? "compact_object_t"
                            : layout == ObjectLayout::ValueByReference ? "ref_value_object_t"
                            : layout == ObjectLayout::BlobByReference  ? "blob_object_t"
                                                                       : "object_t";
-  if (layout == ObjectLayout::BlobByReference)
-    return fmt::format("{}{{{} + 1, {}}}", object_type, node_name, value.size());
-  return fmt::format("{}{{{}}}", object_type, node_name);
+  const auto object = first_entry == 0 && layout != ObjectLayout::BlobByReference
+                        ? fmt::format("{}{{{}}}", object_type, node_name)
+                        : fmt::format("{}{{{} + {}, {}}}",
+                            object_type,
+                            node_name,
+                            first_entry + (layout == ObjectLayout::BlobByReference ? 1u : 0u),
+                            value.size());
+  if (!ctx.precompute_metadata) return filtered_object(object);
+  return filtered_object(fmt::format("json::prehashed_object({}, {})", object, format_sorted_flag(value)));
 }
 
 std::string emit_array(const nlohmann::ordered_json &value, EmitContext &ctx, const std::string &node_name)
@@ -960,7 +2183,8 @@ std::string emit_array(const nlohmann::ordered_json &value, EmitContext &ctx, co
   entries.reserve(value.size());
   for (const auto &child : value) { entries.emplace_back(fmt::format("{},", emit_value(child, ctx))); }
 
-  ctx.lines.emplace_back(fmt::format("constexpr json {}[] = {{", node_name));
+  ctx.lines.emplace_back(
+    fmt::format("{}{}json {}[] = {{", placement_prefix(value, ctx), node_storage(ctx), node_name));
   for (const auto &entry : entries) { ctx.lines.emplace_back(fmt::format("  {}", entry)); }
   ctx.lines.emplace_back("};");
   return fmt::format("array_t{{{}}}", node_name);
@@ -969,54 +2193,1197 @@ std::string emit_array(const nlohmann::ordered_json &value, EmitContext &ctx, co
 std::string emit_node_body(const nlohmann::ordered_json &value, EmitContext &ctx)
 {
   const std::string node_name = fmt::format("d{}", ctx.node_count++);
-  if (value.is_object()) return emit_object(value, ctx, node_name);
-  if (value.is_array()) return emit_array(value, ctx, node_name);
-  return {};
+  const auto emit = [&]() -> std::string {
+    if (value.is_object()) return emit_object(value, ctx, node_name);
+    if (value.is_array()) return emit_array(value, ctx, node_name);
+    return {};
+  };
+  if (ctx.node_blocks == nullptr) return emit();
+
+  auto &node_blocks = *ctx.node_blocks;
+  const auto block = node_blocks.blocks.size();
+  node_blocks.add_reference(block);
+  node_blocks.blocks.emplace_back();
+  const auto parent = std::exchange(node_blocks.current, block);
+  std::vector<std::string> outer_lines;
+  std::swap(outer_lines, ctx.lines);
+
+  auto repr = emit();
+
+  node_blocks.blocks[block].lines = std::move(ctx.lines);
+  ctx.lines = std::move(outer_lines);
+  node_blocks.current = parent;
+  return repr;
 }
 
 std::string emit_value(const nlohmann::ordered_json &value, EmitContext &ctx)
 {
   if (value.is_object() && ctx.trackers.object_tracker.is_shared(value)) {
-    return ensure_emitted(ctx.trackers.object_tracker, value, ctx.lines, [&] { return emit_node_body(value, ctx); });
+    return ensure_emitted(ctx.trackers.object_tracker, value, ctx, [&] { return emit_node_body(value, ctx); });
   }
 
   if (value.is_array() && ctx.trackers.array_tracker.is_shared(value)) {
-    return ensure_emitted(ctx.trackers.array_tracker, value, ctx.lines, [&] { return emit_node_body(value, ctx); });
+    return ensure_emitted(ctx.trackers.array_tracker, value, ctx, [&] { return emit_node_body(value, ctx); });
   }
 
   if (value.is_object() || value.is_array()) return emit_node_body(value, ctx);
-  return emit_scalar_value(value);
+  return emit_scalar_value(value, ctx);
 }
 
-TrackerSet build_trackers(const nlohmann::ordered_json &json)
+TrackerSet build_trackers(const nlohmann::ordered_json &json,
+  const std::vector<nlohmann::ordered_json> &extra = {},
+  const layout_thresholds &thresholds = {})
 {
   TrackerSet trackers;
+  trackers.object_tracker.min_size = thresholds.min_shared_object_size;
+  trackers.array_tracker.min_size = thresholds.min_shared_array_size;
+  trackers.scalar_tracker.min_references = std::max(thresholds.min_scalar_references, 2);
+  trackers.key_tracker.min_compact_savings = thresholds.min_compact_savings;
   analyze_json(json, trackers);
+  for (const auto &value : extra) analyze_json(value, trackers);
   trackers.object_tracker.prepare_variables();
   trackers.array_tracker.prepare_variables();
   trackers.scalar_tracker.prepare_variables();
   return trackers;
 }
 
-compile_results compile_impl(const std::string_view original_name, const nlohmann::ordered_json &json)
+// Flattens a JSON Schema into the nodes of a json2cpp::basic_schema_t (see json2cpp_schema.hpp for the matching
+// constants). Subschemas compiling to the same checks share a node. Property maps and string enums become objects
+// emitted like any other, so the large ones get the perfect hash layouts.
+struct SchemaCompiler
 {
-  const std::string document_name = sanitize_identifier(original_name);
-  auto trackers = build_trackers(json);
-  compile_results results;
+  static constexpr std::uint32_t no_node = 0xFFFFFFFFu;
+  static constexpr std::uint32_t unlimited = 0xFFFFFFFFu;
+  static constexpr std::size_t max_required = 64;
+  static constexpr std::size_t no_table = static_cast<std::size_t>(-1);
+
+  enum : std::uint8_t {
+    null_type = 1u << 0,
+    boolean_type = 1u << 1,
+    integer_type = 1u << 2,
+    number_type = 1u << 3,
+    string_type = 1u << 4,
+    array_type = 1u << 5,
+    object_type = 1u << 6,
+    any_type = 0x7fu,
+  };
 
+  enum : std::uint16_t {
+    has_minimum = 1u << 0,
+    has_maximum = 1u << 1,
+    exclusive_minimum = 1u << 2,
+    exclusive_maximum = 1u << 3,
+    has_multiple_of = 1u << 4,
+    has_enum = 1u << 5,
+  };
+
+  struct Node
+  {
+    std::uint8_t types = any_type;
+    std::uint16_t flags = 0;
+    std::uint32_t required_count = 0;
+    double minimum = 0.0;
+    double maximum = 0.0;
+    double multiple_of = 0.0;
+    std::uint32_t min_length = 0;
+    std::uint32_t max_length = unlimited;
+    std::uint32_t min_items = 0;
+    std::uint32_t max_items = unlimited;
+    std::uint32_t min_properties = 0;
+    std::uint32_t max_properties = unlimited;
+    std::size_t properties = no_table;
+    // pattern_kind enumerator name and subschema.
+    std::vector<std::pair<std::string, std::uint32_t>> pattern_properties;
+    std::uint32_t additional_properties = no_node;
+    std::uint32_t items = no_node;
+    std::size_t enum_strings = no_table;
+    std::size_t enum_values = no_table;
+    std::vector<std::uint32_t> all_of;
+    std::vector<std::uint32_t> any_of;
+    std::vector<std::uint32_t> one_of;
+    std::uint32_t not_node = no_node;
+
+    std::string signature() const
+    {
+      nlohmann::ordered_json patterns = nlohmann::ordered_json::array();
+      for (const auto &[kind, node] : pattern_properties) patterns.push_back({ kind, node });
+      return nlohmann::ordered_json{ types,
+        flags,
+        required_count,
+        minimum,
+        maximum,
+        multiple_of,
+        min_length,
+        max_length,
+        min_items,
+        max_items,
+        min_properties,
+        max_properties,
+        properties,
+        patterns,
+        additional_properties,
+        items,
+        enum_strings,
+        enum_values,
+        all_of,
+        any_of,
+        one_of,
+        not_node }
+        .dump();
+    }
+  };
+
+  std::vector<Node> nodes;
+  std::vector<nlohmann::ordered_json> tables;
+  std::unordered_map<std::string, std::uint32_t> node_indices;
+  std::unordered_map<std::string, std::size_t> table_indices;
+
+  // Keywords that constrain documents but have no table representation; accepting them silently would let invalid
+  // documents through.
+  static constexpr std::array<std::string_view, 17> unsupported_keywords{ "$ref",
+    "$dynamicRef",
+    "$recursiveRef",
+    "pattern",
+    "uniqueItems",
+    "contains",
+    "prefixItems",
+    "additionalItems",
+    "unevaluatedItems",
+    "unevaluatedProperties",
+    "propertyNames",
+    "dependencies",
+    "dependentRequired",
+    "dependentSchemas",
+    "if",
+    "then",
+    "else" };
+
+  [[noreturn]] static void fail(const std::string &path, std::string_view message)
+  {
+    throw std::runtime_error(fmt::format("Unsupported schema at '{}': {}", path.empty() ? "/" : path, message));
+  }
+
+  static double number(const nlohmann::ordered_json &value, const std::string &path, std::string_view keyword)
+  {
+    if (!value.is_number()) fail(path, fmt::format("'{}' must be a number", keyword));
+    return value.get<double>();
+  }
+
+  static std::uint32_t count(const nlohmann::ordered_json &value, const std::string &path, std::string_view keyword)
+  {
+    if (!value.is_number_unsigned() || value.get<std::uint64_t>() >= unlimited)
+      fail(path, fmt::format("'{}' must be a non-negative integer", keyword));
+    return value.get<std::uint32_t>();
+  }
+
+  static std::uint8_t type_bits(const nlohmann::ordered_json &value, const std::string &path)
+  {
+    if (value.is_array()) {
+      std::uint8_t types = 0;
+      for (const auto &type : value) types |= type_bits(type, path);
+      return types;
+    }
+    const auto name = value.is_string() ? value.get<std::string>() : std::string{};
+    if (name == "null") return null_type;
+    if (name == "boolean") return boolean_type;
+    if (name == "integer") return integer_type;
+    if (name == "number") return integer_type | number_type;
+    if (name == "string") return string_type;
+    if (name == "array") return array_type;
+    if (name == "object") return object_type;
+    fail(path, fmt::format("unknown type {}", value.dump()));
+  }
+
+  // Only the patterns matching any key or any key with a non-blank character are known; there is no regex engine.
+  static std::string pattern_kind(const std::string &pattern, const std::string &path)
+  {
+    if (pattern.empty() || pattern == ".*" || pattern == "^.*$") return "any";
+    if (pattern == "^.*\\S.*$" || pattern == "\\S") return "non_blank";
+    fail(path, fmt::format("patternProperties pattern '{}' is not supported", pattern));
+  }
+
+  std::size_t intern_table(nlohmann::ordered_json value)
+  {
+    if (value.empty()) return no_table;
+    const auto [found, inserted] = table_indices.try_emplace(value.dump(), tables.size());
+    if (inserted) tables.push_back(std::move(value));
+    return found->second;
+  }
+
+  void compile_root(const nlohmann::ordered_json &schema)
+  {
+    std::string path;
+    nodes.emplace_back();
+    nodes.front() = build(schema, path);
+  }
+
+  std::uint32_t compile(const nlohmann::ordered_json &schema, std::string &path)
+  {
+    auto node = build(schema, path);
+    auto signature = node.signature();
+    if (const auto found = node_indices.find(signature); found != node_indices.end()) return found->second;
+    const auto index = static_cast<std::uint32_t>(nodes.size());
+    nodes.push_back(std::move(node));
+    node_indices.emplace(std::move(signature), index);
+    return index;
+  }
+
+  std::uint32_t compile_at(const nlohmann::ordered_json &schema,
+    std::string &path,
+    std::string_view keyword,
+    std::string_view member = {})
+  {
+    const auto size = path.size();
+    AccessProfile::append_pointer_token(path, keyword);
+    if (!member.empty()) AccessProfile::append_pointer_token(path, member);
+    const auto index = compile(schema, path);
+    path.resize(size);
+    return index;
+  }
+
+  // A `true` subschema accepts everything, which is what no_node means where a subschema is optional.
+  std::uint32_t compile_optional(const nlohmann::ordered_json &schema, std::string &path, std::string_view keyword)
+  {
+    if (schema.is_boolean() && schema.get<bool>()) return no_node;
+    return compile_at(schema, path, keyword);
+  }
+
+  std::vector<std::uint32_t> compile_list(const nlohmann::ordered_json &schemas,
+    std::string &path,
+    std::string_view keyword)
+  {
+    if (!schemas.is_array() || schemas.empty()) fail(path, fmt::format("'{}' must be a non-empty array", keyword));
+    std::vector<std::uint32_t> result;
+    for (std::size_t i = 0; i < schemas.size(); ++i) {
+      const auto size = path.size();
+      AccessProfile::append_pointer_token(path, keyword);
+      result.push_back(compile_at(schemas[i], path, std::to_string(i)));
+      path.resize(size);
+    }
+    return result;
+  }
+
+  static void add_bound(Node &node,
+    const nlohmann::ordered_json &schema,
+    const std::string &path,
+    const bool lower)
+  {
+    const auto *name = lower ? "minimum" : "maximum";
+    const auto *exclusive_name = lower ? "exclusiveMinimum" : "exclusiveMaximum";
+    const auto has_flag = lower ? has_minimum : has_maximum;
+    const auto exclusive_flag = lower ? exclusive_minimum : exclusive_maximum;
+    auto &bound = lower ? node.minimum : node.maximum;
+
+    const auto inclusive = schema.find(name);
+    if (inclusive != schema.end()) {
+      bound = number(*inclusive, path, name);
+      node.flags |= has_flag;
+    }
+    const auto exclusive = schema.find(exclusive_name);
+    if (exclusive == schema.end()) return;
+    // Draft 4 spells exclusivity as a boolean modifying the inclusive bound.
+    if (exclusive->is_boolean()) {
+      if (exclusive->get<bool>() && inclusive != schema.end()) node.flags |= exclusive_flag;
+      return;
+    }
+    const auto value = number(*exclusive, path, exclusive_name);
+    if (inclusive == schema.end() || (lower ? value >= bound : value <= bound)) {
+      bound = value;
+      node.flags |= has_flag | exclusive_flag;
+    }
+  }
+
+  Node build(const nlohmann::ordered_json &schema, std::string &path)
+  {
+    Node node;
+    if (schema.is_boolean()) {
+      if (!schema.get<bool>()) node.types = 0;
+      return node;
+    }
+    if (!schema.is_object()) fail(path, "a schema must be an object or a boolean");
+    for (const auto keyword : unsupported_keywords) {
+      if (schema.contains(keyword)) fail(path, fmt::format("keyword '{}' is not supported", keyword));
+    }
+    const auto keyword = [&](std::string_view name) -> const nlohmann::ordered_json * {
+      const auto found = schema.find(name);
+      return found == schema.end() ? nullptr : &*found;
+    };
+
+    if (const auto *type = keyword("type")) node.types = type_bits(*type, path);
+
+    nlohmann::ordered_json enum_strings = nlohmann::ordered_json::object();
+    nlohmann::ordered_json enum_values = nlohmann::ordered_json::array();
+    const auto add_enum = [&](const nlohmann::ordered_json &value) {
+      if (value.is_string()) {
+        enum_strings[value.get<std::string>()] = nullptr;
+      } else {
+        enum_values.push_back(value);
+      }
+    };
+    if (const auto *values = keyword("enum")) {
+      if (!values->is_array()) fail(path, "'enum' must be an array");
+      node.flags |= has_enum;
+      for (const auto &value : *values) add_enum(value);
+    }
+    if (const auto *value = keyword("const")) {
+      if ((node.flags & has_enum) != 0) {
+        node.all_of.push_back(compile_at(nlohmann::ordered_json{ { "enum", { *value } } }, path, "const"));
+      } else {
+        node.flags |= has_enum;
+        add_enum(*value);
+      }
+    }
+    node.enum_strings = intern_table(std::move(enum_strings));
+    node.enum_values = intern_table(std::move(enum_values));
+
+    add_bound(node, schema, path, true);
+    add_bound(node, schema, path, false);
+    if (const auto *multiple_of = keyword("multipleOf")) {
+      node.multiple_of = number(*multiple_of, path, "multipleOf");
+      if (!(node.multiple_of > 0.0)) fail(path, "'multipleOf' must be positive");
+      node.flags |= has_multiple_of;
+    }
+
+    if (const auto *value = keyword("minLength")) node.min_length = count(*value, path, "minLength");
+    if (const auto *value = keyword("maxLength")) node.max_length = count(*value, path, "maxLength");
+    if (const auto *value = keyword("minItems")) node.min_items = count(*value, path, "minItems");
+    if (const auto *value = keyword("maxItems")) node.max_items = count(*value, path, "maxItems");
+    if (const auto *value = keyword("minProperties")) node.min_properties = count(*value, path, "minProperties");
+    if (const auto *value = keyword("maxProperties")) node.max_properties = count(*value, path, "maxProperties");
+
+    if (const auto *items = keyword("items")) {
+      if (items->is_array()) fail(path, "tuple 'items' is not supported");
+      node.items = compile_optional(*items, path, "items");
+    }
+
+    std::vector<std::string> required;
+    if (const auto *names = keyword("required")) {
+      if (!names->is_array()) fail(path, "'required' must be an array");
+      for (const auto &name : *names) {
+        if (!name.is_string()) fail(path, "'required' must list strings");
+        if (std::ranges::find(required, name.get<std::string>()) == required.end())
+          required.push_back(name.get<std::string>());
+      }
+      if (required.size() > max_required)
+        fail(path, fmt::format("{} required properties, at most {} are supported", required.size(), max_required));
+    }
+    node.required_count = static_cast<std::uint32_t>(required.size());
+    const auto required_slot = [&](const std::string &name) -> std::uint64_t {
+      const auto found = std::ranges::find(required, name);
+      return found == required.end() ? 0 : static_cast<std::uint64_t>(found - required.begin()) + 1;
+    };
+
+    // Values pack the required slot + 1 over the subschema index, see json2cpp::schema::pack_property.
+    nlohmann::ordered_json properties = nlohmann::ordered_json::object();
+    if (const auto *members = keyword("properties")) {
+      if (!members->is_object()) fail(path, "'properties' must be an object");
+      for (auto itr = members->begin(); itr != members->end(); ++itr) {
+        const auto child = compile_at(itr.value(), path, "properties", itr.key());
+        properties[itr.key()] = (required_slot(itr.key()) << 32u) | child;
+      }
+    }
+    for (const auto &name : required) {
+      if (!properties.contains(name)) properties[name] = (required_slot(name) << 32u) | no_node;
+    }
+    node.properties = intern_table(std::move(properties));
+
+    if (const auto *patterns = keyword("patternProperties")) {
+      if (!patterns->is_object()) fail(path, "'patternProperties' must be an object");
+      for (auto itr = patterns->begin(); itr != patterns->end(); ++itr) {
+        node.pattern_properties.emplace_back(
+          pattern_kind(itr.key(), path), compile_at(itr.value(), path, "patternProperties", itr.key()));
+      }
+    }
+    if (const auto *additional = keyword("additionalProperties")) {
+      node.additional_properties = compile_optional(*additional, path, "additionalProperties");
+    }
+
+    if (const auto *branches = keyword("allOf")) {
+      const auto all_of = compile_list(*branches, path, "allOf");
+      node.all_of.insert(node.all_of.end(), all_of.begin(), all_of.end());
+    }
+    if (const auto *branches = keyword("anyOf")) node.any_of = compile_list(*branches, path, "anyOf");
+    if (const auto *branches = keyword("oneOf")) node.one_of = compile_list(*branches, path, "oneOf");
+    if (const auto *negated = keyword("not")) node.not_node = compile_at(*negated, path, "not");
+    return node;
+  }
+};
+
+std::string format_schema_number(const double value) { return fmt::format("{}", value); }
+
+std::string format_schema_count(const std::uint32_t value)
+{
+  return value == SchemaCompiler::unlimited ? "json2cpp::schema::unlimited" : std::to_string(value);
+}
+
+std::string format_schema_node_index(const std::uint32_t value)
+{
+  return value == SchemaCompiler::no_node ? "json2cpp::schema::no_node" : std::to_string(value);
+}
+
+// Emits the tables through emit_value, which writes their nodes with the document's, and returns the definitions
+// that go after them: the table roots, the branch and pattern arrays, schema_nodes and schema.
+std::vector<std::string> emit_schema(const SchemaCompiler &schema, EmitContext &ctx)
+{
+  std::vector<std::string> lines;
+  std::vector<std::string> tables;
+  for (std::size_t i = 0; i < schema.tables.size(); ++i) {
+    const auto &table = schema.tables[i];
+    const auto repr = emit_value(table, ctx);
+    const bool shared = table.is_object() ? ctx.trackers.object_tracker.is_shared(table)
+                                          : ctx.trackers.array_tracker.is_shared(table);
+    if (shared) {
+      tables.push_back(fmt::format("&{}", repr));
+    } else {
+      lines.emplace_back(fmt::format("constexpr auto st{} = json{{{{ {} }}}};", i, repr));
+      tables.push_back(fmt::format("&st{}", i));
+    }
+  }
+
+  std::unordered_map<std::string, std::string> arrays;
+  const auto emit_array_of = [&](std::string_view type, std::string_view prefix, const std::string &entries) {
+    const auto [found, inserted] = arrays.try_emplace(fmt::format("{}{}", prefix, entries));
+    if (inserted) {
+      found->second = fmt::format("{}{}", prefix, arrays.size() - 1);
+      lines.emplace_back(fmt::format("constexpr {} {}[] = {{ {} }};", type, found->second, entries));
+    }
+    return found->second;
+  };
+  const auto emit_branches = [&](const std::vector<std::uint32_t> &branches) {
+    std::vector<std::string> entries;
+    for (const auto branch : branches) entries.push_back(std::to_string(branch));
+    return emit_array_of("std::uint32_t", "sb", join_strings(entries));
+  };
+
+  std::vector<std::string> node_lines;
+  for (const auto &node : schema.nodes) {
+    std::vector<std::string> fields;
+    const auto field = [&](std::string_view name, const std::string &value) {
+      fields.push_back(fmt::format(".{} = {}", name, value));
+    };
+    if (node.types != SchemaCompiler::any_type) field("types", std::to_string(node.types));
+    if (node.flags != 0) field("flags", std::to_string(node.flags));
+    if (node.required_count != 0) field("required_count", std::to_string(node.required_count));
+    if ((node.flags & SchemaCompiler::has_minimum) != 0) field("minimum", format_schema_number(node.minimum));
+    if ((node.flags & SchemaCompiler::has_maximum) != 0) field("maximum", format_schema_number(node.maximum));
+    if ((node.flags & SchemaCompiler::has_multiple_of) != 0)
+      field("multiple_of", format_schema_number(node.multiple_of));
+    if (node.min_length != 0) field("min_length", format_schema_count(node.min_length));
+    if (node.max_length != SchemaCompiler::unlimited) field("max_length", format_schema_count(node.max_length));
+    if (node.min_items != 0) field("min_items", format_schema_count(node.min_items));
+    if (node.max_items != SchemaCompiler::unlimited) field("max_items", format_schema_count(node.max_items));
+    if (node.min_properties != 0) field("min_properties", format_schema_count(node.min_properties));
+    if (node.max_properties != SchemaCompiler::unlimited)
+      field("max_properties", format_schema_count(node.max_properties));
+    if (node.properties != SchemaCompiler::no_table) field("properties", tables[node.properties]);
+    if (!node.pattern_properties.empty()) {
+      std::vector<std::string> entries;
+      for (const auto &[kind, child] : node.pattern_properties)
+        entries.push_back(fmt::format("{{ json2cpp::schema::pattern_kind::{}, {} }}", kind, child));
+      field("pattern_properties", emit_array_of("json2cpp::schema::pattern_property_t", "sp", join_strings(entries)));
+    }
+    if (node.additional_properties != SchemaCompiler::no_node)
+      field("additional_properties", format_schema_node_index(node.additional_properties));
+    if (node.items != SchemaCompiler::no_node) field("items", format_schema_node_index(node.items));
+    if (node.enum_strings != SchemaCompiler::no_table) field("enum_strings", tables[node.enum_strings]);
+    if (node.enum_values != SchemaCompiler::no_table) field("enum_values", tables[node.enum_values]);
+    if (!node.all_of.empty()) field("all_of", emit_branches(node.all_of));
+    if (!node.any_of.empty()) field("any_of", emit_branches(node.any_of));
+    if (!node.one_of.empty()) field("one_of", emit_branches(node.one_of));
+    if (node.not_node != SchemaCompiler::no_node) field("not_node", format_schema_node_index(node.not_node));
+    node_lines.push_back(fmt::format("  {{ {} }},", join_strings(fields)));
+  }
+
+  lines.emplace_back("constexpr json2cpp::basic_schema_node_t<basicType> schema_nodes[] = {");
+  lines.insert(lines.end(), node_lines.begin(), node_lines.end());
+  lines.emplace_back("};");
+  lines.emplace_back("constexpr json2cpp::basic_schema_t<basicType> schema{ schema_nodes };");
+  return lines;
+}
+
+// Same text as json2cpp::dump_to() writes for the compiled value, built with the same number and string helpers.
+void append_minified(const nlohmann::ordered_json &value, std::string &out)
+{
+  std::array<char, 32> buffer{};
+  switch (value.type()) {
+  case nlohmann::ordered_json::value_t::null:
+    out += "null";
+    return;
+  case nlohmann::ordered_json::value_t::boolean:
+    out += value.get<bool>() ? "true" : "false";
+    return;
+  case nlohmann::ordered_json::value_t::number_integer:
+    out += json2cpp::detail::format_number(value.get<std::int64_t>(), buffer);
+    return;
+  case nlohmann::ordered_json::value_t::number_unsigned:
+    out += json2cpp::detail::format_number(value.get<std::uint64_t>(), buffer);
+    return;
+  case nlohmann::ordered_json::value_t::number_float:
+    out += json2cpp::detail::format_number(value.get<double>(), buffer);
+    return;
+  case nlohmann::ordered_json::value_t::string:
+    json2cpp::detail::append_escaped(out, std::string_view(value.get_ref<const std::string &>()));
+    return;
+  case nlohmann::ordered_json::value_t::array: {
+    out += '[';
+    for (std::size_t i = 0; i < value.size(); ++i) {
+      if (i != 0) out += ',';
+      append_minified(value[i], out);
+    }
+    out += ']';
+    return;
+  }
+  case nlohmann::ordered_json::value_t::object: {
+    out += '{';
+    bool first = true;
+    for (const auto &[key, member] : value.items()) {
+      if (!first) out += ',';
+      first = false;
+      json2cpp::detail::append_escaped(out, std::string_view(key));
+      out += ':';
+      append_minified(member, out);
+    }
+    out += '}';
+    return;
+  }
+  default:
+    throw std::runtime_error("Binary values have no JSON text");
+  }
+}
+
+// Literal pieces of text, split below the string literal limits of some compilers and never inside a UTF-8
+// sequence, so that the UTF-16 build converts each piece on its own.
+std::string make_text_literal(const std::string &text)
+{
+  constexpr std::size_t piece_size = 2048;
+  std::string result;
+  for (std::size_t begin = 0; begin < text.size();) {
+    auto end = std::min(begin + piece_size, text.size());
+    while (end < text.size() && (static_cast<unsigned char>(text[end]) & 0xC0u) == 0x80u) ++end;
+    result += fmt::format("{}\"{}\"", begin == 0 ? "" : "\n      ", escape_string(text.substr(begin, end - begin)));
+    begin = end;
+  }
+  return text.empty() ? "\"\"" : result;
+}
+
+std::vector<std::string> emit_precomputed_text(const nlohmann::ordered_json &json,
+  const std::vector<std::string> &pointers)
+{
+  std::vector<std::string> lines;
+  lines.emplace_back("  constexpr json2cpp::basic_precomputed_text_t<basicType> precomputed_text[] = {");
+  std::size_t total = 0;
+  for (const auto &pointer : pointers) {
+    const nlohmann::ordered_json::json_pointer path(pointer);
+    if (!json.contains(path)) throw std::runtime_error(fmt::format("Precomputed text path '{}' not found", pointer));
+    const auto &value = json.at(path);
+    if (!value.is_array() && !value.is_object()) {
+      throw std::runtime_error(fmt::format("Precomputed text path '{}' is not an array or object", pointer));
+    }
+    std::string text;
+    append_minified(value, text);
+    total += text.size();
+    lines.emplace_back(fmt::format(
+      "    {{ RAW_PREFIX({}), RAW_PREFIX({}) }},", make_text_literal(pointer), make_text_literal(text)));
+  }
+  lines.emplace_back("  };");
+  spdlog::info("{} subtree texts precomputed, {} bytes.", pointers.size(), total);
+  return lines;
+}
+
+// Infers a C++ type for every node of the document for --typed: objects become structs, shared by every object of
+// the same shape; arrays whose elements share a type become std::array, the others std::tuple, and numbers mixing
+// integers and floats become double. The values are then written as one constexpr aggregate.
+struct TypedEmitter
+{
+  struct Member
+  {
+    std::string key;
+    std::string name;
+    std::string type;
+  };
+
+  struct Struct
+  {
+    std::string name;
+    std::vector<Member> members;
+  };
+
+  static constexpr std::string_view string_type = "std::basic_string_view<basicType>";
+
+  std::vector<Struct> structs;
+  std::map<std::string, std::size_t> struct_by_signature;
+  std::set<std::string> type_names;
+  std::unordered_map<const nlohmann::ordered_json *, std::string> node_types;
+
+  static bool is_keyword(std::string_view name)
+  {
+    static const std::set<std::string_view> keywords{ "alignas", "alignof", "and", "and_eq", "asm", "auto", "bitand",
+      "bitor", "bool", "break", "case", "catch", "char", "char8_t", "char16_t", "char32_t", "class", "compl",
+      "concept", "const", "consteval", "constexpr", "constinit", "const_cast", "continue", "co_await", "co_return",
+      "co_yield", "decltype", "default", "delete", "do", "double", "dynamic_cast", "else", "enum", "explicit",
+      "export", "extern", "false", "float", "for", "friend", "goto", "if", "inline", "int", "long", "mutable",
+      "namespace", "new", "noexcept", "not", "not_eq", "nullptr", "operator", "or", "or_eq", "private", "protected",
+      "public", "register", "reinterpret_cast", "requires", "return", "short", "signed", "sizeof", "static",
+      "static_assert", "static_cast", "struct", "switch", "template", "this", "thread_local", "throw", "true", "try",
+      "typedef", "typeid", "typename", "union", "unsigned", "using", "virtual", "void", "volatile", "wchar_t",
+      "while", "xor", "xor_eq" };
+    return keywords.contains(name);
+  }
+
+  static bool is_number_type(std::string_view type)
+  {
+    return type == "std::int64_t" || type == "std::uint64_t" || type == "double";
+  }
+
+  static std::string scalar_type(const nlohmann::ordered_json &value)
+  {
+    if (value.is_null()) return "std::nullptr_t";
+    if (value.is_boolean()) return "bool";
+    if (value.is_number_float()) return "double";
+    if (value.is_number_unsigned()) {
+      return value.get<std::uint64_t>() > static_cast<std::uint64_t>(std::numeric_limits<std::int64_t>::max())
+               ? "std::uint64_t"
+               : "std::int64_t";
+    }
+    if (value.is_number_integer()) return "std::int64_t";
+    return std::string(string_type);
+  }
+
+  std::string unique_type_name(std::string_view hint)
+  {
+    auto name = fmt::format("{}_t", sanitize_identifier(hint));
+    for (std::size_t suffix = 2; type_names.contains(name); ++suffix) {
+      name = fmt::format("{}_t{}", sanitize_identifier(hint), suffix);
+    }
+    type_names.insert(name);
+    return name;
+  }
+
+  std::string element_types(const nlohmann::ordered_json &value, std::string_view hint)
+  {
+    std::vector<std::string> types;
+    for (const auto &element : value) types.push_back(type_of(element, hint));
+    if (types.empty()) return "std::array<std::nullptr_t, 0>";
+    if (std::ranges::all_of(types, [&](const auto &type) { return type == types.front(); })) {
+      return fmt::format("std::array<{}, {}>", types.front(), types.size());
+    }
+    if (std::ranges::all_of(types, is_number_type)) return fmt::format("std::array<double, {}>", types.size());
+    return fmt::format("std::tuple<{}>", join_strings(types));
+  }
+
+  std::string type_of(const nlohmann::ordered_json &value, std::string_view hint)
+  {
+    auto type = infer_type(value, hint);
+    node_types.emplace(&value, type);
+    return type;
+  }
+
+  std::string infer_type(const nlohmann::ordered_json &value, std::string_view hint)
+  {
+    if (value.is_array()) return element_types(value, hint);
+    if (!value.is_object()) return scalar_type(value);
+
+    std::vector<Member> members;
+    std::string signature;
+    for (const auto &[key, member] : value.items()) {
+      members.push_back({ key, {}, type_of(member, key) });
+      signature += fmt::format("{}:{};", nlohmann::ordered_json(key).dump(), members.back().type);
+    }
+    const auto [found, inserted] = struct_by_signature.try_emplace(signature, structs.size());
+    if (inserted) structs.push_back({ unique_type_name(hint), std::move(members) });
+    return structs[found->second].name;
+  }
+
+  // Member names, once every type name is known: keywords get a trailing '_', and names equal to a type or to an
+  // earlier member get one until they are unique.
+  void name_members()
+  {
+    for (auto &current : structs) {
+      std::set<std::string> used;
+      for (auto &member : current.members) {
+        auto name = sanitize_identifier(member.key);
+        while (is_keyword(name) || type_names.contains(name) || used.contains(name)) name += '_';
+        used.insert(name);
+        member.name = std::move(name);
+      }
+    }
+  }
+
+  // Writes value as its inferred type, or as double in an array whose numbers were promoted.
+  std::string initializer(const nlohmann::ordered_json &value, std::string_view type) const
+  {
+    if (value.is_null()) return "nullptr";
+    if (value.is_boolean()) return value.get<bool>() ? "true" : "false";
+    if (value.is_number()) {
+      std::array<char, 32> buffer{};
+      if (type == "double") return std::string(json2cpp::detail::format_number(value.get<double>(), buffer));
+      if (type == "std::uint64_t") return fmt::format("std::uint64_t{{{}u}}", value.get<std::uint64_t>());
+      // -9223372036854775808 would be the negation of a literal too large for any signed type.
+      const auto integer = value.get<std::int64_t>();
+      if (integer == std::numeric_limits<std::int64_t>::min()) return "std::int64_t{-9223372036854775807 - 1}";
+      return fmt::format("std::int64_t{{{}}}", integer);
+    }
+    if (value.is_string()) return format_json_string(value.get<std::string>());
+
+    const bool promoted = type.starts_with("std::array<double,");
+    std::vector<std::string> elements;
+    for (const auto &element : value) {
+      elements.push_back(initializer(element, promoted ? std::string_view("double") : node_types.at(&element)));
+    }
+    if (type.starts_with("std::array<")) return fmt::format("{}{{ {{ {} }} }}", type, join_strings(elements));
+    return fmt::format("{}{{ {} }}", type, join_strings(elements));
+  }
+
+  std::vector<std::string> emit(const std::string &document_name, const nlohmann::ordered_json &json)
+  {
+    const auto root_type = type_of(json, "document");
+    name_members();
+
+    std::vector<std::string> lines{ fmt::format("#ifndef {}_COMPILED_JSON_TYPED", document_name),
+      fmt::format("#define {}_COMPILED_JSON_TYPED", document_name),
+      "#include <array>",
+      "#include <cstddef>",
+      "#include <cstdint>",
+      "#include <string_view>",
+      "#include <tuple>",
+      fmt::format("namespace compiled_json::{}::typed {{", document_name),
+      "  using namespace std::literals::string_view_literals;",
+      "  #ifdef JSON2CPP_USE_UTF16",
+      "  typedef char16_t basicType;",
+      "  #define RAW_PREFIX(str) u\"\" str \"\"sv",
+      "  #else",
+      "  typedef char basicType;",
+      "  #define RAW_PREFIX(str) str \"\"sv",
+      "  #endif" };
+    for (const auto &current : structs) {
+      lines.push_back(fmt::format("  struct {}", current.name));
+      lines.emplace_back("  {");
+      for (const auto &member : current.members) {
+        lines.push_back(fmt::format("    {} {};", member.type, member.name));
+      }
+      lines.emplace_back("  };");
+    }
+    lines.push_back(fmt::format("  inline constexpr {} document = {};", root_type, initializer(json, root_type)));
+    lines.emplace_back("}");
+    lines.emplace_back("#endif");
+    spdlog::info("{} struct types inferred for the typed document.", structs.size());
+    return lines;
+  }
+};
+
+// A document built out of basic_json<CharType> nodes with the runtime's own constructors, for images that hold those
+// nodes as they are laid out in memory. Objects take the regular layout; identical strings and subtrees are stored
+// once.
+template<typename CharType> class RuntimeTree
+{
+  struct SubtreeHash
+  {
+    std::size_t operator()(const nlohmann::ordered_json *value) const { return JsonHasher{}(*value); }
+  };
+  struct SubtreeEqual
+  {
+    bool operator()(const nlohmann::ordered_json *a, const nlohmann::ordered_json *b) const
+    {
+      return JsonEqual{}(*a, *b);
+    }
+  };
+
+  std::unordered_map<std::basic_string<CharType>, const CharType *> string_data_;
+  std::unordered_map<const nlohmann::ordered_json *, json2cpp::basic_json<CharType>, SubtreeHash, SubtreeEqual>
+    subtrees_;
+
+public:
+  using json = json2cpp::basic_json<CharType>;
+  using pair_t = json2cpp::basic_value_pair_t<CharType>;
+
+  explicit RuntimeTree(const nlohmann::ordered_json &document) : root(build(document)) {}
+
+  // Deques keep the node and string storage in place while the tree is built.
+  std::deque<std::vector<json>> arrays;
+  std::deque<std::vector<pair_t>> objects;
+  std::deque<std::basic_string<CharType>> strings;
+  json root;
+
+private:
+  json string(const std::string &value)
+  {
+    std::basic_string<CharType> text;
+    if constexpr (sizeof(CharType) == 1) {
+      text.assign(value.begin(), value.end());
+    } else {
+      for (const auto unit : utf16_units(value)) text.push_back(static_cast<CharType>(unit));
+    }
+    if (text.size() <= sizeof(std::uint64_t) / sizeof(CharType)) return json(std::basic_string_view<CharType>(text));
+    const auto [found, inserted] = string_data_.try_emplace(text, nullptr);
+    if (inserted) found->second = strings.emplace_back(std::move(text)).data();
+    return json(std::basic_string_view<CharType>(found->second, found->first.size()));
+  }
+
+  json build(const nlohmann::ordered_json &value)
+  {
+    switch (value.type()) {
+    case nlohmann::ordered_json::value_t::null:
+      return json(nullptr);
+    case nlohmann::ordered_json::value_t::boolean:
+      return json(value.get<bool>());
+    case nlohmann::ordered_json::value_t::number_integer:
+      return json(value.get<std::int64_t>());
+    case nlohmann::ordered_json::value_t::number_unsigned:
+      return json(value.get<std::uint64_t>());
+    case nlohmann::ordered_json::value_t::number_float:
+      return json(value.get<double>());
+    case nlohmann::ordered_json::value_t::string:
+      return string(value.get_ref<const std::string &>());
+    default:
+      break;
+    }
+
+    if (const auto found = subtrees_.find(&value); found != subtrees_.end()) return found->second;
+    json node;
+    if (value.is_array()) {
+      std::vector<json> elements;
+      elements.reserve(value.size());
+      for (const auto &element : value) elements.push_back(build(element));
+      node = json(json2cpp::basic_array_t<CharType>(arrays.emplace_back(std::move(elements))));
+    } else {
+      std::vector<pair_t> members;
+      members.reserve(value.size());
+      for (const auto &[key, member] : value.items()) members.push_back(pair_t{ string(key), build(member) });
+      node = json(json2cpp::basic_object_t<CharType>(objects.emplace_back(std::move(members))));
+    }
+    subtrees_.emplace(&value, node);
+    return node;
+  }
+};
+
+// Writes a RuntimeTree as a json2cpp_image.hpp image: nodes first, then strings, then the relocation table of the
+// pointers among the nodes.
+template<typename CharType> class ImageWriter
+{
+public:
+  explicit ImageWriter(const nlohmann::ordered_json &document) : tree_(document) {}
+
+  void write(const std::filesystem::path &filename) const
+  {
+    json2cpp::detail::check_image_layout<CharType>();
+    struct Block
+    {
+      const std::byte *address;
+      std::size_t size;
+      std::uint64_t offset;
+    };
+    std::map<const std::byte *, Block> blocks;
+    std::uint64_t offset = sizeof(json2cpp::detail::image_header_t);
+    const auto place = [&](const void *data, std::size_t size, std::size_t alignment) {
+      if (size == 0) return;
+      offset = (offset + alignment - 1) / alignment * alignment;
+      const auto *address = static_cast<const std::byte *>(data);
+      blocks.emplace(address, Block{ address, size, offset });
+      offset += size;
+    };
+    for (const auto &array : tree_.arrays) place(array.data(), array.size() * sizeof(json), alignof(json));
+    for (const auto &object : tree_.objects) place(object.data(), object.size() * sizeof(pair_t), alignof(json));
+    place(&tree_.root, sizeof(json), alignof(json));
+    for (const auto &string : tree_.strings) place(string.data(), string.size() * sizeof(CharType), alignof(CharType));
+    offset = (offset + alignof(std::uint64_t) - 1) / alignof(std::uint64_t) * alignof(std::uint64_t);
+    std::vector<std::byte> image(offset);
+    for (const auto &[address, block] : blocks) std::memcpy(image.data() + block.offset, address, block.size);
+
+    const auto offset_of = [&](const void *pointer) {
+      const auto *address = static_cast<const std::byte *>(pointer);
+      const auto &block = std::prev(blocks.upper_bound(address))->second;
+      return block.offset + static_cast<std::uint64_t>(address - block.address);
+    };
+    std::vector<std::uint64_t> relocations;
+    const auto relocate = [&](const json &node) {
+      const void *target = nullptr;
+      if (node.is_array() || node.is_object()) {
+        target = node.size() == 0 ? nullptr : node.node_address();
+      } else if (node.is_string() && node.size() > sizeof(std::uint64_t) / sizeof(CharType)) {
+        target = node.getString().data();
+      }
+      if (target == nullptr) return;
+      const auto slot = offset_of(&node) + json2cpp::detail::image_payload_offset;
+      const auto target_offset = offset_of(target);
+      std::memcpy(image.data() + slot, &target_offset, sizeof(target_offset));
+      relocations.push_back(slot);
+    };
+    for (const auto &array : tree_.arrays) {
+      for (const auto &node : array) relocate(node);
+    }
+    for (const auto &object : tree_.objects) {
+      for (const auto &[key, value] : object) {
+        relocate(key);
+        relocate(value);
+      }
+    }
+    relocate(tree_.root);
+    std::sort(relocations.begin(), relocations.end());
+
+    json2cpp::detail::image_header_t header{ json2cpp::detail::image_magic,
+      json2cpp::detail::image_version,
+      static_cast<std::uint32_t>(sizeof(CharType)),
+      static_cast<std::uint32_t>(json2cpp::detail::image_node_size),
+      std::endian::native == std::endian::little ? 1u : 0u,
+      image.size() + relocations.size() * sizeof(std::uint64_t),
+      offset_of(&tree_.root),
+      image.size(),
+      relocations.size() };
+    std::memcpy(image.data(), &header, sizeof(header));
+
+    std::ofstream output(filename, std::ios::binary);
+    if (!output) throw std::runtime_error(fmt::format("Unable to write image '{}'", filename.string()));
+    output.write(reinterpret_cast<const char *>(image.data()), static_cast<std::streamsize>(image.size()));
+    output.write(reinterpret_cast<const char *>(relocations.data()),
+      static_cast<std::streamsize>(relocations.size() * sizeof(std::uint64_t)));
+
+    spdlog::info("Image written to '{}': {} arrays, {} objects and {} long strings, {} bytes, {} relocations.",
+      filename.string(),
+      tree_.arrays.size(),
+      tree_.objects.size(),
+      tree_.strings.size(),
+      header.file_size,
+      relocations.size());
+  }
+
+private:
+  using json = json2cpp::basic_json<CharType>;
+  using pair_t = json2cpp::basic_value_pair_t<CharType>;
+
+  RuntimeTree<CharType> tree_;
+};
+
+// Unescaped reference tokens of a JSON pointer (RFC 6901).
+std::vector<std::string> split_pointer(const std::string &pointer)
+{
+  std::vector<std::string> tokens;
+  if (pointer.empty()) return tokens;
+  if (pointer.front() != '/') throw std::runtime_error(fmt::format("JSON pointer '{}' must start with '/'", pointer));
+  for (std::size_t begin = 1;;) {
+    const auto end = std::min(pointer.find('/', begin), pointer.size());
+    std::string token;
+    for (std::size_t i = begin; i < end; ++i) {
+      if (pointer[i] != '~') {
+        token.push_back(pointer[i]);
+      } else if (i + 1 < end && (pointer[i + 1] == '0' || pointer[i + 1] == '1')) {
+        token.push_back(pointer[++i] == '0' ? '~' : '/');
+      } else {
+        throw std::runtime_error(fmt::format("JSON pointer '{}' has an invalid escape", pointer));
+      }
+    }
+    tokens.push_back(std::move(token));
+    if (end == pointer.size()) return tokens;
+    begin = end + 1;
+  }
+}
+
+std::string join_pointer(const std::vector<std::string> &tokens)
+{
+  std::string pointer;
+  for (const auto &token : tokens) {
+    pointer += '/';
+    for (const char c : token) {
+      if (c == '~') {
+        pointer += "~0";
+      } else if (c == '/') {
+        pointer += "~1";
+      } else {
+        pointer += c;
+      }
+    }
+  }
+  return pointer;
+}
+
+// Adds the paths of the values below value that match pattern from its position-th token on. '*' matches any one
+// member or element and '**' any number of levels, none included.
+void match_pattern(const nlohmann::ordered_json &value,
+  const std::vector<std::string> &pattern,
+  const std::size_t position,
+  std::vector<std::string> &path,
+  std::set<std::vector<std::string>> &matches)
+{
+  if (position == pattern.size()) {
+    matches.insert(path);
+    return;
+  }
+  const auto &token = pattern[position];
+  const bool any_depth = token == "**";
+  if (any_depth) match_pattern(value, pattern, position + 1, path, matches);
+  const auto visit = [&](std::string child_token, const nlohmann::ordered_json &child) {
+    path.push_back(std::move(child_token));
+    match_pattern(child, pattern, any_depth ? position : position + 1, path, matches);
+    path.pop_back();
+  };
+  if (!any_depth && token != "*") {
+    if (value.is_object()) {
+      if (const auto it = value.find(token); it != value.end()) visit(token, *it);
+    } else if (value.is_array() && !token.empty()
+               && std::ranges::all_of(token, [](const char c) { return std::isdigit(static_cast<unsigned char>(c)); })
+               && (token.size() == 1 || token.front() != '0')) {
+      const auto index = std::stoull(token);
+      if (index < value.size()) visit(token, value[index]);
+    }
+  } else if (value.is_object()) {
+    for (const auto &[key, child] : value.items()) visit(key, child);
+  } else if (value.is_array()) {
+    for (std::size_t index = 0; index < value.size(); ++index) visit(std::to_string(index), value[index]);
+  }
+}
+
+// Paths of the values selected by a --keep manifest, and the lookups from the root reaching each named one.
+struct KeptSelection
+{
+  std::set<std::vector<std::string>> paths;
+  std::vector<std::pair<std::string, std::string>> entries;
+};
+
+KeptSelection select_kept(const nlohmann::ordered_json &json, const std::vector<kept_subtree> &keep)
+{
+  KeptSelection selection;
+  std::set<std::string> names;
+  for (const auto &subtree : keep) {
+    std::set<std::vector<std::string>> matches;
+    std::vector<std::string> path;
+    match_pattern(json, split_pointer(subtree.pattern), 0, path, matches);
+    if (!subtree.name.empty()) {
+      auto name = sanitize_identifier(subtree.name);
+      if (matches.size() != 1) {
+        throw std::runtime_error(fmt::format(
+          "Kept subtree '{}' ('{}') selects {} values instead of one", name, subtree.pattern, matches.size()));
+      }
+      if (!names.insert(name).second) {
+        throw std::runtime_error(fmt::format("Kept subtree name '{}' is used more than once", name));
+      }
+      const auto &match = *matches.begin();
+      std::string lookup;
+      const auto *value = &json;
+      for (const auto &token : match) {
+        if (value->is_object()) {
+          lookup += fmt::format(".at({})", format_json_string(token));
+          value = &value->at(token);
+        } else {
+          lookup += fmt::format(".at({})", token);
+          value = &value->at(std::stoull(token));
+        }
+      }
+      spdlog::info("Kept subtree '{}' is '{}'.", name, join_pointer(match));
+      selection.entries.emplace_back(std::move(name), std::move(lookup));
+    } else if (matches.empty()) {
+      spdlog::warn("Keep pattern '{}' selects nothing", subtree.pattern);
+    }
+    selection.paths.merge(matches);
+  }
+  if (selection.paths.empty()) throw std::runtime_error("The keep patterns select nothing");
+  return selection;
+}
+
+// The selected paths as a tree; a whole node is kept with everything below it.
+struct KeptTree
+{
+  bool whole = false;
+  std::map<std::string, KeptTree> children;
+};
+
+nlohmann::ordered_json prune(const nlohmann::ordered_json &value, const KeptTree &kept)
+{
+  if (kept.whole) return value;
+  if (value.is_object()) {
+    auto result = nlohmann::ordered_json::object();
+    for (const auto &[key, child] : value.items()) {
+      if (const auto it = kept.children.find(key); it != kept.children.end()) result[key] = prune(child, it->second);
+    }
+    return result;
+  }
+  auto result = nlohmann::ordered_json::array();
+  for (std::size_t index = 0; index < value.size(); ++index) {
+    const auto it = kept.children.find(std::to_string(index));
+    result.push_back(it == kept.children.end() ? nlohmann::ordered_json() : prune(value[index], it->second));
+  }
+  return result;
+}
+
+nlohmann::ordered_json prune(const nlohmann::ordered_json &json, const KeptSelection &selection)
+{
+  KeptTree root;
+  for (const auto &path : selection.paths) {
+    auto *node = &root;
+    for (const auto &token : path) node = &node->children[token];
+    node->whole = true;
+  }
+  return prune(json, root);
+}
+
+std::size_t count_values(const nlohmann::ordered_json &value)
+{
+  std::size_t count = 1;
+  if (value.is_structured()) {
+    for (const auto &element : value) count += count_values(element);
+  }
+  return count;
+}
+
+// Whether the document nodes are defined constinit const rather than constexpr.
+bool uses_constinit(const compile_options &options)
+{
+  if (options.mode != emission_mode::constinit_data) return false;
+  if (options.schema || !options.precomputed_text.empty()) {
+    throw std::runtime_error("Constinit documents cannot be compiled with a schema or with precomputed texts");
+  }
+  return true;
+}
+
+// Declares get() for the document, and for each document of a bundle, plus schema(), precomputed_text() and the
+// get_<name>() of each named kept subtree.
+void emit_header(compile_results &results, const std::string &document_name)
+{
   results.hpp.emplace_back(fmt::format("#ifndef {}_COMPILED_JSON", document_name));
   results.hpp.emplace_back(fmt::format("#define {}_COMPILED_JSON", document_name));
   results.hpp.emplace_back("#include <json2cpp/json2cpp.hpp>");
+  if (results.schema) results.hpp.emplace_back("#include <json2cpp/json2cpp_schema.hpp>");
+  if (results.precomputed_text) results.hpp.emplace_back("#include <json2cpp/json2cpp_dump.hpp>");
   results.hpp.emplace_back(fmt::format("namespace compiled_json::{} {{", document_name));
   results.hpp.emplace_back("  const json2cpp::json &get();");
+  if (results.schema) results.hpp.emplace_back("  const json2cpp::schema_t &schema();");
+  if (results.precomputed_text) {
+    results.hpp.emplace_back("  std::span<const json2cpp::precomputed_text_t> precomputed_text();");
+  }
+  for (const auto &entry : results.entries) {
+    results.hpp.emplace_back(fmt::format("  const json2cpp::json &get_{}();", entry.first));
+  }
   results.hpp.emplace_back("}");
+  for (const auto &name : results.documents) {
+    results.hpp.emplace_back(fmt::format("namespace compiled_json::{} {{", name));
+    results.hpp.emplace_back("  const json2cpp::json &get();");
+    results.hpp.emplace_back("}");
+  }
   results.hpp.emplace_back("#endif");
+}
+
+compile_results compile_document(const std::string &document_name,
+  const nlohmann::ordered_json &json,
+  const compile_options &options,
+  const std::vector<std::string> &documents)
+{
+  const bool constinit_nodes = uses_constinit(options);
+  const auto analyze_start = std::chrono::steady_clock::now();
+  SchemaCompiler schema;
+  if (options.schema) schema.compile_root(json);
+  auto trackers = build_trackers(json, schema.tables, options.thresholds);
+  const auto analyze_ms = elapsed_ms(analyze_start);
+  const auto emit_start = std::chrono::steady_clock::now();
+  compile_results results;
+  results.schema = options.schema;
+  results.precomputed_text = !options.precomputed_text.empty();
+  results.documents = documents;
 
   EmitContext::LayoutUsage layout_usage;
   std::vector<std::string> impl_body;
   results.impl.emplace_back(fmt::format("#ifndef {}_COMPILED_JSON_IMPL", document_name));
   results.impl.emplace_back(fmt::format("#define {}_COMPILED_JSON_IMPL", document_name));
   results.impl.emplace_back("#include <json2cpp/json2cpp.hpp>");
+  if (options.schema) results.impl.emplace_back("#include <json2cpp/json2cpp_schema.hpp>");
+  if (results.precomputed_text) results.impl.emplace_back("#include <json2cpp/json2cpp_dump.hpp>");
   results.impl.emplace_back(fmt::format(R"(
 using namespace std::literals::string_view_literals;
 namespace compiled_json::{}::impl {{
@@ -1035,8 +3402,61 @@ namespace compiled_json::{}::impl {{
     document_name));
 
   std::size_t node_count = 0;
+  StringArena string_arena;
+  StringCompressor string_compressor;
+  string_compressor.min_size = options.compress_strings_above;
   EmitContext ctx{ node_count, impl_body, trackers, layout_usage, {}, 0 };
-  const auto root_repr = emit_value(json, ctx);
+  if (options.string_arena) ctx.string_arena = &string_arena;
+  if (options.compress_strings_above != 0) ctx.string_compressor = &string_compressor;
+  AccessProfile profile;
+  NodeBlocks node_blocks;
+  if (options.node_order != layout_order::post) ctx.node_blocks = &node_blocks;
+  ctx.forced_layout = options.forced_layout;
+  ctx.goal = options.goal;
+  ctx.thresholds = options.thresholds;
+  // Constinit nodes cannot be read while the document is initialized, so everything their constructors would compute
+  // is written out.
+  ctx.precompute_metadata = options.precompute_metadata || constinit_nodes;
+  ctx.constinit_nodes = constinit_nodes;
+  LayoutReport report;
+  if (!options.report.empty()) {
+    std::string path;
+    report.collect_paths(json, path);
+    ctx.report = &report;
+  }
+  if (!options.profile.empty()) {
+    profile.load(options.profile);
+    std::string path;
+    profile.resolve(json, path);
+    ctx.profile = &profile;
+  }
+  auto root_repr = emit_value(json, ctx);
+  std::vector<std::string> schema_lines;
+  if (options.schema) schema_lines = emit_schema(schema, ctx);
+  if (ctx.node_blocks != nullptr) impl_body = node_blocks.ordered_lines(options.node_order);
+  std::vector<std::string> pool_lines;
+  if (layout_usage.uses_scalar_pool && !trackers.scalar_tracker.pooled_values.empty()) {
+    trackers.scalar_tracker.finalize();
+    for (auto &line : impl_body) line = trackers.scalar_tracker.resolve(line);
+    for (auto &line : schema_lines) line = trackers.scalar_tracker.resolve(line);
+    pool_lines.emplace_back("  constexpr json s[] = {");
+    for (std::size_t i = 0; i < trackers.scalar_tracker.pooled_values.size(); ++i) {
+      if (!trackers.scalar_tracker.is_referenced(i)) continue;
+      const auto &value = trackers.scalar_tracker.pooled_values[i];
+      pool_lines.emplace_back(fmt::format("    json{{ {} }},", emit_scalar_value(value, ctx)));
+    }
+    pool_lines.emplace_back("  };");
+  }
+
+  const bool uses_string_arena = !string_arena.strings.empty();
+  const bool uses_compressed_strings = string_compressor.counter != 0;
+  if (uses_string_arena) {
+    string_arena.finalize();
+    for (auto &line : pool_lines) line = string_arena.resolve(line);
+    for (auto &line : impl_body) line = string_arena.resolve(line);
+    for (auto &line : schema_lines) line = string_arena.resolve(line);
+    root_repr = string_arena.resolve(root_repr);
+  }
 
   if (trackers.key_tracker.descriptor_count() != 0) {
     results.impl.emplace_back("  using key_descriptor_t = json2cpp::basic_key_descriptor<basicType>;");
@@ -1049,7 +3469,8 @@ namespace compiled_json::{}::impl {{
     results.impl.emplace_back("  using ref_pair_t = json2cpp::basic_ref_value_pair_t<basicType>;");
     results.impl.emplace_back("  using ref_value_object_t = json2cpp::basic_ref_value_object_t<basicType>;");
   }
-  if (layout_usage.uses_blob_ref || layout_usage.uses_indexed_mphf8_blob_ref) {
+  if (layout_usage.uses_blob_ref || layout_usage.uses_indexed_mphf8_blob_ref || uses_string_arena
+      || uses_compressed_strings) {
     results.impl.emplace_back(R"(  #ifdef JSON2CPP_USE_UTF16
   #define J2C(str) u"" str
   #define J2D(utf8_size, utf16_delta) (utf8_size - utf16_delta)
@@ -1058,12 +3479,26 @@ namespace compiled_json::{}::impl {{
   #define J2D(utf8_size, utf16_delta) utf8_size
     #endif)");
   }
-  if (layout_usage.uses_blob_ref) {
+  if (layout_usage.uses_blob_ref || uses_compressed_strings || ctx.precompute_metadata
+      || layout_usage.uses_key_filter) {
     results.impl.emplace_back(R"(  #ifdef JSON2CPP_USE_UTF16
   #define J2H(utf8_hash, utf16_hash) utf16_hash
   #else
   #define J2H(utf8_hash, utf16_hash) utf8_hash
     #endif)");
+  }
+  if (ctx.hot_node_count != 0) {
+    results.impl.emplace_back(R"(  #if defined(__ELF__) && (defined(__GNUC__) || defined(__clang__))
+  #define J2HOT [[gnu::section(".data.rel.ro.json2cpp.hot")]]
+  #else
+  #define J2HOT
+  #endif)");
+  }
+  if (uses_compressed_strings) {
+    results.impl.emplace_back("  using compressed_t = json2cpp::basic_compressed_string_t<basicType>;");
+    results.impl.insert(results.impl.end(), string_compressor.lines.begin(), string_compressor.lines.end());
+  }
+  if (layout_usage.uses_blob_ref) {
     results.impl.emplace_back(
       "  #define J2B(value, offset, offset_delta, length, length_delta, hash_utf8, hash_utf16, value_hash_utf8, "
       "value_hash_utf16) "
@@ -1080,20 +3515,34 @@ namespace compiled_json::{}::impl {{
   if (layout_usage.uses_indexed_mphf8_blob_ref) {
     results.impl.emplace_back(
       "  using indexed_mphf8_blob_object_t = json2cpp::detail::basic_indexed_mphf8_blob_ref_object_t<basicType>;");
-  }
-  if (layout_usage.uses_scalar_pool && !trackers.scalar_tracker.pooled_values.empty()) {
-    results.impl.emplace_back("  constexpr json s[] = {");
-    for (const auto &value : trackers.scalar_tracker.pooled_values) {
-      results.impl.emplace_back(fmt::format("    json{{{{ {} }}}},", emit_scalar_value(value)));
+    if (ctx.precompute_metadata) {
+      results.impl.emplace_back("  using indexed_pair_t = json2cpp::basic_indexed_blob_ref_value_pair_t<basicType>;");
+      results.impl.emplace_back("  template<std::size_t EntryCount>");
+      results.impl.emplace_back(
+        "  using indexed_storage_t = json2cpp::detail::basic_indexed_blob_storage_t<basicType, EntryCount>;");
     }
-    results.impl.emplace_back("  };");
   }
+  if (uses_string_arena) {
+    results.impl.emplace_back(
+      "  #define J2S(chunk, offset, offset_delta, length, length_delta) "
+      "std::basic_string_view<basicType>{t##chunk + J2D(offset, offset_delta), J2D(length, length_delta)}");
+    results.impl.emplace_back("  #define J2T(chunk, offset, offset_delta) (t##chunk + J2D(offset, offset_delta))");
+    string_arena.emit_definitions(results.impl);
+  }
+  results.impl.insert(results.impl.end(), pool_lines.begin(), pool_lines.end());
   results.impl.insert(results.impl.end(), impl_body.begin(), impl_body.end());
+  results.impl.insert(results.impl.end(), schema_lines.begin(), schema_lines.end());
+  if (results.precomputed_text) {
+    const auto text_lines = emit_precomputed_text(json, options.precomputed_text);
+    results.impl.insert(results.impl.end(), text_lines.begin(), text_lines.end());
+  }
+  if (options.typed) results.typed = TypedEmitter{}.emit(document_name, json);
 
   results.impl.emplace_back(fmt::format(R"(
-  constexpr auto document = json{{{{ {} }}}};
+  {} document = json{{{{ {} }}}};
 }}
 #endif)",
+    constinit_nodes ? "constinit const json" : "constexpr auto",
     root_repr));
 
   spdlog::info("{} JSON nodes emitted.", node_count);
@@ -1110,12 +3559,171 @@ namespace compiled_json::{}::impl {{
     trackers.scalar_tracker.get_reused_count(),
     trackers.scalar_tracker.min_references,
     trackers.scalar_tracker.get_total_references_saved());
+  if (layout_usage.uses_scalar_pool) {
+    spdlog::info("Scalar pool: {} strings, {} numbers, {} booleans, {} nulls referenced.",
+      trackers.scalar_tracker.referenced_count(&nlohmann::ordered_json::is_string),
+      trackers.scalar_tracker.referenced_count(&nlohmann::ordered_json::is_number),
+      trackers.scalar_tracker.referenced_count(&nlohmann::ordered_json::is_boolean),
+      trackers.scalar_tracker.referenced_count(&nlohmann::ordered_json::is_null));
+  }
+  for (const auto &[layout, count] : ctx.forced_layout_fallbacks) {
+    spdlog::warn("{} objects cannot take the forced {} layout and use {} instead.",
+      count,
+      layout_name(forced_object_layout(ctx.forced_layout)),
+      layout);
+  }
+  if (ctx.profile != nullptr) {
+    spdlog::info("{} of {} profiled paths matched, {} hot nodes placed together.",
+      profile.matched_count,
+      profile.pointer_counts.size(),
+      ctx.hot_node_count);
+  }
+  if (uses_compressed_strings) {
+    spdlog::info("{} strings above {} bytes compressed, {} bytes down to {}.",
+      string_compressor.counter,
+      string_compressor.min_size,
+      string_compressor.raw_bytes,
+      string_compressor.compressed_bytes);
+  }
+  if (options.schema) {
+    spdlog::info("{} schema nodes compiled, {} property and enum tables emitted.",
+      schema.nodes.size(),
+      schema.tables.size());
+  }
+  if (uses_string_arena) {
+    spdlog::info("{} strings placed in {} arena chunks ({} tail merged), {} of {} bytes emitted.",
+      string_arena.strings.size(),
+      string_arena.chunks.size(),
+      string_arena.merged_count,
+      string_arena.arena_size(),
+      string_arena.total_size());
+  }
+
+  if (!documents.empty()) {
+    spdlog::info("{} documents bundled into '{}'.", documents.size(), document_name);
+  }
+
+  if (ctx.report != nullptr) {
+    results.report = { { "document", document_name },
+      { "phases_ms",
+        { { "load", nullptr }, { "analyze", analyze_ms }, { "emit", elapsed_ms(emit_start) }, { "write", nullptr } } },
+      { "layouts", report.layout_totals() },
+      { "objects", std::move(report.objects) } };
+  }
 
   return results;
 }
 
+// documents names the elements of a bundle's root array; each of them gets its own namespace and get().
+compile_results compile_impl(const std::string_view original_name,
+  const nlohmann::ordered_json &json,
+  const compile_options &options,
+  const std::vector<std::string> &documents = {})
+{
+  const std::string document_name = sanitize_identifier(original_name);
+  compile_results results;
+  // The schema tables would describe the pruned document, whose constraints are gone and whose arrays hold nulls.
+  if (!options.keep.empty() && options.schema) { throw std::runtime_error("--keep cannot be combined with --schema"); }
+  if (options.keep.empty()) {
+    results = compile_document(document_name, json, options, documents);
+  } else {
+    auto selection = select_kept(json, options.keep);
+    const auto kept = prune(json, selection);
+    spdlog::info("{} of {} JSON values kept.", count_values(kept), count_values(json));
+    results = compile_document(document_name, kept, options, documents);
+    results.entries = std::move(selection.entries);
+  }
+  emit_header(results, document_name);
+  return results;
+}
+
 }// namespace
 
+layout_thresholds load_thresholds(const std::filesystem::path &filename)
+{
+  std::ifstream input(filename);
+  if (!input) throw std::runtime_error(fmt::format("Unable to open configuration '{}'", filename.string()));
+  nlohmann::ordered_json config;
+  input >> config;
+
+  if (!config.is_object())
+    throw std::runtime_error(fmt::format("Configuration '{}' is not a JSON object", filename.string()));
+
+  layout_thresholds thresholds;
+  std::set<std::string> known;
+  const auto read = [&](const char *name, auto &field) {
+    known.insert(name);
+    if (const auto it = config.find(name); it != config.end()) it->get_to(field);
+  };
+  read("min_shared_object_size", thresholds.min_shared_object_size);
+  read("min_shared_array_size", thresholds.min_shared_array_size);
+  read("min_scalar_references", thresholds.min_scalar_references);
+  read("min_compact_savings", thresholds.min_compact_savings);
+  read("min_mphf_size", thresholds.min_mphf_size);
+  read("mphf_prefix_keys", thresholds.mphf_prefix_keys);
+  read("small_object_size", thresholds.small_object_size);
+  read("small_object_min_uses", thresholds.small_object_min_uses);
+  read("min_key_filter_size", thresholds.min_key_filter_size);
+  // A misspelled threshold would otherwise keep its default without notice.
+  for (const auto &[key, unused] : config.items()) {
+    if (!known.contains(key))
+      throw std::runtime_error(fmt::format("Unknown layout threshold '{}' in configuration '{}'", key, filename.string()));
+  }
+  return thresholds;
+}
+
+void save_thresholds(const std::filesystem::path &filename, const layout_thresholds &thresholds)
+{
+  const nlohmann::ordered_json config{ { "min_shared_object_size", thresholds.min_shared_object_size },
+    { "min_shared_array_size", thresholds.min_shared_array_size },
+    { "min_scalar_references", thresholds.min_scalar_references },
+    { "min_compact_savings", thresholds.min_compact_savings },
+    { "min_mphf_size", thresholds.min_mphf_size },
+    { "mphf_prefix_keys", thresholds.mphf_prefix_keys },
+    { "small_object_size", thresholds.small_object_size },
+    { "small_object_min_uses", thresholds.small_object_min_uses },
+    { "min_key_filter_size", thresholds.min_key_filter_size } };
+  std::ofstream output(filename);
+  output << config.dump(2) << '\n';
+}
+
+std::vector<kept_subtree> read_keep_manifest(const std::filesystem::path &filename)
+{
+  std::ifstream input(filename);
+  if (!input) throw std::runtime_error(fmt::format("Unable to open keep manifest '{}'", filename.string()));
+
+  std::vector<kept_subtree> keep;
+  for (std::string line; std::getline(input, line);) {
+    if (!line.empty() && line.back() == '\r') line.pop_back();
+    if (line.empty() || line.front() == '#') continue;
+    auto &subtree = keep.emplace_back();
+    if (line.front() == '/') {
+      subtree.pattern = std::move(line);
+      continue;
+    }
+    // A pattern is empty or starts with '/', so the first '=' ends the name.
+    const auto equals = line.find('=');
+    if (equals == std::string::npos) {
+      throw std::runtime_error(fmt::format("Keep manifest line '{}' is neither a JSON pointer nor name=pointer", line));
+    }
+    const auto trim = [](std::string_view text) {
+      const auto begin = text.find_first_not_of(" \t");
+      if (begin == std::string_view::npos) return std::string();
+      return std::string(text.substr(begin, text.find_last_not_of(" \t") - begin + 1));
+    };
+    subtree.name = trim(std::string_view(line).substr(0, equals));
+    subtree.pattern = trim(std::string_view(line).substr(equals + 1));
+    if (subtree.name.empty()) throw std::runtime_error(fmt::format("Keep manifest line '{}' has no name", line));
+  }
+  if (keep.empty()) throw std::runtime_error(fmt::format("No keep patterns in '{}'", filename.string()));
+  return keep;
+}
+
+nlohmann::ordered_json keep_subtrees(const nlohmann::ordered_json &json, const std::vector<kept_subtree> &keep)
+{
+  return prune(json, select_kept(json, keep));
+}
+
 std::string compile(const nlohmann::json &value, std::size_t &obj_count, std::vector<std::string> &lines)
 {
   EmitContext::LayoutUsage layout_usage;
@@ -1126,19 +3734,81 @@ std::string compile(const nlohmann::json &value, std::size_t &obj_count, std::ve
   return emit_value(ordered, ctx);
 }
 
-compile_results compile(const std::string_view document_name, const nlohmann::json &json)
+compile_results
+  compile(const std::string_view document_name, const nlohmann::json &json, const compile_options &options)
 {
-  return compile_impl(document_name, nlohmann::ordered_json(json));
+  return compile_impl(document_name, nlohmann::ordered_json(json), options);
 }
 
-compile_results compile(const std::string_view document_name, const std::filesystem::path &filename)
+compile_results
+  compile(const std::string_view document_name, const nlohmann::ordered_json &json, const compile_options &options)
+{
+  return compile_impl(document_name, json, options);
+}
+
+compile_results compile(const std::string_view document_name,
+  const std::filesystem::path &filename,
+  const compile_options &options)
 {
   spdlog::info("Loading file: '{}'", filename.string());
+  const auto load_start = std::chrono::steady_clock::now();
   std::ifstream input(filename);
   nlohmann::ordered_json document;
   input >> document;
+  const auto load_ms = elapsed_ms(load_start);
   spdlog::info("File loaded");
-  return compile_impl(document_name, document);
+  auto results = compile_impl(document_name, document, options);
+  if (!options.report.empty()) results.report["phases_ms"]["load"] = load_ms;
+  return results;
+}
+
+compile_results compile_bundle(const std::string_view bundle_name,
+  const std::vector<std::filesystem::path> &filenames,
+  const compile_options &options)
+{
+  const auto load_start = std::chrono::steady_clock::now();
+  auto bundle = nlohmann::ordered_json::array();
+  std::vector<std::string> documents;
+  std::set<std::string> used_names{ sanitize_identifier(bundle_name) };
+  for (const auto &filename : filenames) {
+    auto name = sanitize_identifier(filename.stem().string());
+    if (!used_names.insert(name).second) {
+      throw std::runtime_error(fmt::format("Bundled document '{}' is named '{}' like another document or the bundle",
+        filename.string(),
+        name));
+    }
+    spdlog::info("Loading file: '{}'", filename.string());
+    std::ifstream input(filename);
+    if (!input) throw std::runtime_error(fmt::format("Unable to open '{}'", filename.string()));
+    input >> bundle.emplace_back();
+    documents.push_back(std::move(name));
+  }
+  const auto load_ms = elapsed_ms(load_start);
+  spdlog::info("{} files loaded", documents.size());
+  auto results = compile_impl(bundle_name, bundle, options, documents);
+  if (!options.report.empty()) results.report["phases_ms"]["load"] = load_ms;
+  return results;
+}
+
+void write_image(const nlohmann::ordered_json &json, const std::filesystem::path &filename, image_encoding encoding)
+{
+  if (encoding == image_encoding::utf16) {
+    ImageWriter<char16_t>(json).write(filename);
+  } else {
+    ImageWriter<char>(json).write(filename);
+  }
+}
+
+void write_image(const std::filesystem::path &input_file_name,
+  const std::filesystem::path &filename,
+  image_encoding encoding)
+{
+  spdlog::info("Loading file: '{}'", input_file_name.string());
+  std::ifstream input(input_file_name);
+  nlohmann::ordered_json document;
+  input >> document;
+  spdlog::info("File loaded");
+  write_image(document, filename, encoding);
 }
 
 void write_compilation([[maybe_unused]] std::string_view document_name,
@@ -1157,24 +3827,90 @@ void write_compilation([[maybe_unused]] std::string_view document_name,
   std::ofstream impl(impl_name);
   for (const auto &line : results.impl) { impl << line << '\n'; }
 
+  if (!results.typed.empty()) {
+    std::ofstream typed(append_extension(base_output, "_typed.hpp"));
+    for (const auto &line : results.typed) { typed << line << '\n'; }
+  }
+
   std::ofstream cpp(cpp_name);
   cpp << fmt::format("#include \"{}\"\n", impl_name.filename().string());
   cpp << fmt::format(
     "namespace compiled_json::{} {{\nconst json2cpp::json &get() {{ return compiled_json::{}::impl::document; }}\n}}\n",
     sanitized_name,
     sanitized_name);
+  if (results.schema) {
+    cpp << fmt::format(
+      "namespace compiled_json::{} {{\nconst json2cpp::schema_t &schema() {{ return compiled_json::{}::impl::schema; "
+      "}}\n}}\n",
+      sanitized_name,
+      sanitized_name);
+  }
+  if (results.precomputed_text) {
+    cpp << fmt::format(
+      "namespace compiled_json::{} {{\nstd::span<const json2cpp::precomputed_text_t> precomputed_text() {{ return "
+      "compiled_json::{}::impl::precomputed_text; }}\n}}\n",
+      sanitized_name,
+      sanitized_name);
+  }
+  for (std::size_t index = 0; index < results.documents.size(); ++index) {
+    cpp << fmt::format(
+      "namespace compiled_json::{} {{\nconst json2cpp::json &get() {{ return compiled_json::{}::impl::document[{}]; "
+      "}}\n}}\n",
+      results.documents[index],
+      sanitized_name,
+      index);
+  }
+  // Kept subtrees are looked up once, on their first use.
+  for (const auto &[name, lookup] : results.entries) {
+    cpp << fmt::format(
+      "namespace compiled_json::{} {{\nconst json2cpp::json &get_{}() {{ static const json2cpp::json &value = "
+      "get(){}; return value; }}\n}}\n",
+      sanitized_name,
+      name,
+      lookup);
+  }
+}
+
+namespace {
+void write_outputs(const std::string_view document_name,
+  compile_results &results,
+  const std::filesystem::path &base_output,
+  const compile_options &options)
+{
+  const auto write_start = std::chrono::steady_clock::now();
+  write_compilation(document_name, results, base_output);
+  if (options.report.empty()) return;
+
+  results.report["phases_ms"]["write"] = elapsed_ms(write_start);
+  std::ofstream report(options.report);
+  report << results.report.dump(2) << '\n';
+  spdlog::info("Layout report written to '{}'", options.report.string());
 }
+}// namespace
 
 void compile_to(const std::string_view document_name,
   const nlohmann::json &json,
-  const std::filesystem::path &base_output)
+  const std::filesystem::path &base_output,
+  const compile_options &options)
 {
-  write_compilation(document_name, compile(document_name, json), base_output);
+  auto results = compile(document_name, json, options);
+  write_outputs(document_name, results, base_output, options);
 }
 
 void compile_to(const std::string_view document_name,
   const std::filesystem::path &filename,
-  const std::filesystem::path &base_output)
+  const std::filesystem::path &base_output,
+  const compile_options &options)
+{
+  auto results = compile(document_name, filename, options);
+  write_outputs(document_name, results, base_output, options);
+}
+
+void compile_bundle_to(const std::string_view bundle_name,
+  const std::vector<std::filesystem::path> &filenames,
+  const std::filesystem::path &base_output,
+  const compile_options &options)
 {
-  write_compilation(document_name, compile(document_name, filename), base_output);
+  auto results = compile_bundle(bundle_name, filenames, options);
+  write_outputs(bundle_name, results, base_output, options);
 }
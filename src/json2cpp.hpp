@@ -29,17 +29,158 @@ SOFTWARE.
 #include <nlohmann/json.hpp>
 #include <spdlog/spdlog.h>
 #include <string>
+#include <utility>
 #include <vector>
 
 struct compile_results
 {
   std::vector<std::string> hpp;
   std::vector<std::string> impl;
+  // The document was compiled as a JSON Schema too; the firewall file also defines schema().
+  bool schema = false;
+  // Minified texts were precomputed; the firewall file also defines precomputed_text().
+  bool precomputed_text = false;
+  // Typed structs and their constexpr value, written to <base>_typed.hpp; empty unless compile_options::typed.
+  std::vector<std::string> typed;
+  // Documents of a bundle, in the order of its root array; the firewall file defines a get() for each of them.
+  std::vector<std::string> documents;
+  // Named subtrees kept by compile_options::keep, with the lookups from get() reaching each of them; the firewall file
+  // defines a get_<name>() for each.
+  std::vector<std::pair<std::string, std::string>> entries;
+  // Layouts, size estimates and phase timings gathered when compile_options::report is set.
+  nlohmann::ordered_json report;
 };
 
+// Order in which node definitions are written. Every order still defines a node after the nodes it references;
+// the top-down orders are written reversed.
+enum class layout_order { post, bfs, dfs_preorder, veb };
+
+// Layout requested for every object instead of the size-based choice. Objects that cannot take it (values that are
+// not pooled, too few keys for a perfect hash...) keep the automatic one.
+enum class object_layout {
+  automatic,
+  regular,
+  compact_inline,
+  value_by_reference,
+  blob_by_reference,
+  perfect_hash,
+  indexed_perfect_hash
+};
+
+// What the automatic layout choice optimizes: the smallest output, the fewest probes per lookup, the least constexpr
+// evaluation work for the compiler, or a weighted mix of the three.
+enum class optimization_goal { size, lookup_speed, compile_time, balanced };
+
+// How the document is defined. constexpr_data can be read at compile time. constinit_data defines the same nodes, in
+// the same object layouts, as constinit const variables with precomputed metadata, so they are never read while the
+// document is initialized; the document is then only reachable through get().
+enum class emission_mode { constexpr_data, constinit_data };
+
+// One line of a --keep manifest. The pattern is a JSON pointer whose reference tokens may also be '*', any one member
+// or element, or '**', any number of levels. A named pattern must select exactly one value, which then gets its own
+// get_<name>() firewall entry.
+struct kept_subtree
+{
+  std::string pattern;
+  std::string name;
+};
+
+// Thresholds of the layout choices. The defaults are hand-picked; json2cpp --autotune searches them for a lookup
+// workload and saves them with save_thresholds() for --config.
+struct layout_thresholds
+{
+  // Smallest object or array that is deduplicated.
+  std::size_t min_shared_object_size = 2;
+  std::size_t min_shared_array_size = 2;
+  // Uses a scalar needs before it is pooled (at least 2).
+  int min_scalar_references = 2;
+  // Bytes a compact, value-ref or blob layout must save over the regular one to be chosen for size.
+  double min_compact_savings = 64.0;
+  // Members an object needs before a perfect hash is built (they are limited to 255).
+  std::size_t min_mphf_size = 64;
+  // Leading members a perfect-hash lookup scans before the table when its prefix mask matches (the runtime scans 16
+  // at most; fewer leave more keys to the table).
+  std::size_t mphf_prefix_keys = 16;
+  // Objects of at most this many members whose key set repeats at least small_object_min_uses times stay regular.
+  std::size_t small_object_size = 4;
+  std::size_t small_object_min_uses = 12;
+  // Members an object needs before it gets a key filter, which rejects most missing keys before any scan or probe;
+  // 0 disables them.
+  std::size_t min_key_filter_size = 16;
+};
+
+layout_thresholds load_thresholds(const std::filesystem::path &filename);
+void save_thresholds(const std::filesystem::path &filename, const layout_thresholds &thresholds);
+
+struct compile_options
+{
+  // Place long strings, key descriptors and key blobs in shared, tail-merged character arrays.
+  bool string_arena = true;
+  // Compress string values longer than this many bytes; they are decompressed on demand at runtime. 0 disables.
+  std::size_t compress_strings_above = 0;
+  // Access profile written by json2cpp::write_access_profile (built with JSON2CPP_RECORD_ACCESS); empty disables.
+  std::filesystem::path profile;
+  // post keeps the recursive emission order; the others group nodes for breadth-first or depth-first traversal.
+  layout_order node_order = layout_order::post;
+  // Also compile the document as a JSON Schema into validation tables, see json2cpp/json2cpp_schema.hpp.
+  bool schema = false;
+  object_layout forced_layout = object_layout::automatic;
+  optimization_goal goal = optimization_goal::size;
+  layout_thresholds thresholds;
+  // Write the chosen layout, estimated savings, perfect hash search and size of every object, and the time spent in
+  // each phase, to this JSON file; empty disables.
+  std::filesystem::path report;
+  // JSON pointers of the arrays and objects whose minified text is emitted for json2cpp::dump_to(), see
+  // json2cpp/json2cpp_dump.hpp.
+  std::vector<std::string> precomputed_text;
+  // Also infer C++ structs from the document's shape and emit it as a constexpr aggregate of them.
+  bool typed = false;
+  // Emit string hashes, sorted flags and indexed blob storage computed here, through json::prehashed_string and
+  // json::prehashed_object, so that compiling the impl does no hashing, key validation or sort checks.
+  bool precompute_metadata = false;
+  // constinit_data cannot be combined with schema or precomputed_text.
+  emission_mode mode = emission_mode::constexpr_data;
+  // Emit only the values these patterns select and the objects and arrays on their paths, see keep_subtrees(); empty
+  // emits the whole document. Cannot be combined with schema.
+  std::vector<kept_subtree> keep;
+};
+
+// Reads a --keep manifest: one pattern, or name=pattern, per line; empty lines and lines starting with '#' are skipped.
+std::vector<kept_subtree> read_keep_manifest(const std::filesystem::path &filename);
+
+// The document reduced to the values the patterns select. Objects on their paths keep only those members, and arrays
+// on their paths keep their size with null in place of the other elements, so that indices keep their meaning.
+nlohmann::ordered_json keep_subtrees(const nlohmann::ordered_json &json, const std::vector<kept_subtree> &keep);
+
 std::string compile(const nlohmann::json &value, std::size_t &obj_count, std::vector<std::string> &lines);
-compile_results compile(const std::string_view document_name, const nlohmann::json &json);
-compile_results compile(const std::string_view document_name, const std::filesystem::path &filename);
+compile_results
+  compile(const std::string_view document_name, const nlohmann::json &json, const compile_options &options = {});
+compile_results compile(const std::string_view document_name,
+  const nlohmann::ordered_json &json,
+  const compile_options &options = {});
+compile_results compile(const std::string_view document_name,
+  const std::filesystem::path &filename,
+  const compile_options &options = {});
+
+// Compiles several files as the elements of one root array, so that they share the scalar pool, string arena, key
+// descriptors and deduplicated subtrees. compiled_json::<file stem>::get() returns each document and
+// compiled_json::<bundle_name>::get() the array.
+compile_results compile_bundle(const std::string_view bundle_name,
+  const std::vector<std::filesystem::path> &filenames,
+  const compile_options &options = {});
+
+// Character type of the strings of a runtime image; it must match the json2cpp::basic_image<CharType> loading it.
+enum class image_encoding { utf8, utf16 };
+
+// Writes the document as an image for json2cpp::basic_image (json2cpp/json2cpp_image.hpp) instead of C++ code. Objects
+// take the regular layout whatever the layout options, which the command line rejects together with --image; identical
+// strings and subtrees are stored once.
+void write_image(const nlohmann::ordered_json &json,
+  const std::filesystem::path &filename,
+  image_encoding encoding = image_encoding::utf8);
+void write_image(const std::filesystem::path &input_file_name,
+  const std::filesystem::path &filename,
+  image_encoding encoding = image_encoding::utf8);
 
 void write_compilation(std::string_view document_name,
   const compile_results &results,
@@ -47,10 +188,17 @@ void write_compilation(std::string_view document_name,
 
 void compile_to(const std::string_view document_name,
   const nlohmann::json &json,
-  const std::filesystem::path &base_output);
+  const std::filesystem::path &base_output,
+  const compile_options &options = {});
 
 void compile_to(const std::string_view document_name,
   const std::filesystem::path &filename,
-  const std::filesystem::path &base_output);
+  const std::filesystem::path &base_output,
+  const compile_options &options = {});
+
+void compile_bundle_to(const std::string_view bundle_name,
+  const std::vector<std::filesystem::path> &filenames,
+  const std::filesystem::path &base_output,
+  const compile_options &options = {});
 
 #endif
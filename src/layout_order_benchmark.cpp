@@ -0,0 +1,136 @@
+/*
+MIT License
+
+Copyright (c) 2026 Jason Turner, Regis Duflaut-Averty
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+// Compares the node layouts produced by json2cpp --layout-order on the same document: a full traversal and
+// shuffled lookups of every object path from the root.
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <string_view>
+#include <vector>
+
+#include <CLI/CLI.hpp>
+#include <spdlog/spdlog.h>
+
+#include "schema_bfs.hpp"
+#include "schema_dfs_preorder.hpp"
+#include "schema_post.hpp"
+#include "schema_veb.hpp"
+
+using key_path = std::vector<std::basic_string_view<json2cpp::basicType>>;
+
+// Paths of object members reachable from the root through objects only.
+void collect_paths(const json2cpp::json &node, key_path &path, std::vector<key_path> &paths)
+{
+  if (node.is_object()) {
+    for (const auto &[key, value] : node.items()) {
+      path.push_back(key.getString());
+      paths.push_back(path);
+      collect_paths(value, path, paths);
+      path.pop_back();
+    }
+  }
+}
+
+std::size_t walk(const json2cpp::json &node)
+{
+  std::size_t count = 1;
+  if (node.is_array()) {
+    for (std::size_t i = 0; i < node.size(); ++i) { count += walk(node[i]); }
+  } else if (node.is_object()) {
+    for (const auto &[key, value] : node.items()) { count += walk(value); }
+  }
+  return count;
+}
+
+std::size_t lookup(const json2cpp::json &root, const std::vector<key_path> &paths)
+{
+  std::size_t found = 0;
+  for (const auto &path : paths) {
+    const json2cpp::json *node = &root;
+    for (const auto key : path) { node = &node->at(key); }
+    found += node->size();
+  }
+  return found;
+}
+
+// Best of `repetitions` runs, in nanoseconds per item.
+template<typename Function> double best_ns_per_item(std::size_t repetitions, std::size_t items, Function function)
+{
+  auto best = std::numeric_limits<double>::max();
+  volatile std::size_t sink = 0;
+  for (std::size_t i = 0; i < repetitions; ++i) {
+    const auto start = std::chrono::steady_clock::now();
+    sink = sink + function();
+    const std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    best = std::min(best, elapsed.count() / static_cast<double>(items));
+  }
+  return best;
+}
+
+int main(int argc, const char **argv)
+{
+  try {
+    CLI::App app("layout_order_benchmark version 0.0.1");
+
+    std::size_t repetitions = 20;
+    std::uint32_t seed = 42;
+    app.add_option("--repetitions", repetitions, "Timed runs per measurement; the best one is reported");
+    app.add_option("--seed", seed, "Seed for the order of the lookups");
+    CLI11_PARSE(app, argc, argv);
+
+    struct document
+    {
+      std::string_view order;
+      const json2cpp::json &root;
+    };
+    const document documents[] = { { "post", compiled_json::energyplus_schema_post::get() },
+      { "bfs", compiled_json::energyplus_schema_bfs::get() },
+      { "dfs-preorder", compiled_json::energyplus_schema_dfs_preorder::get() },
+      { "veb", compiled_json::energyplus_schema_veb::get() } };
+
+    for (const auto &[order, root] : documents) {
+      std::vector<key_path> paths;
+      key_path path;
+      collect_paths(root, path, paths);
+      std::ranges::shuffle(paths, std::mt19937{ seed });
+
+      const auto nodes = walk(root);
+      const auto walk_ns = best_ns_per_item(repetitions, nodes, [&] { return walk(root); });
+      const auto lookup_ns = best_ns_per_item(repetitions, paths.size(), [&] { return lookup(root, paths); });
+      spdlog::info("{:>12}: walk {:.2f} ns/node ({} nodes), lookup {:.2f} ns/path ({} paths)",
+        order,
+        walk_ns,
+        nodes,
+        lookup_ns,
+        paths.size());
+    }
+  } catch (const std::exception &e) {
+    spdlog::error("Unhandled exception in main: {}", e.what());
+  }
+}
@@ -0,0 +1,308 @@
+/*
+MIT License
+
+Copyright (c) 2026 Jason Turner, Regis Duflaut-Averty
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+// Compares object lookups across the layouts forced by json2cpp --object-layout on the synthetic objects of
+// lookup_benchmark_data.hpp. Every operation is timed twice: as a dependent chain, where the next query depends on
+// the previous result (latency), and as independent queries (throughput). nlohmann::json and ordered_json answer the
+// same queries as a baseline in the char build.
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <numeric>
+#include <random>
+#include <set>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <CLI/CLI.hpp>
+#include <spdlog/spdlog.h>
+
+#include "lookup_benchmark_data.hpp"
+#include "lookup_blob_ref.hpp"
+#include "lookup_compact_inline.hpp"
+#include "lookup_indexed_perfect_hash.hpp"
+#include "lookup_perfect_hash.hpp"
+#include "lookup_regular.hpp"
+#include "lookup_value_ref.hpp"
+
+#ifdef JSON2CPP_USE_UTF16
+constexpr std::string_view char_type_name = "char16_t";
+#else
+constexpr std::string_view char_type_name = "char";
+#endif
+
+// Each measurement repeats its queries until it has made at least this many lookups.
+constexpr std::size_t min_lookups = 4096;
+
+using string_t = std::basic_string<json2cpp::basicType>;
+
+[[nodiscard]] string_t widen(std::string_view text) { return string_t(text.begin(), text.end()); }
+
+template<typename String> struct query_set
+{
+  std::vector<String> keys;
+  std::vector<String> missing_keys;
+  std::vector<String> values;
+  std::vector<String> missing_values;
+};
+
+template<typename String, typename Convert>
+[[nodiscard]] query_set<String> make_queries(std::size_t size, std::size_t key_length, std::uint32_t seed, Convert convert)
+{
+  query_set<String> queries;
+  for (std::size_t i = 0; i < size; ++i) {
+    queries.keys.push_back(convert(lookup_key(i, key_length)));
+    queries.missing_keys.push_back(convert(lookup_key(lookup_miss_offset + i, key_length)));
+    queries.values.push_back(convert(lookup_value(i)));
+    queries.missing_values.push_back(convert(fmt::format("w{}", i)));
+  }
+  std::mt19937 random{ seed };
+  std::ranges::shuffle(queries.keys, random);
+  std::ranges::shuffle(queries.missing_keys, random);
+  std::ranges::shuffle(queries.values, random);
+  return queries;
+}
+
+// Best of `repetitions` runs, in nanoseconds per item.
+template<typename Function> double best_ns_per_item(std::size_t repetitions, std::size_t items, Function function)
+{
+  auto best = std::numeric_limits<double>::max();
+  volatile std::size_t sink = 0;
+  for (std::size_t i = 0; i < repetitions; ++i) {
+    const auto start = std::chrono::steady_clock::now();
+    sink = sink + function();
+    const std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    best = std::min(best, elapsed.count() / static_cast<double>(items));
+  }
+  return best;
+}
+
+struct measurement
+{
+  double latency_ns = 0;
+  double throughput_ns = 0;
+};
+
+// `lookup` returns a number derived from its result, which picks the next query of the dependent chain.
+template<typename String, typename Lookup>
+[[nodiscard]] measurement measure(std::size_t repetitions, const std::vector<String> &queries, Lookup lookup)
+{
+  const auto count = queries.size();
+  const auto rounds = std::max<std::size_t>(1, min_lookups / count);
+  const auto items = rounds * count;
+
+  measurement result;
+  result.latency_ns = best_ns_per_item(repetitions, items, [&] {
+    std::size_t next = 0;
+    std::size_t sink = 0;
+    for (std::size_t i = 0; i < items; ++i) {
+      const std::size_t found = lookup(queries[next]);
+      sink += found;
+      next = (next + 1 + (found & 1u)) % count;
+    }
+    return sink;
+  });
+  result.throughput_ns = best_ns_per_item(repetitions, items, [&] {
+    std::size_t sink = 0;
+    for (std::size_t round = 0; round < rounds; ++round) {
+      for (const auto &query : queries) { sink += lookup(query); }
+    }
+    return sink;
+  });
+  return result;
+}
+
+void report(std::string_view layout, std::string_view object, std::string_view operation, const measurement &hit)
+{
+  spdlog::info("{:>8} {:>20} {:>9} {:>10}: hit {:7.2f} ns latency {:7.2f} ns/op",
+    char_type_name,
+    layout,
+    object,
+    operation,
+    hit.latency_ns,
+    hit.throughput_ns);
+}
+
+void report(std::string_view layout,
+  std::string_view object,
+  std::string_view operation,
+  const measurement &hit,
+  const measurement &miss)
+{
+  spdlog::info("{:>8} {:>20} {:>9} {:>10}: hit {:7.2f} ns latency {:7.2f} ns/op, miss {:7.2f} ns latency {:7.2f} ns/op",
+    char_type_name,
+    layout,
+    object,
+    operation,
+    hit.latency_ns,
+    hit.throughput_ns,
+    miss.latency_ns,
+    miss.throughput_ns);
+}
+
+void benchmark_json2cpp(std::string_view layout,
+  const json2cpp::json &root,
+  std::string_view object_name,
+  const query_set<string_t> &queries,
+  std::size_t repetitions)
+{
+  const auto &object = root.at(widen(object_name));
+
+  // at() throws on a missing key, so it is only timed on hits.
+  report(layout, object_name, "at", measure(repetitions, queries.keys, [&](const string_t &key) {
+    return object.at(key).size();
+  }));
+
+  const auto find_entry = [&](const string_t &key) { return static_cast<std::size_t>(object.find_entry(key) ? 1 : 0); };
+  report(layout,
+    object_name,
+    "find_entry",
+    measure(repetitions, queries.keys, find_entry),
+    measure(repetitions, queries.missing_keys, find_entry));
+
+  const auto contains = [&](const string_t &key) { return static_cast<std::size_t>(object.contains(key) ? 1 : 0); };
+  report(layout,
+    object_name,
+    "contains",
+    measure(repetitions, queries.keys, contains),
+    measure(repetitions, queries.missing_keys, contains));
+
+  const auto index = [&](const string_t &value) { return object.index(std::basic_string_view(value)); };
+  report(layout,
+    object_name,
+    "index",
+    measure(repetitions, queries.values, index),
+    measure(repetitions, queries.missing_values, index));
+}
+
+// Layout json2cpp gave each object of the document forced to `layout`, by JSON pointer, from the --report written
+// next to the generated sources. Objects that cannot take a forced layout fall back to another one.
+[[nodiscard]] std::map<std::string, std::string> reported_layouts(std::string_view layout)
+{
+  std::string suffix(layout);
+  std::ranges::replace(suffix, '-', '_');
+  std::ifstream file(fmt::format("{}/lookup_{}.report.json", JSON2CPP_LOOKUP_REPORT_DIR, suffix));
+  const auto report = nlohmann::json::parse(file);
+  std::map<std::string, std::string> layouts;
+  for (const auto &object : report.at("objects")) {
+    layouts[object.at("path").get<std::string>()] = object.at("layout").get<std::string>();
+  }
+  return layouts;
+}
+
+#ifndef JSON2CPP_USE_UTF16
+template<typename Json>
+void benchmark_nlohmann(std::string_view name,
+  const Json &root,
+  std::string_view object_name,
+  const query_set<std::string> &queries,
+  std::size_t repetitions)
+{
+  const auto &object = root.at(std::string(object_name));
+
+  report(name, object_name, "at", measure(repetitions, queries.keys, [&](const std::string &key) {
+    return object.at(key).template get_ref<const std::string &>().size();
+  }));
+
+  const auto find = [&](const std::string &key) { return static_cast<std::size_t>(object.find(key) != object.end()); };
+  report(name,
+    object_name,
+    "find",
+    measure(repetitions, queries.keys, find),
+    measure(repetitions, queries.missing_keys, find));
+
+  const auto contains = [&](const std::string &key) { return static_cast<std::size_t>(object.contains(key) ? 1 : 0); };
+  report(name,
+    object_name,
+    "contains",
+    measure(repetitions, queries.keys, contains),
+    measure(repetitions, queries.missing_keys, contains));
+}
+#endif
+
+int main(int argc, const char **argv)
+{
+  try {
+    CLI::App app("lookup_benchmark version 0.0.1");
+
+    std::size_t repetitions = 20;
+    std::uint32_t seed = 42;
+    app.add_option("--repetitions", repetitions, "Timed runs per measurement; the best one is reported");
+    app.add_option("--seed", seed, "Seed for the order of the queries");
+    CLI11_PARSE(app, argc, argv);
+
+    struct document
+    {
+      std::string_view layout;
+      const json2cpp::json &root;
+      std::map<std::string, std::string> layouts;
+    };
+    const document documents[] = {
+      { "regular", compiled_json::lookup_regular::get(), reported_layouts("regular") },
+      { "compact-inline", compiled_json::lookup_compact_inline::get(), reported_layouts("compact-inline") },
+      { "value-ref", compiled_json::lookup_value_ref::get(), reported_layouts("value-ref") },
+      { "blob-ref", compiled_json::lookup_blob_ref::get(), reported_layouts("blob-ref") },
+      { "perfect-hash", compiled_json::lookup_perfect_hash::get(), reported_layouts("perfect-hash") },
+      { "indexed-perfect-hash",
+        compiled_json::lookup_indexed_perfect_hash::get(),
+        reported_layouts("indexed-perfect-hash") }
+    };
+
+#ifndef JSON2CPP_USE_UTF16
+    const auto ordered = make_lookup_document();
+    const auto unordered = nlohmann::json::parse(ordered.dump());
+#endif
+
+    for (const auto size : lookup_object_sizes) {
+      for (const auto key_length : lookup_key_lengths) {
+        const auto object_name = lookup_object_name(size, key_length);
+        const auto queries = make_queries<string_t>(size, key_length, seed, widen);
+
+        // Rows are labelled with the layout each object actually got; a fallback would only repeat that row.
+        std::set<std::string> measured;
+        for (const auto &[layout, root, layouts] : documents) {
+          const auto &used = layouts.at("/" + object_name);
+          if (used != layout) { spdlog::info("{} {}: json2cpp fell back to {}", layout, object_name, used); }
+          if (!measured.insert(used).second) { continue; }
+          benchmark_json2cpp(used, root, object_name, queries, repetitions);
+        }
+
+#ifndef JSON2CPP_USE_UTF16
+        const auto narrow_queries =
+          make_queries<std::string>(size, key_length, seed, [](std::string text) { return text; });
+        benchmark_nlohmann("nlohmann::json", unordered, object_name, narrow_queries, repetitions);
+        benchmark_nlohmann("ordered_json", ordered, object_name, narrow_queries, repetitions);
+#endif
+      }
+    }
+  } catch (const std::exception &e) {
+    spdlog::error("Unhandled exception in main: {}", e.what());
+  }
+}
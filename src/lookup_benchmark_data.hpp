@@ -0,0 +1,82 @@
+/*
+MIT License
+
+Copyright (c) 2026 Jason Turner, Regis Duflaut-Averty
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef JSON2CPP_LOOKUP_BENCHMARK_DATA_HPP
+#define JSON2CPP_LOOKUP_BENCHMARK_DATA_HPP
+
+// Synthetic objects shared by lookup_benchmark_data, which writes them for json2cpp, and lookup_benchmark, which
+// queries them. The document holds one object per size and key length, named "o<size>_k<key length>".
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include <fmt/format.h>
+#include <nlohmann/json.hpp>
+
+inline constexpr std::array<std::size_t, 4> lookup_object_sizes{ 4, 16, 64, 200 };
+inline constexpr std::array<std::size_t, 3> lookup_key_lengths{ 4, 16, 48 };
+// Values repeat so that they are pooled, which the by-reference layouts require.
+inline constexpr std::size_t lookup_value_count = 16;
+// Indices from here on name keys and values absent from every object.
+inline constexpr std::size_t lookup_miss_offset = 1000;
+
+[[nodiscard]] inline std::string lookup_object_name(std::size_t size, std::size_t key_length)
+{
+  return fmt::format("o{}_k{}", size, key_length);
+}
+
+// Letters derived from the index, ending in the index in base 26 so that keys never collide.
+[[nodiscard]] inline std::string lookup_key(std::size_t index, std::size_t length)
+{
+  std::string key(length, 'a');
+  auto state = static_cast<std::uint64_t>(index) * 0x9E3779B97F4A7C15u + 1u;
+  for (std::size_t i = 0; i + 3 < length; ++i) {
+    state ^= state >> 29u;
+    state *= 0xBF58476D1CE4E5B9u;
+    key[i] = static_cast<char>('a' + (state >> 32u) % 26u);
+  }
+  for (std::size_t i = 0; i < 3; ++i) {
+    key[length - 1 - i] = static_cast<char>('a' + index % 26u);
+    index /= 26u;
+  }
+  return key;
+}
+
+[[nodiscard]] inline std::string lookup_value(std::size_t index) { return fmt::format("v{}", index % lookup_value_count); }
+
+[[nodiscard]] inline nlohmann::ordered_json make_lookup_document()
+{
+  auto document = nlohmann::ordered_json::object();
+  for (const auto size : lookup_object_sizes) {
+    for (const auto key_length : lookup_key_lengths) {
+      auto &object = document[lookup_object_name(size, key_length)] = nlohmann::ordered_json::object();
+      for (std::size_t i = 0; i < size; ++i) { object[lookup_key(i, key_length)] = lookup_value(i); }
+    }
+  }
+  return document;
+}
+
+#endif
@@ -22,11 +22,17 @@ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 SOFTWARE.
 */
 
+#include <cstdlib>
 #include <filesystem>
 #include <fstream>
 #include <functional>
 #include <iostream>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <vector>
 
+#include "autotune.hpp"
 #include "json2cpp.hpp"
 #include <CLI/CLI.hpp>
 #include <spdlog/spdlog.h>
@@ -42,14 +48,141 @@ int main(int argc, const char **argv)
     std::filesystem::path output_base_name;
 
     bool show_version = false;
+    compile_options options;
+    bool no_string_arena = false;
     app.add_flag("--version", show_version, "Show version information");
+    app.add_flag("--no-string-arena", no_string_arena, "Emit every string as its own literal instead of a shared arena");
+    app.add_option("--compress-strings-above",
+      options.compress_strings_above,
+      "Compress string values longer than this many bytes (0 disables)");
+    app.add_option("--profile", options.profile, "Access profile used to group hot nodes and speed up their lookups");
+    app
+      .add_option("--layout-order", options.node_order, "Order of the emitted node definitions")
+      ->transform(CLI::CheckedTransformer(std::map<std::string, layout_order>{ { "post", layout_order::post },
+                                            { "bfs", layout_order::bfs },
+                                            { "dfs-preorder", layout_order::dfs_preorder },
+                                            { "veb", layout_order::veb } },
+        CLI::ignore_case));
+    app
+      .add_option(
+        "--object-layout", options.forced_layout, "Layout of every object that allows it, instead of the automatic one")
+      ->transform(CLI::CheckedTransformer(std::map<std::string, object_layout>{ { "auto", object_layout::automatic },
+                                            { "regular", object_layout::regular },
+                                            { "compact-inline", object_layout::compact_inline },
+                                            { "value-ref", object_layout::value_by_reference },
+                                            { "blob-ref", object_layout::blob_by_reference },
+                                            { "perfect-hash", object_layout::perfect_hash },
+                                            { "indexed-perfect-hash", object_layout::indexed_perfect_hash } },
+        CLI::ignore_case));
+    app
+      .add_option("--optimize-for", options.goal, "What the automatic object layout choice optimizes")
+      ->transform(CLI::CheckedTransformer(std::map<std::string, optimization_goal>{ { "size", optimization_goal::size },
+                                            { "lookup-speed", optimization_goal::lookup_speed },
+                                            { "compile-time", optimization_goal::compile_time },
+                                            { "balanced", optimization_goal::balanced } },
+        CLI::ignore_case));
+    auto *schema_flag =
+      app.add_flag("--schema", options.schema, "Also compile the document as a JSON Schema into validation tables");
+    app.add_option("--report",
+      options.report,
+      "Write the layout, estimated savings, perfect hash search and size of every object, and phase timings, as JSON");
+    auto *typed_flag = app.add_flag(
+      "--typed", options.typed, "Also write <output_base_name>_typed.hpp with structs inferred from the document");
+    app.add_flag("--precompute-metadata",
+      options.precompute_metadata,
+      "Emit string hashes, sorted flags and indexed blob storage precomputed, so compiling does no constexpr hashing");
+    app
+      .add_option("--mode",
+        options.mode,
+        "Emit constexpr data (default), or constinit data with precomputed metadata that only get() reaches")
+      ->transform(
+        CLI::CheckedTransformer(std::map<std::string, emission_mode>{ { "constexpr", emission_mode::constexpr_data },
+                                  { "constinit", emission_mode::constinit_data } },
+          CLI::ignore_case));
+    app.add_option("--precompute-text",
+      options.precomputed_text,
+      "JSON pointer of an array or object whose minified text is emitted for json2cpp::dump_to (repeatable)");
+    std::filesystem::path config_file;
+    app.add_option("--config", config_file, "Layout thresholds saved by --autotune")->check(CLI::ExistingFile);
+    std::filesystem::path save_config_file;
+    app.add_option("--save-config", save_config_file, "Also write the layout thresholds in effect as a --config file");
+    autotune_options tuning;
+    if (const char *compiler = std::getenv("CXX")) { tuning.compiler = compiler; }
+    tuning.include_dir = std::filesystem::path(argv[0]).parent_path() / ".." / "include";
+    auto *autotune_option = app.add_option("--autotune",
+      tuning.lookups,
+      "Tune the layout thresholds for these lookups (JSON pointers, one per line) and save them to "
+      "<output_base_name>.config.json");
+    app.add_option("--tune-compiler", tuning.compiler, "Compiler building the autotune candidates (default $CXX)");
+    app.add_option("--tune-include", tuning.include_dir, "Directory holding json2cpp/json2cpp.hpp for the candidates");
+    app.add_option("--tune-candidates", tuning.max_candidates, "Autotune candidates built at most");
+    bool image = false;
+    image_encoding encoding = image_encoding::utf8;
+    auto *image_flag = app.add_flag("--image",
+      image,
+      "Write <output_base_name>.j2ci, an image loaded at runtime by json2cpp::image, instead of C++ code");
+    app.add_option("--image-encoding", encoding, "Character type of the image strings (utf16 for JSON2CPP_USE_UTF16)")
+      ->transform(CLI::CheckedTransformer(
+        std::map<std::string, image_encoding>{ { "utf8", image_encoding::utf8 }, { "utf16", image_encoding::utf16 } },
+        CLI::ignore_case));
+    std::filesystem::path keep_manifest;
+    app
+      .add_option("--keep",
+        keep_manifest,
+        "Emit only the subtrees selected by this manifest of JSON pointers ('*' and '**' match any member or levels), "
+        "one per line; name=pointer also declares get_<name>()")
+      ->check(CLI::ExistingFile)
+      ->excludes(image_flag)
+      ->excludes(schema_flag);
+    std::vector<std::string> bundle;
+    std::filesystem::path bundle_output;
+    app
+      .add_option("--bundle",
+        bundle,
+        "<bundle_name> <input_file_name>...: compile the files together with shared pools and subtrees; each keeps a "
+        "get() in the namespace of its file stem")
+      ->excludes(schema_flag)
+      ->excludes(typed_flag)
+      ->excludes(autotune_option);
+    app.add_option("--bundle-output", bundle_output, "Output base name of the bundle (default <bundle_name>)");
     app.add_option("<document_name>", document_name);
     app.add_option("<input_file_name>", input_file_name);
     app.add_option("<output_base_name>", output_base_name);
     CLI11_PARSE(app, argc, argv);
 
-    compile_to(document_name, input_file_name, output_base_name);
+    options.string_arena = !no_string_arena;
+    if (!config_file.empty()) { options.thresholds = load_thresholds(config_file); }
+    if (!keep_manifest.empty()) { options.keep = read_keep_manifest(keep_manifest); }
+    if (!bundle.empty()) {
+      if (bundle.size() < 2) { throw std::runtime_error("--bundle needs a name and at least one input file"); }
+      if (bundle_output.empty()) { bundle_output = bundle.front(); }
+      compile_bundle_to(bundle.front(), { bundle.begin() + 1, bundle.end() }, bundle_output, options);
+      return EXIT_SUCCESS;
+    }
+    if (image) {
+      // Images hold regular objects only, see write_image().
+      for (const auto *layout_option : { "--object-layout", "--optimize-for", "--profile", "--config" }) {
+        if (app.count(layout_option) != 0) {
+          throw std::runtime_error(fmt::format("{} cannot be combined with --image", layout_option));
+        }
+      }
+      auto image_name = output_base_name;
+      image_name += ".j2ci";
+      write_image(input_file_name, image_name, encoding);
+      return EXIT_SUCCESS;
+    }
+    if (!tuning.lookups.empty()) {
+      tuning.work_dir = std::filesystem::temp_directory_path() / fmt::format("json2cpp_autotune_{}", document_name);
+      options.thresholds = autotune(input_file_name, options, tuning);
+      auto config_name = output_base_name;
+      config_name += ".config.json";
+      save_thresholds(config_name, options.thresholds);
+      spdlog::info("Tuned layout thresholds written to '{}'", config_name.string());
+    }
+    if (!save_config_file.empty()) { save_thresholds(save_config_file, options.thresholds); }
+    compile_to(document_name, input_file_name, output_base_name, options);
   } catch (const std::exception &e) {
     spdlog::error("Unhandled exception in main: {}", e.what());
+    return EXIT_FAILURE;
   }
 }
@@ -0,0 +1,167 @@
+/*
+MIT License
+
+Copyright (c) 2026 Jason Turner, Regis Duflaut-Averty
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef JSON2CPP_PERF_COUNTERS_HPP
+#define JSON2CPP_PERF_COUNTERS_HPP
+
+// Hardware counters of the calling thread, read with perf_event_open on Linux. Events the kernel refuses (no PMU in
+// a virtual machine, perf_event_paranoid) are left out of the results and listed by refused(); elsewhere there are
+// no counters at all.
+
+#include <array>
+#include <cerrno>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+class perf_counters
+{
+public:
+  struct result
+  {
+    std::string_view name;
+    // Scaled up when the kernel multiplexed the counter with others.
+    double value = 0;
+  };
+
+  struct refusal
+  {
+    std::string_view name;
+    // errno of perf_event_open.
+    int error = 0;
+  };
+
+  perf_counters()
+  {
+#ifdef __linux__
+    constexpr auto cache_event = [](std::uint64_t cache, std::uint64_t op, std::uint64_t result_type) {
+      return cache | (op << 8u) | (result_type << 16u);
+    };
+    const std::array<event, 5> events{ { { "cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+      { "instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+      { "L1d misses",
+        PERF_TYPE_HW_CACHE,
+        cache_event(PERF_COUNT_HW_CACHE_L1D, PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_MISS) },
+      { "LLC misses",
+        PERF_TYPE_HW_CACHE,
+        cache_event(PERF_COUNT_HW_CACHE_LL, PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_MISS) },
+      { "dTLB misses",
+        PERF_TYPE_HW_CACHE,
+        cache_event(PERF_COUNT_HW_CACHE_DTLB, PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_MISS) } } };
+
+    for (const auto &current : events) {
+      perf_event_attr attributes{};
+      attributes.size = sizeof(attributes);
+      attributes.type = current.type;
+      attributes.config = current.config;
+      attributes.disabled = 1;
+      attributes.exclude_kernel = 1;
+      attributes.exclude_hv = 1;
+      attributes.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+      const auto fd = static_cast<int>(syscall(SYS_perf_event_open, &attributes, 0, -1, -1, 0));
+      if (fd >= 0) {
+        counters_.push_back({ current.name, fd });
+      } else {
+        refused_.push_back({ current.name, errno });
+      }
+    }
+#endif
+  }
+
+  perf_counters(const perf_counters &) = delete;
+  perf_counters &operator=(const perf_counters &) = delete;
+
+  ~perf_counters()
+  {
+#ifdef __linux__
+    for (const auto &counter : counters_) { close(counter.fd); }
+#endif
+  }
+
+  [[nodiscard]] bool available() const noexcept { return !counters_.empty(); }
+
+  [[nodiscard]] const std::vector<refusal> &refused() const noexcept { return refused_; }
+
+  // Counts from zero until stop().
+  void start() noexcept
+  {
+#ifdef __linux__
+    for (const auto &counter : counters_) {
+      ioctl(counter.fd, PERF_EVENT_IOC_RESET, 0);
+      ioctl(counter.fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+#endif
+  }
+
+  void stop() noexcept
+  {
+#ifdef __linux__
+    for (const auto &counter : counters_) { ioctl(counter.fd, PERF_EVENT_IOC_DISABLE, 0); }
+#endif
+  }
+
+  [[nodiscard]] std::vector<result> read() const
+  {
+    std::vector<result> results;
+#ifdef __linux__
+    for (const auto &counter : counters_) {
+      // value, time enabled, time running
+      std::array<std::uint64_t, 3> values{};
+      if (::read(counter.fd, values.data(), sizeof(values)) != static_cast<ssize_t>(sizeof(values))) { continue; }
+      auto value = static_cast<double>(values[0]);
+      if (values[2] != 0 && values[2] < values[1]) {
+        value *= static_cast<double>(values[1]) / static_cast<double>(values[2]);
+      }
+      results.push_back({ counter.name, value });
+    }
+#endif
+    return results;
+  }
+
+private:
+  struct event
+  {
+    std::string_view name;
+    std::uint32_t type;
+    std::uint64_t config;
+  };
+
+  struct open_counter
+  {
+    std::string_view name;
+    int fd;
+  };
+
+  std::vector<open_counter> counters_;
+  std::vector<refusal> refused_;
+};
+
+#endif
@@ -22,8 +22,16 @@ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 SOFTWARE.
 */
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
 #include <filesystem>
 #include <fstream>
+#include <stdexcept>
 #ifdef __GNUC__
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
@@ -33,8 +41,11 @@ SOFTWARE.
 #pragma GCC diagnostic pop
 #endif
 #include <iostream>
+#include <thread>
+#include <vector>
 
 #include <CLI/CLI.hpp>
+#include <fmt/format.h>
 #include <spdlog/spdlog.h>
 
 #include <json2cpp/json2cpp_adapter.hpp>
@@ -43,23 +54,175 @@ SOFTWARE.
 #include <valijson/schema_parser.hpp>
 #include <valijson/validator.hpp>
 
+#include "perf_counters.hpp"
 #include "schema.hpp"
 
+// Lets the tables compiled by `json2cpp --schema` validate a document loaded with nlohmann::json.
+template<> struct json2cpp::schema::value_traits<nlohmann::json>
+{
+  static uint8_t type(const nlohmann::json &value) noexcept
+  {
+    switch (value.type()) {
+    case nlohmann::json::value_t::object:
+      return object_type;
+    case nlohmann::json::value_t::array:
+      return array_type;
+    case nlohmann::json::value_t::string:
+      return string_type;
+    case nlohmann::json::value_t::number_integer:
+    case nlohmann::json::value_t::number_unsigned:
+      return integer_type;
+    case nlohmann::json::value_t::number_float:
+      return number_type;
+    case nlohmann::json::value_t::boolean:
+      return boolean_type;
+    default:
+      return null_type;
+    }
+  }
+
+  static double number(const nlohmann::json &value) { return value.get<double>(); }
+
+  static size_t size(const nlohmann::json &value) noexcept { return value.size(); }
 
-bool validate(const std::filesystem::path &schema_file_name, const std::filesystem::path &file_to_validate)
+  static size_t string_length(const nlohmann::json &value)
+  {
+    return code_point_count(std::string_view{ value.get_ref<const std::string &>() });
+  }
+
+  static bool enum_contains(const nlohmann::json &value, const json2cpp::json &strings)
+  {
+    return strings.contains(std::string_view{ value.get_ref<const std::string &>() });
+  }
+
+  static bool enum_equals(const nlohmann::json &value, const json2cpp::json &other)
+  {
+    if (value.is_null()) return other.is_null();
+    if (value.is_boolean()) return other.is_boolean() && value.get<bool>() == other.get<bool>();
+    if (value.is_number()) return other.is_number() && value.get<double>() == other.get<double>();
+    if (value.is_string()) return other.is_string() && other == std::string_view{ value.get_ref<const std::string &>() };
+    if (value.is_array()) {
+      if (!other.is_array() || other.size() != value.size()) return false;
+      for (std::size_t i = 0; i < value.size(); ++i) {
+        if (!enum_equals(value[i], other[i])) return false;
+      }
+      return true;
+    }
+    if (!other.is_object() || other.size() != value.size()) return false;
+    for (const auto &[key, child] : value.items()) {
+      const auto entry = other.find_entry(key);
+      if (!entry || !enum_equals(child, *entry.second)) return false;
+    }
+    return true;
+  }
+
+  template<typename Function> static bool for_each_element(const nlohmann::json &value, Function &&function)
+  {
+    for (const auto &child : value) {
+      if (!function(child)) return false;
+    }
+    return true;
+  }
+
+  template<typename Function> static bool for_each_member(const nlohmann::json &value, Function &&function)
+  {
+    for (const auto &[key, child] : value.items()) {
+      if (!function(std::string_view{ key }, json2cpp::json::calc_hash(key), child)) return false;
+    }
+    return true;
+  }
+};
+
+
+// Checks each top-level member of an object document on a thread pool, against the matching subschema of the
+// schema's "properties" object parsed alone. The other root keywords are checked once, against a copy of the schema
+// whose property subschemas are emptied. An EnergyPlus model thus splits into one task per object type.
+bool validate_parallel(const nlohmann::json &schema, const nlohmann::json &document, std::size_t jobs)
 {
   using valijson::Schema;
   using valijson::SchemaParser;
   using valijson::Validator;
-  using valijson::adapters::json2cppJsonAdapter;
   using valijson::adapters::NlohmannJsonAdapter;
 
-  // Parse JSON schema content using valijson
-  spdlog::info("Creating Schema object");
-  Schema mySchema;
-  spdlog::info("Creating SchemaParser object");
-  SchemaParser parser;
+  const auto &properties = schema["properties"];
+  nlohmann::json root_schema = nlohmann::json::object();
+  for (const auto &[keyword, value] : schema.items()) {
+    if (keyword != "properties") { root_schema[keyword] = value; }
+  }
+  auto &names = root_schema["properties"] = nlohmann::json::object();
+  for (const auto &[name, unused] : properties.items()) { names[name] = nlohmann::json::object(); }
+
+  const auto validate_against = [](const nlohmann::json &subschema, const nlohmann::json &value) {
+    Schema mySchema;
+    SchemaParser parser;
+    parser.populateSchema(NlohmannJsonAdapter(subschema), mySchema);
+    Validator validator;
+    return validator.validate(mySchema, NlohmannJsonAdapter(value), nullptr);
+  };
+
+  std::vector<nlohmann::json::const_iterator> members;
+  for (auto member = document.begin(); member != document.end(); ++member) {
+    if (properties.contains(member.key())) { members.push_back(member); }
+  }
+
+  // Task members.size() is the root; results are chars so that threads write separate objects.
+  std::vector<char> results(members.size() + 1, 0);
+  std::vector<std::exception_ptr> errors(jobs);
+  std::atomic<std::size_t> next_task{ 0 };
+  spdlog::info("Validating {} members on {} threads", members.size(), jobs);
+  {
+    std::vector<std::jthread> workers;
+    for (std::size_t worker = 0; worker < jobs; ++worker) {
+      workers.emplace_back([&, worker] {
+        try {
+          for (auto task = next_task++; task <= members.size(); task = next_task++) {
+            const bool valid = task == members.size()
+                                 ? validate_against(root_schema, document)
+                                 : validate_against(properties[members[task].key()], members[task].value());
+            results[task] = static_cast<char>(valid);
+          }
+        } catch (...) {
+          errors[worker] = std::current_exception();
+        }
+      });
+    }
+  }
+  for (const auto &error : errors) {
+    if (error) { std::rethrow_exception(error); }
+  }
+
+  bool result = results.back() != 0;
+  if (!result) { spdlog::info("root keywords failed validation"); }
+  for (std::size_t i = 0; i < members.size(); ++i) {
+    if (results[i] == 0) {
+      spdlog::info("member '{}' failed validation", members[i].key());
+      result = false;
+    }
+  }
+  return result;
+}
 
+// Whether any subschema uses "$ref". References may point outside the property subschema parsed alone by
+// validate_parallel, into "definitions" for instance.
+bool contains_ref(const nlohmann::json &schema)
+{
+  if (schema.is_object() && schema.contains("$ref")) { return true; }
+  if (!schema.is_structured()) { return false; }
+  for (const auto &child : schema) {
+    if (contains_ref(child)) { return true; }
+  }
+  return false;
+}
+
+bool validate(const std::filesystem::path &schema_file_name,
+  const std::filesystem::path &file_to_validate,
+  std::size_t jobs)
+{
+  using valijson::Schema;
+  using valijson::SchemaParser;
+  using valijson::Validator;
+  using valijson::adapters::json2cppJsonAdapter;
+  using valijson::adapters::NlohmannJsonAdapter;
 
   spdlog::info("Creating nlohmann::json object");
   nlohmann::json schema;
@@ -67,19 +230,35 @@ bool validate(const std::filesystem::path &schema_file_name, const std::filesyst
   std::ifstream schema_file(schema_file_name);
   spdlog::info("Loading json file");
   schema_file >> schema;
-  spdlog::info("Creating NlohmannJsonAdapter object");
-  NlohmannJsonAdapter mySchemaAdapter(schema);
-  spdlog::info("parser.populateSchema object");
-  parser.populateSchema(mySchemaAdapter, mySchema);
 
-  spdlog::info("Creating Validator object");
-  Validator validator;
   spdlog::info("Creating nlohmann::json object");
   nlohmann::json document;
   spdlog::info("Opening json file");
   std::ifstream input_file(file_to_validate);
   spdlog::info("Loading json file");
   input_file >> document;
+
+  if (jobs > 1 && contains_ref(schema)) {
+    spdlog::info("Schema uses $ref, validating on one thread");
+  } else if (jobs > 1 && schema.is_object() && schema.contains("properties") && schema["properties"].is_object()
+             && document.is_object()) {
+    const auto result = validate_parallel(schema, document, jobs);
+    spdlog::info("returning result {}", result);
+    return result;
+  }
+
+  // Parse JSON schema content using valijson
+  spdlog::info("Creating Schema object");
+  Schema mySchema;
+  spdlog::info("Creating SchemaParser object");
+  SchemaParser parser;
+  spdlog::info("Creating NlohmannJsonAdapter object");
+  NlohmannJsonAdapter mySchemaAdapter(schema);
+  spdlog::info("parser.populateSchema object");
+  parser.populateSchema(mySchemaAdapter, mySchema);
+
+  spdlog::info("Creating Validator object");
+  Validator validator;
   spdlog::info("Creating NlohmannJsonAdapter object");
   NlohmannJsonAdapter myTargetAdapter(document);
 
@@ -126,37 +305,124 @@ bool validate_internal(const std::filesystem::path &file_to_validate)
   return result;
 }
 
-template<typename JSON>
-void walk_internal(std::int64_t &int_sum,
-  double &double_sum,
-  std::size_t &string_sizes,
-  int &null_count,
-  int &array_count,
-  int &object_count,
-  const JSON &obj)
+bool validate_native(const std::filesystem::path &file_to_validate)
 {
-  if (obj.is_number_integer()) {
-    int_sum += obj.template get<std::int64_t>();
-  } else if (obj.is_number_float()) {
-    double_sum += obj.template get<double>();
-  } else if (obj.is_string()) {
-    string_sizes += obj.template get<std::string_view>().size();
-  } else if (obj.is_null()) {
-    ++null_count;
-  } else if (obj.is_array()) {
-    ++array_count;
-    for (const auto &child : obj) {
-      walk_internal(int_sum, double_sum, string_sizes, null_count, array_count, object_count, child);
-    }
-  } else if (obj.is_object()) {
-    ++object_count;
-    for (const auto &child : obj) {
-      walk_internal(int_sum, double_sum, string_sizes, null_count, array_count, object_count, child);
-    }
+  spdlog::info("Creating nlohmann::json object");
+  nlohmann::json document;
+  spdlog::info("Opening json file");
+  std::ifstream input_file(file_to_validate);
+  spdlog::info("Loading json file");
+  input_file >> document;
+
+  spdlog::info("schema.validate");
+  json2cpp::schema::error_t error;
+  const auto result = compiled_json::energyplus_schema::schema().validate(document, error);
+  if (!result) spdlog::info("validation failed: {} (schema node {})", error.reason, error.node);
+  spdlog::info("returning result {}", result);
+
+  return result;
+}
+
+// Feeds nlohmann's SAX events to the compiled schema tables, so that the document is never held in memory. Parsing
+// stops at the first invalid value.
+class schema_stream_sax
+{
+public:
+  explicit schema_stream_sax(const json2cpp::schema_t &schema) : stream_(schema) {}
+
+  bool null() { return scalar({ .type = json2cpp::schema::null_type }); }
+
+  bool boolean(bool value) { return scalar({ .type = json2cpp::schema::boolean_type, .boolean = value }); }
+
+  bool number_integer(nlohmann::json::number_integer_t value)
+  {
+    return scalar({ .type = json2cpp::schema::integer_type, .number = static_cast<double>(value) });
+  }
+
+  bool number_unsigned(nlohmann::json::number_unsigned_t value)
+  {
+    return scalar({ .type = json2cpp::schema::integer_type, .number = static_cast<double>(value) });
+  }
+
+  bool number_float(nlohmann::json::number_float_t value, const nlohmann::json::string_t & /*unused*/)
+  {
+    return scalar({ .type = json2cpp::schema::number_type, .number = value });
+  }
+
+  bool string(nlohmann::json::string_t &value)
+  {
+    return scalar({ .type = json2cpp::schema::string_type, .string = value });
+  }
+
+  bool binary(nlohmann::json::binary_t & /*unused*/)
+  {
+    throw std::runtime_error("binary values cannot be validated against a JSON Schema");
+  }
+
+  bool start_object(std::size_t /*unused*/)
+  {
+    stream_.begin_object();
+    return stream_.valid();
+  }
+
+  bool key(nlohmann::json::string_t &value)
+  {
+    stream_.key(value);
+    return true;
+  }
+
+  bool end_object()
+  {
+    stream_.end_object();
+    return stream_.valid();
+  }
+
+  bool start_array(std::size_t /*unused*/)
+  {
+    stream_.begin_array();
+    return stream_.valid();
+  }
+
+  bool end_array()
+  {
+    stream_.end_array();
+    return stream_.valid();
   }
+
+  bool parse_error(std::size_t position, const std::string & /*unused*/, const nlohmann::json::exception &error)
+  {
+    throw std::runtime_error(fmt::format("parse error at byte {}: {}", position, error.what()));
+  }
+
+  [[nodiscard]] const json2cpp::schema_stream_t &stream() const noexcept { return stream_; }
+
+private:
+  bool scalar(const json2cpp::schema_stream_t::scalar_type &value)
+  {
+    stream_.scalar(value);
+    return stream_.valid();
+  }
+
+  json2cpp::schema_stream_t stream_;
+};
+
+bool validate_stream(const std::filesystem::path &file_to_validate)
+{
+  spdlog::info("Opening json file");
+  std::ifstream input_file(file_to_validate);
+  schema_stream_sax handler(compiled_json::energyplus_schema::schema());
+
+  spdlog::info("Streaming json file through schema");
+  nlohmann::json::sax_parse(input_file, &handler);
+  const auto &stream = handler.stream();
+  const auto result = stream.valid();
+  if (!result) spdlog::info("validation failed: {} (schema node {})", stream.error().reason, stream.error().node);
+  spdlog::info("returning result {}", result);
+
+  return result;
 }
 
-template<typename JSON> void walk(const JSON &objects)
+struct walk_totals
 {
   std::int64_t int_sum{};
   double double_sum{};
@@ -164,12 +430,96 @@ template<typename JSON> void walk(const JSON &objects)
   int null_count{};
   int array_count{};
   int object_count{};
+};
+
+template<typename JSON> void walk_internal(walk_totals &totals, const JSON &obj)
+{
+  if (obj.is_number_integer()) {
+    totals.int_sum += obj.template get<std::int64_t>();
+  } else if (obj.is_number_float()) {
+    totals.double_sum += obj.template get<double>();
+  } else if (obj.is_string()) {
+    totals.string_sizes += obj.template get<std::string_view>().size();
+  } else if (obj.is_null()) {
+    ++totals.null_count;
+  } else if (obj.is_array()) {
+    ++totals.array_count;
+    for (const auto &child : obj) { walk_internal(totals, child); }
+  } else if (obj.is_object()) {
+    ++totals.object_count;
+    for (const auto &child : obj) { walk_internal(totals, child); }
+  }
+}
+
+// Nearest-rank percentile of sorted durations.
+double percentile(const std::vector<double> &sorted, double fraction)
+{
+  const auto rank = static_cast<std::size_t>(std::ceil(fraction * static_cast<double>(sorted.size())));
+  return sorted[std::clamp<std::size_t>(rank, 1, sorted.size()) - 1];
+}
 
-  spdlog::info("Starting tree walk");
+// Walks the whole document `warmup` times untimed, then `repeat` times with timing and hardware counters.
+template<typename JSON> void walk(const JSON &objects, std::size_t warmup, std::size_t repeat)
+{
+  spdlog::info("Starting tree walk: {} warm-up and {} timed runs", warmup, repeat);
 
-  walk_internal(int_sum, double_sum, string_sizes, null_count, array_count, object_count, objects);
+  walk_totals totals;
+  for (std::size_t i = 0; i < warmup; ++i) {
+    totals = {};
+    walk_internal(totals, objects);
+  }
 
-  spdlog::info("{} {} {} {} {} {}", int_sum, double_sum, string_sizes, null_count, array_count, object_count);
+  perf_counters counters;
+  for (const auto &[name, error] : counters.refused()) {
+    spdlog::warn("Hardware counter '{}' is not available: {}", name, std::strerror(error));
+  }
+  if (!counters.available()) { spdlog::warn("Hardware counters are not available, only timing the walks"); }
+
+  std::vector<double> durations;
+  struct event_total
+  {
+    std::string_view name;
+    double sum = 0;
+    std::size_t runs = 0;
+  };
+  std::vector<event_total> counts;
+  for (std::size_t i = 0; i < repeat; ++i) {
+    totals = {};
+    counters.start();
+    const auto start = std::chrono::steady_clock::now();
+    walk_internal(totals, objects);
+    const std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+    counters.stop();
+    durations.push_back(elapsed.count());
+
+    // A counter whose read fails is missing from that run only, so the sums are matched by event.
+    for (const auto &[name, value] : counters.read()) {
+      auto total = std::ranges::find(counts, name, &event_total::name);
+      if (total == counts.end()) { total = counts.insert(counts.end(), { name }); }
+      total->sum += value;
+      ++total->runs;
+    }
+  }
+
+  spdlog::info("{} {} {} {} {} {}",
+    totals.int_sum,
+    totals.double_sum,
+    totals.string_sizes,
+    totals.null_count,
+    totals.array_count,
+    totals.object_count);
+
+  if (durations.empty()) { return; }
+  std::ranges::sort(durations);
+  spdlog::info("walk: median {:.1f} us, p99 {:.1f} us, min {:.1f} us, max {:.1f} us over {} runs",
+    percentile(durations, 0.5),
+    percentile(durations, 0.99),
+    durations.front(),
+    durations.back(),
+    durations.size());
+  for (const auto &[name, sum, runs] : counts) {
+    spdlog::info("{:>12}: {:.0f} per walk", name, sum / static_cast<double>(runs));
+  }
 }
 
 int main(int argc, const char **argv)
@@ -183,18 +533,33 @@ int main(int argc, const char **argv)
 
     bool do_walk = false;
     bool internal = false;
+    bool native = false;
+    bool stream = false;
     bool show_version = false;
+    std::size_t jobs = 1;
+    std::size_t warmup = 0;
+    std::size_t repeat = 1;
     app.add_option("<schema_file>", schema_file_name);
     auto *doc = app.add_option("<document_to_validate>", document_to_validate);
     app.add_flag("--version", show_version, "Show version information");
     app.add_flag("--walk", do_walk, "Just walk the schema and count objects (perf test)")->excludes(doc);
+    app.add_option("--warmup", warmup, "Untimed walks before the timed ones")->needs("--walk");
+    app.add_option("--repeat", repeat, "Timed walks; the median and p99 times are reported")->needs("--walk");
     app.add_flag("--internal", internal, "Use internal schema");
+    app.add_flag("--native", native, "Validate with the tables compiled from the internal schema, without valijson");
+    app.add_flag("--stream", stream, "Validate with the compiled tables while reading, without loading the document");
+    app.add_option("--jobs", jobs, "Validate the top-level members of the document on this many threads (0: one per core)")
+      ->excludes("--internal")
+      ->excludes("--native")
+      ->excludes("--stream");
 
     CLI11_PARSE(app, argc, argv);
 
+    if (jobs == 0) { jobs = std::max(1U, std::thread::hardware_concurrency()); }
+
     if (do_walk) {
       if (internal) {
-        walk(compiled_json::energyplus_schema::get());
+        walk(compiled_json::energyplus_schema::get(), warmup, repeat);
       } else {
         spdlog::info("Creating nlohmann::json object");
         nlohmann::json schema;
@@ -202,18 +567,24 @@ int main(int argc, const char **argv)
         std::ifstream schema_file(schema_file_name);
         spdlog::info("Loading json file");
         schema_file >> schema;
-        walk(schema);
+        walk(schema, warmup, repeat);
       }
       return EXIT_SUCCESS;
     }
 
-    if (internal) {
-      validate_internal(document_to_validate);
+    bool valid = false;
+    if (stream) {
+      valid = validate_stream(document_to_validate);
+    } else if (native) {
+      valid = validate_native(document_to_validate);
+    } else if (internal) {
+      valid = validate_internal(document_to_validate);
     } else {
-      validate(schema_file_name, document_to_validate);
+      valid = validate(schema_file_name, document_to_validate, jobs);
     }
-
+    return valid ? EXIT_SUCCESS : EXIT_FAILURE;
   } catch (const std::exception &e) {
     spdlog::error("Unhandled exception in main: {}", e.what());
+    return EXIT_FAILURE;
   }
 }
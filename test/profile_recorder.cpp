@@ -0,0 +1,31 @@
+// Records a fixed set of lookups on examples/profile.json and writes their access profile to argv[1]. The tests
+// target compiles the document again with that profile and checks the counts and the hot prefix it produced.
+#include "test_profile_source.hpp"
+#include <cstdlib>
+#include <fstream>
+#include <string_view>
+
+int main(int argc, const char **argv)
+{
+  if (argc != 2) { return EXIT_FAILURE; }
+
+  const auto &document = compiled_json::test_profile_source::get();
+  const auto &members = document["members"];
+
+  // k71 through each lookup function once, so every lookup must be counted exactly once.
+  const std::string_view k71 = "k71";
+  if (members.at(k71).get<int>() != 7 || members["k71"].get<int>() != 7 || !members.contains(k71)
+      || !members.contains("k71") || !members.find_entry(k71)) {
+    return EXIT_FAILURE;
+  }
+  for (int i = 0; i < 3; ++i) {
+    if (members[std::string_view("k42")].get<int>() != 2) { return EXIT_FAILURE; }
+  }
+  if (!members.contains(std::string_view("k9")) || members.contains("missing") || members.find_entry("k80")) {
+    return EXIT_FAILURE;
+  }
+
+  std::ofstream out(argv[1]);
+  json2cpp::write_access_profile(document, out);
+  return out ? EXIT_SUCCESS : EXIT_FAILURE;
+}
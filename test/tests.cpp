@@ -1,5 +1,72 @@
+#include "examples_bundle.hpp"
+#include "test_constraints.hpp"
+#include "test_constraints_schema.hpp"
+#include "test_enum_members.hpp"
+#include "test_enum_members_schema.hpp"
 #include "test_json.hpp"
+#include "test_json_configured.hpp"
+#include "test_json_constinit.hpp"
+#include "test_json_filtered.hpp"
+#include "test_json_kept.hpp"
+#include "test_json_precomputed.hpp"
+#include "test_json_typed.hpp"
+#include "test_key_filter_blob_ref.hpp"
+#include "test_key_filter_blob_ref_constinit.hpp"
+#include "test_key_filter_blob_ref_constinit_report.hpp"
+#include "test_key_filter_blob_ref_report.hpp"
+#include "test_key_filter_compact_inline.hpp"
+#include "test_key_filter_compact_inline_constinit.hpp"
+#include "test_key_filter_compact_inline_constinit_report.hpp"
+#include "test_key_filter_compact_inline_report.hpp"
+#include "test_key_filter_indexed_perfect_hash.hpp"
+#include "test_key_filter_indexed_perfect_hash_constinit.hpp"
+#include "test_key_filter_indexed_perfect_hash_constinit_report.hpp"
+#include "test_key_filter_indexed_perfect_hash_report.hpp"
+#include "test_key_filter_layouts.hpp"
+#include "test_key_filter_perfect_hash.hpp"
+#include "test_key_filter_perfect_hash_constinit.hpp"
+#include "test_key_filter_perfect_hash_constinit_report.hpp"
+#include "test_key_filter_perfect_hash_report.hpp"
+#include "test_key_filter_regular.hpp"
+#include "test_key_filter_regular_constinit.hpp"
+#include "test_key_filter_regular_constinit_report.hpp"
+#include "test_key_filter_regular_report.hpp"
+#include "test_key_filter_value_ref.hpp"
+#include "test_key_filter_value_ref_constinit.hpp"
+#include "test_key_filter_value_ref_constinit_report.hpp"
+#include "test_key_filter_value_ref_report.hpp"
+#include "test_layout_order_bfs.hpp"
+#include "test_layout_order_dfs_preorder.hpp"
+#include "test_layout_order_veb.hpp"
+#include "test_optimize_for.hpp"
+#include "test_optimize_for_balanced.hpp"
+#include "test_optimize_for_compile_time.hpp"
+#include "test_optimize_for_lookup_speed.hpp"
+#include "test_profile_report.hpp"
+#include "test_profiled.hpp"
+#include "test_reported_report.hpp"
+#include "test_schema.hpp"
+#include "test_strings.hpp"
+#include "test_strings_compressed.hpp"
+#include "test_strings_no_arena.hpp"
+#include "test_thresholds.hpp"
+#include "test_thresholds_saved.hpp"
 #include <catch2/catch_test_macros.hpp>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <json2cpp/json2cpp_dump.hpp>
+#include <json2cpp/json2cpp_image.hpp>
+#include <json2cpp/json2cpp_overlay.hpp>
+#include <json2cpp/json2cpp_registry.hpp>
+#include <json2cpp/json2cpp_schema.hpp>
+#include <json2cpp/json2cpp_string_cache.hpp>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <vector>
 
 TEST_CASE("Can read object size")
 {
@@ -27,3 +94,593 @@ TEST_CASE("Can read iterator key")
   const auto &document = compiled_json::test_json::get();
   REQUIRE(document.begin().key() == "glossary");
 }
+
+TEST_CASE("Can dump a compiled document as minified JSON")
+{
+  const auto &document = compiled_json::test_json::get();
+  const std::string expected =
+    R"({"glossary":{"title":"example glossary","GlossDiv":{"title":"S","subtitle":null,"GlossList":{"GlossEntry":)"
+    R"({"ID":"SGML","SortAs":"SGML","GlossTerm":"Standard Generalized Markup Language","Acronym":"SGML",)"
+    R"("Abbrev":"ISO 8879:1986","GlossDef":{"para":"A meta-markup language, used to create markup languages such )"
+    R"(as DocBook.","GlossSeeAlso":["GML","XML"]},"GlossSee":"markup"}}}}})";
+
+  CHECK(json2cpp::dump(document) == expected);
+
+  const json2cpp::text_index texts(document, compiled_json::test_json::precomputed_text());
+  REQUIRE(texts.size() == 1);
+  REQUIRE(texts.find(document["glossary"]["GlossDiv"]) != nullptr);
+  CHECK(json2cpp::dump(document, &texts) == expected);
+
+  std::string out = "prefix ";
+  json2cpp::dump_to(document["glossary"]["GlossDiv"]["GlossList"]["GlossEntry"]["GlossDef"]["GlossSeeAlso"], out);
+  CHECK(out == R"(prefix ["GML","XML"])");
+}
+
+// Requires two documents compiled from the same JSON to agree node by node: type, size, the hash of scalars (an
+// object's metadata also holds its layout and key filter bits), the sorted flag of objects, string text (through
+// get_string(), so compressed strings compare too) and each member found by its key.
+// `visit` gets every pair of nodes for the checks of the variant under test.
+void require_same_nodes(const json2cpp::json &expected,
+  const json2cpp::json &actual,
+  const std::function<void(const json2cpp::json &, const json2cpp::json &)> &visit = {})
+{
+  REQUIRE(actual.type() == expected.type());
+  REQUIRE(actual.size() == expected.size());
+  if (!expected.is_object()) { REQUIRE(actual.hash() == expected.hash()); }
+  if (visit) { visit(expected, actual); }
+  if (expected.is_string()) {
+    REQUIRE(json2cpp::get_string(actual).get() == json2cpp::get_string(expected).get());
+  } else if (expected.is_object()) {
+    REQUIRE(actual.is_sorted_obj() == expected.is_sorted_obj());
+    for (const auto &[key, value] : expected.items()) {
+      REQUIRE(actual.contains(key.getString()));
+      require_same_nodes(value, actual[key.getString()], visit);
+    }
+    REQUIRE_FALSE(actual.contains("missing"));
+  } else if (expected.is_array()) {
+    for (std::size_t i = 0; i < expected.size(); ++i) { require_same_nodes(expected[i], actual[i], visit); }
+  }
+}
+
+TEST_CASE("Strings in the string arena read like separate literals")
+{
+  const auto &arena = compiled_json::test_strings::get();
+  const auto &literals = compiled_json::test_strings_no_arena::get();
+  REQUIRE(json2cpp::dump(arena) == json2cpp::dump(literals));
+
+  require_same_nodes(literals, arena, [](const json2cpp::json &expected, const json2cpp::json &actual) {
+    if (expected.is_string()) { REQUIRE(actual.getString() == expected.getString()); }
+  });
+
+  // Duplicates share one copy and a string ending another points into its tail.
+  const auto title = arena["title"].getString();
+  CHECK(arena["copy of title"].getString().data() == title.data());
+  CHECK(arena["nested"]["title"].getString().data() == title.data());
+  CHECK(arena["title suffix"].getString().data() == title.data() + title.size() - arena["title suffix"].size());
+  CHECK(arena["paragraphs"][20].getString().data() == arena["paragraphs"][0].getString().data());
+}
+
+TEST_CASE("Compressed strings decompress to the uncompressed document")
+{
+  const auto &document = compiled_json::test_strings::get();
+  const auto &compressed = compiled_json::test_strings_compressed::get();
+  REQUIRE(json2cpp::dump(compressed) == json2cpp::dump(document));
+
+  std::size_t compressed_count = 0;
+  require_same_nodes(document, compressed, [&](const json2cpp::json &expected, const json2cpp::json &actual) {
+    if (!expected.is_string()) { return; }
+    if (actual.is_compressed_string()) { ++compressed_count; }
+    REQUIRE(json2cpp::get_string(actual).get() == expected.getString());
+    REQUIRE(actual == expected);
+    REQUIRE(expected == actual);
+  });
+  REQUIRE(compressed_count > 20);
+  REQUIRE_FALSE(compressed["short"].is_compressed_string());
+  REQUIRE(compressed["paragraphs"][0] != compressed["paragraphs"][1]);
+  REQUIRE(compressed["paragraphs"][0] == compressed["paragraphs"][20]);
+#ifndef NDEBUG
+  REQUIRE_THROWS_AS(compressed["paragraphs"][0].getString(), std::domain_error);
+#endif
+
+  const auto &paragraphs = compressed["paragraphs"];
+  const auto bytes = [&](std::size_t index) { return paragraphs[index].size() * sizeof(json2cpp::basicType); };
+  json2cpp::string_cache cache(bytes(0) + bytes(1));
+  const auto first = cache.get(paragraphs[0]);
+  REQUIRE(first.get() == document["paragraphs"][0].getString());
+  REQUIRE(cache.get(paragraphs[0]).storage == first.storage);
+  const auto second = cache.get(paragraphs[1]);
+  REQUIRE(cache.size_bytes() == bytes(0) + bytes(1));
+
+  // The third string evicts the least recently used one; handles keep their text alive.
+  REQUIRE(cache.get(paragraphs[2]).get() == document["paragraphs"][2].getString());
+  REQUIRE(cache.size_bytes() <= cache.capacity_bytes());
+  REQUIRE(first.get() == document["paragraphs"][0].getString());
+  REQUIRE(cache.get(paragraphs[0]).storage != first.storage);
+  REQUIRE(second.get() == document["paragraphs"][1].getString());
+
+  cache.clear();
+  REQUIRE(cache.size_bytes() == 0);
+  REQUIRE(cache.get(document["title"]).storage == nullptr);
+}
+
+TEST_CASE("Can read the documents of a bundle")
+{
+  const auto &bundle = compiled_json::examples_bundle::get();
+  REQUIRE(bundle.size() == 3);
+
+  const auto &test = compiled_json::test::get();
+  REQUIRE(&test == &bundle[0]);
+  REQUIRE(json2cpp::dump(test) == json2cpp::dump(compiled_json::test_json::get()));
+
+  const auto &integers = compiled_json::array_integers_10_20_30_40::get();
+  const auto &doubles = compiled_json::array_doubles_10_20_30_40::get();
+  REQUIRE(integers.size() == 4);
+  REQUIRE(integers[3].get<std::int64_t>() == 40);
+  REQUIRE(doubles.size() == 4);
+  REQUIRE(doubles[0].get<double>() == 10.0);
+}
+
+TEST_CASE("Precomputed metadata matches the metadata computed at compile time")
+{
+  const auto &document = compiled_json::test_json::get();
+  const auto &precomputed = compiled_json::test_json_precomputed::get();
+  REQUIRE(json2cpp::dump(precomputed) == json2cpp::dump(document));
+  require_same_nodes(document, precomputed);
+}
+
+TEST_CASE("Constinit documents read like the constexpr document")
+{
+  const auto &document = compiled_json::test_json::get();
+  const auto &constinit_document = compiled_json::test_json_constinit::get();
+  REQUIRE(json2cpp::dump(constinit_document) == json2cpp::dump(document));
+  require_same_nodes(document, constinit_document);
+}
+
+// Present keys must still be found through an object's key filter, and the missing ones must not be.
+void require_filtered_lookups(const json2cpp::json &object)
+{
+  REQUIRE(object.has_key_filter() == (object.size() != 0));
+  for (const auto &[key, child] : object.items()) {
+    REQUIRE(object.find_entry(key.getString()).second == &object[key.getString()]);
+  }
+  for (const std::string_view missing : { "missing", "title ", "ID2", "glossary_", "key40", "" }) {
+    REQUIRE_FALSE(object.contains(missing));
+    REQUIRE_FALSE(object.find_entry(missing));
+  }
+}
+
+TEST_CASE("Key filters reject missing keys without hiding present ones")
+{
+  const auto &document = compiled_json::test_json::get();
+  const auto &filtered = compiled_json::test_json_filtered::get();
+  REQUIRE(json2cpp::dump(filtered) == json2cpp::dump(document));
+  require_same_nodes(document, filtered, [](const json2cpp::json &, const json2cpp::json &actual) {
+    if (actual.is_object()) { require_filtered_lookups(actual); }
+  });
+  REQUIRE_FALSE(document["glossary"].has_key_filter());
+}
+
+TEST_CASE("Key filters work in every object layout")
+{
+  const auto &document = compiled_json::test_key_filter_layouts::get();
+
+  struct variant
+  {
+    std::string_view layout;
+    const json2cpp::json &filtered;
+    const json2cpp::json &report;
+  };
+  const variant variants[] = {
+    { "regular", compiled_json::test_key_filter_regular::get(), compiled_json::test_key_filter_regular_report::get() },
+    { "compact-inline",
+      compiled_json::test_key_filter_compact_inline::get(),
+      compiled_json::test_key_filter_compact_inline_report::get() },
+    { "value-ref",
+      compiled_json::test_key_filter_value_ref::get(),
+      compiled_json::test_key_filter_value_ref_report::get() },
+    { "blob-ref", compiled_json::test_key_filter_blob_ref::get(), compiled_json::test_key_filter_blob_ref_report::get() },
+    { "perfect-hash",
+      compiled_json::test_key_filter_perfect_hash::get(),
+      compiled_json::test_key_filter_perfect_hash_report::get() },
+    { "indexed-perfect-hash",
+      compiled_json::test_key_filter_indexed_perfect_hash::get(),
+      compiled_json::test_key_filter_indexed_perfect_hash_report::get() },
+    // Constinit nodes take the same layouts.
+    { "regular",
+      compiled_json::test_key_filter_regular_constinit::get(),
+      compiled_json::test_key_filter_regular_constinit_report::get() },
+    { "compact-inline",
+      compiled_json::test_key_filter_compact_inline_constinit::get(),
+      compiled_json::test_key_filter_compact_inline_constinit_report::get() },
+    { "value-ref",
+      compiled_json::test_key_filter_value_ref_constinit::get(),
+      compiled_json::test_key_filter_value_ref_constinit_report::get() },
+    { "blob-ref",
+      compiled_json::test_key_filter_blob_ref_constinit::get(),
+      compiled_json::test_key_filter_blob_ref_constinit_report::get() },
+    { "perfect-hash",
+      compiled_json::test_key_filter_perfect_hash_constinit::get(),
+      compiled_json::test_key_filter_perfect_hash_constinit_report::get() },
+    { "indexed-perfect-hash",
+      compiled_json::test_key_filter_indexed_perfect_hash_constinit::get(),
+      compiled_json::test_key_filter_indexed_perfect_hash_constinit_report::get() }
+  };
+  for (const auto &[layout, filtered, report] : variants) {
+    INFO(layout);
+    // The report tells that the object took the forced layout instead of falling back to another one.
+    const json2cpp::json *members = nullptr;
+    for (const auto &object : report["objects"]) {
+      if (object["path"].getString() == "/members") { members = &object; }
+    }
+    REQUIRE(members != nullptr);
+    REQUIRE((*members)["layout"].getString() == layout);
+
+    REQUIRE(json2cpp::dump(filtered) == json2cpp::dump(document));
+    require_same_nodes(document, filtered, [](const json2cpp::json &, const json2cpp::json &actual) {
+      if (actual.is_object()) { require_filtered_lookups(actual); }
+    });
+  }
+}
+
+TEST_CASE("Every optimization goal reads like the default one")
+{
+  const auto &document = compiled_json::test_optimize_for::get();
+
+  const std::pair<std::string_view, const json2cpp::json &> goals[] = {
+    { "lookup-speed", compiled_json::test_optimize_for_lookup_speed::get() },
+    { "compile-time", compiled_json::test_optimize_for_compile_time::get() },
+    { "balanced", compiled_json::test_optimize_for_balanced::get() }
+  };
+  for (const auto &[goal, optimized] : goals) {
+    INFO(goal);
+    REQUIRE(json2cpp::dump(optimized) == json2cpp::dump(document));
+    require_same_nodes(document, optimized);
+  }
+}
+
+TEST_CASE("Every node order reads like the default one")
+{
+  const auto &document = compiled_json::test_optimize_for::get();
+
+  const std::pair<std::string_view, const json2cpp::json &> orders[] = {
+    { "bfs", compiled_json::test_layout_order_bfs::get() },
+    { "dfs-preorder", compiled_json::test_layout_order_dfs_preorder::get() },
+    { "veb", compiled_json::test_layout_order_veb::get() }
+  };
+  for (const auto &[order, reordered] : orders) {
+    INFO(order);
+    // Only the definitions move: members still iterate in source order.
+    require_same_nodes(document, reordered, [](const json2cpp::json &expected, const json2cpp::json &actual) {
+      if (!expected.is_object()) { return; }
+      std::vector<std::string_view> expected_keys;
+      std::vector<std::string_view> actual_keys;
+      for (const auto &[key, value] : expected.items()) { expected_keys.push_back(key.getString()); }
+      for (const auto &[key, value] : actual.items()) { actual_keys.push_back(key.getString()); }
+      REQUIRE(actual_keys == expected_keys);
+    });
+  }
+}
+
+TEST_CASE("Kept subtrees are emitted alone and reachable by name")
+{
+  const auto &document = compiled_json::test_json::get();
+  const auto &kept = compiled_json::test_json_kept::get();
+  const auto &entry = document["glossary"]["GlossDiv"]["GlossList"]["GlossEntry"];
+  REQUIRE(json2cpp::dump(compiled_json::test_json_kept::get_definition()) == json2cpp::dump(entry["GlossDef"]));
+  REQUIRE(&compiled_json::test_json_kept::get_definition()
+          == &kept["glossary"]["GlossDiv"]["GlossList"]["GlossEntry"]["GlossDef"]);
+
+  REQUIRE(kept["glossary"].size() == 2);
+  REQUIRE(kept["glossary"]["title"].getString() == document["glossary"]["title"].getString());
+  REQUIRE(kept["glossary"]["GlossDiv"].size() == 1);
+  const auto &kept_entry = kept["glossary"]["GlossDiv"]["GlossList"]["GlossEntry"];
+  REQUIRE(kept_entry.size() == 2);
+  REQUIRE(kept_entry["ID"].getString() == entry["ID"].getString());
+  REQUIRE_FALSE(kept_entry.contains("GlossTerm"));
+}
+
+TEST_CASE("Saved layout thresholds load back unchanged")
+{
+  const auto &config = compiled_json::test_thresholds::get();
+  const auto &saved = compiled_json::test_thresholds_saved::get();
+
+  // The example changes every threshold, so each one has to survive load_thresholds and save_thresholds.
+  REQUIRE(saved.size() == config.size());
+  for (const auto &[key, value] : config.items()) {
+    INFO(key.getString());
+    REQUIRE(saved.contains(key.getString()));
+    CHECK(saved[key.getString()].get<double>() == value.get<double>());
+  }
+
+  CHECK(json2cpp::dump(compiled_json::test_json_configured::get()) == json2cpp::dump(compiled_json::test_json::get()));
+}
+
+TEST_CASE("Recorded lookups are counted once and lead the perfect-hash prefix")
+{
+  std::ifstream input(JSON2CPP_TEST_PROFILE);
+  std::set<std::string> lines;
+  for (std::string line; std::getline(input, line);) { lines.insert(line); }
+  CHECK(lines.contains("5 /members/k71"));
+  CHECK(lines.contains("3 /members/k42"));
+  CHECK(lines.contains("1 /members/k9"));
+  CHECK(lines.contains("12 /members"));
+
+  const auto &report = compiled_json::test_profile_report::get();
+  const json2cpp::json *members = nullptr;
+  for (const auto &object : report["objects"]) {
+    if (object["path"].getString() == "/members") { members = &object; }
+  }
+  REQUIRE(members != nullptr);
+  CHECK((*members)["mphf"]["built"].get<bool>());
+  const auto &hot_prefix = (*members)["hot_prefix"];
+  REQUIRE(hot_prefix.size() >= 3);
+  CHECK(hot_prefix[0].getString() == "k71");
+  CHECK(hot_prefix[1].getString() == "k42");
+  CHECK(hot_prefix[2].getString() == "k9");
+
+  const auto &profiled = compiled_json::test_profiled::get()["members"];
+  REQUIRE(profiled.size() == 80);
+  for (const auto &[key, value] : profiled.items()) { REQUIRE(profiled[key.getString()] == value); }
+  CHECK(profiled["k71"].get<int>() == 7);
+  CHECK_FALSE(profiled.contains("missing"));
+}
+
+TEST_CASE("Can read a compiled document through its typed structs")
+{
+  constexpr const auto &typed = compiled_json::test_json::typed::document;
+  STATIC_REQUIRE(typed.glossary.GlossDiv.title == "S");
+  STATIC_REQUIRE(typed.glossary.GlossDiv.GlossList.GlossEntry.GlossDef.GlossSeeAlso.size() == 2);
+  STATIC_REQUIRE(typed.glossary.GlossDiv.subtitle == nullptr);
+
+  const auto &document = compiled_json::test_json::get();
+  const auto &entry = document["glossary"]["GlossDiv"]["GlossList"]["GlossEntry"];
+  REQUIRE(typed.glossary.GlossDiv.GlossList.GlossEntry.GlossTerm == entry["GlossTerm"].getString());
+  REQUIRE(typed.glossary.GlossDiv.GlossList.GlossEntry.GlossDef.GlossSeeAlso[1]
+          == entry["GlossDef"]["GlossSeeAlso"][1].getString());
+}
+
+TEST_CASE("Can load a document from a runtime image")
+{
+  const json2cpp::image image(JSON2CPP_TEST_IMAGE);
+  const auto &document = image.root();
+  const auto &compiled = compiled_json::test_json::get();
+
+  REQUIRE(document.size() == 1);
+  REQUIRE(document["glossary"]["GlossDiv"]["title"].getString() == "S");
+  REQUIRE(document["glossary"]["GlossDiv"]["subtitle"].is_null());
+  REQUIRE(json2cpp::dump(document) == json2cpp::dump(compiled));
+
+  const auto &entry = document["glossary"]["GlossDiv"]["GlossList"]["GlossEntry"];
+  REQUIRE(entry["GlossTerm"].getString() == "Standard Generalized Markup Language");
+  REQUIRE(entry["GlossDef"]["GlossSeeAlso"][1].getString() == "XML");
+}
+
+TEST_CASE("Images whose node lengths run past the file are refused")
+{
+  std::ifstream input(JSON2CPP_TEST_IMAGE, std::ios::binary);
+  std::vector<char> bytes((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+  json2cpp::detail::image_header_t header{};
+  REQUIRE(bytes.size() >= sizeof(header));
+  std::memcpy(&header, bytes.data(), sizeof(header));
+
+  // The relocations are intact; only the member count of the root object grows past the end of the image.
+  const uint32_t length = 1u << 24u;
+  std::memcpy(bytes.data() + header.root, &length, sizeof(length));
+  const auto corrupt = std::filesystem::temp_directory_path() / "json2cpp_corrupt_length.j2ci";
+  std::ofstream(corrupt, std::ios::binary).write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+
+  REQUIRE_THROWS_AS(json2cpp::image(corrupt), std::runtime_error);
+  std::filesystem::remove(corrupt);
+}
+
+TEST_CASE("Can reload an image while a reader holds the previous one")
+{
+  json2cpp::document_registry registry(JSON2CPP_TEST_IMAGE);
+  REQUIRE(registry.generation() == 1);
+
+  {
+    const auto first = registry.pin();
+    registry.reload();
+    REQUIRE(registry.generation() == 2);
+    REQUIRE(first.generation() == 1);
+    REQUIRE(registry.collect() == 1);
+    REQUIRE(first->at("glossary")["GlossDiv"]["title"].getString() == "S");
+
+    const auto second = registry.pin();
+    REQUIRE(second.generation() == 2);
+    REQUIRE(json2cpp::dump(second.root()) == json2cpp::dump(first.root()));
+  }
+  REQUIRE(registry.collect() == 0);
+}
+
+TEST_CASE("Can patch a compiled document through an overlay")
+{
+  const auto &document = compiled_json::test_json::get();
+  const auto &entry = document["glossary"]["GlossDiv"]["GlossList"]["GlossEntry"];
+  json2cpp::overlay overlay(document);
+
+  std::string title = "patched title";
+  overlay.set("/glossary/title", json2cpp::json(std::string_view(title)));
+  title.clear();
+  CHECK(overlay.root()["glossary"]["title"].getString() == "patched title");
+  CHECK(document["glossary"]["title"].getString() == "example glossary");
+  CHECK_FALSE(overlay.root()["glossary"]["GlossDiv"].patched());
+
+  overlay.set("/glossary/GlossDiv/GlossList/GlossEntry/GlossDef/GlossSeeAlso/1", json2cpp::json(42));
+  overlay.erase("/glossary/GlossDiv/GlossList/GlossEntry/Acronym");
+  overlay.set("/glossary/GlossDiv/GlossList/GlossEntry/a~1b", json2cpp::json(true));
+
+  const auto patched = overlay.at("/glossary/GlossDiv/GlossList/GlossEntry");
+  CHECK(patched["GlossDef"]["GlossSeeAlso"][1].get<int>() == 42);
+  CHECK(patched["GlossDef"]["GlossSeeAlso"][0].getString() == "GML");
+  CHECK_FALSE(patched.contains("Acronym"));
+  CHECK(patched.contains("a/b"));
+  REQUIRE(patched.size() == entry.size());
+
+  std::vector<std::string> keys;
+  for (const auto &[key, value] : patched.items()) { keys.emplace_back(key); }
+  REQUIRE(keys.size() == entry.size());
+  CHECK(keys.back() == "a/b");
+
+  overlay.clear();
+  CHECK(overlay.empty());
+  CHECK(overlay.root()["glossary"]["title"].getString() == "example glossary");
+}
+
+TEST_CASE("Layout report totals the objects of each layout")
+{
+  const auto &report = compiled_json::test_reported_report::get();
+  CHECK(report["document"].getString() == "test_reported");
+
+  // The six objects of the test document are too small for any layout but the regular one.
+  const auto &regular = report["layouts"]["regular"];
+  CHECK(regular["objects"].get<std::size_t>() == 6);
+  CHECK(regular["members"].get<std::size_t>() == 16);
+  CHECK(regular["bytes"].get<std::size_t>() == 16 * sizeof(json2cpp::basic_value_pair_t<char>));
+
+  REQUIRE(report["objects"].size() == 6);
+  for (const auto &[layout, total] : report["layouts"].items()) {
+    INFO(layout.getString());
+    std::size_t objects = 0;
+    std::size_t members = 0;
+    std::size_t bytes = 0;
+    for (const auto &object : report["objects"]) {
+      if (object["layout"] != layout.getString()) { continue; }
+      ++objects;
+      members += object["members"].get<std::size_t>();
+      bytes += object["bytes"].get<std::size_t>();
+    }
+    CHECK(total["objects"].get<std::size_t>() == objects);
+    CHECK(total["members"].get<std::size_t>() == members);
+    CHECK(total["bytes"].get<std::size_t>() == bytes);
+  }
+
+  const json2cpp::json *glossary = nullptr;
+  for (const auto &object : report["objects"]) {
+    if (object["path"].getString() == "/glossary") { glossary = &object; }
+  }
+  REQUIRE(glossary != nullptr);
+  CHECK((*glossary)["members"].get<std::size_t>() == 2);
+  CHECK((*glossary)["bytes"].get<std::size_t>() == 2 * sizeof(json2cpp::basic_value_pair_t<char>));
+}
+
+TEST_CASE("Can validate a document against compiled schema tables")
+{
+  const auto &document = compiled_json::test_json::get();
+  const auto &schema = compiled_json::test_schema::schema();
+
+  REQUIRE(schema.validate(document));
+
+  json2cpp::schema::error_t error;
+  REQUIRE_FALSE(schema.validate(document["glossary"], error));
+  CHECK(error.reason == "type");
+  CHECK(error.node != json2cpp::schema::no_node);
+
+  error = {};
+  REQUIRE_FALSE(schema.validate(document["glossary"]["GlossDiv"]["title"], error));
+  CHECK(error.reason == "type");
+  CHECK(error.node == 0);
+}
+
+TEST_CASE("Compiled schema tables report each failing constraint")
+{
+  const auto &document = compiled_json::test_constraints::get();
+  const auto &schema = compiled_json::test_constraints_schema::schema();
+
+  // Includes decimal multiples such as 0.3 of 0.1, whose quotient is not exactly integral in binary.
+  for (const auto &valid : document["valid"]) { REQUIRE(schema.validate(valid)); }
+
+  const std::pair<std::string_view, std::string_view> failures[] = { { "below minimum", "numeric bounds" },
+    { "above maximum", "numeric bounds" },
+    { "exclusive minimum", "numeric bounds" },
+    { "decimal multiple", "numeric bounds" },
+    { "integer multiple", "numeric bounds" },
+    { "too short", "string length" },
+    { "too long", "string length" },
+    { "not in enum", "enum" },
+    { "not in boolean enum", "enum" },
+    { "missing required", "properties" } };
+  REQUIRE(document["invalid"].size() == std::size(failures));
+  for (const auto &[name, reason] : failures) {
+    INFO(name);
+    json2cpp::schema::error_t error;
+    REQUIRE_FALSE(schema.validate(document["invalid"][name], error));
+    CHECK(error.reason == reason);
+    // A failing member is reported at its own node, a missing one at the object.
+    CHECK((error.node == 0) == (name == "missing required"));
+  }
+}
+
+TEST_CASE("Compiled schema enums compare numbers by value and objects by key")
+{
+  const auto &document = compiled_json::test_enum_members::get();
+  const auto &schema = compiled_json::test_enum_members_schema::schema();
+
+  // 1.0 matches 1, and object members match in any order.
+  for (const auto &valid : document["valid"]) { REQUIRE(schema.validate(valid)); }
+
+  for (const auto &invalid : document["invalid"]) {
+    json2cpp::schema::error_t error;
+    REQUIRE_FALSE(schema.validate(invalid, error));
+    CHECK(error.reason == "enum");
+  }
+}
+
+void stream_events(json2cpp::schema_stream_t &stream, const json2cpp::json &value)
+{
+  if (value.is_object()) {
+    stream.begin_object();
+    for (const auto &[key, child] : value.items()) {
+      stream.key(key.getString());
+      stream_events(stream, child);
+    }
+    stream.end_object();
+  } else if (value.is_array()) {
+    stream.begin_array();
+    for (const auto &child : value) { stream_events(stream, child); }
+    stream.end_array();
+  } else {
+    json2cpp::schema_stream_t::scalar_type scalar{ .type = json2cpp::schema::value_traits<json2cpp::json>::type(value) };
+    if (value.is_string()) { scalar.string = value.getString(); }
+    if (value.is_number()) { scalar.number = value.get<double>(); }
+    if (value.is_boolean()) { scalar.boolean = value.get<bool>(); }
+    stream.scalar(scalar);
+  }
+}
+
+TEST_CASE("Can validate a document streamed as events")
+{
+  const auto &document = compiled_json::test_json::get();
+  const auto &schema = compiled_json::test_schema::schema();
+
+  json2cpp::schema_stream_t valid_stream(schema);
+  stream_events(valid_stream, document);
+  REQUIRE(valid_stream.valid());
+
+  json2cpp::schema_stream_t invalid_stream(schema);
+  stream_events(invalid_stream, document["glossary"]);
+  REQUIRE_FALSE(invalid_stream.valid());
+  CHECK(invalid_stream.error().reason == "type");
+}
+
+TEST_CASE("Streamed numbers and booleans meet the same constraints as the document")
+{
+  const auto &document = compiled_json::test_constraints::get();
+  const auto &schema = compiled_json::test_constraints_schema::schema();
+
+  for (const auto &valid : document["valid"]) {
+    json2cpp::schema_stream_t stream(schema);
+    stream_events(stream, valid);
+    REQUIRE(stream.valid());
+  }
+  for (const auto &[name, invalid] : document["invalid"].items()) {
+    INFO(name.getString());
+    json2cpp::schema::error_t error;
+    REQUIRE_FALSE(schema.validate(invalid, error));
+    json2cpp::schema_stream_t stream(schema);
+    stream_events(stream, invalid);
+    REQUIRE_FALSE(stream.valid());
+    CHECK(stream.error().reason == error.reason);
+    CHECK(stream.error().node == error.node);
+  }
+}
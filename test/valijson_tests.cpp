@@ -10,6 +10,7 @@
 #pragma GCC diagnostic pop
 #endif
 #include <json2cpp/json2cpp_adapter.hpp>
+#include <memory>
 #include <valijson/schema.hpp>
 #include <valijson/schema_parser.hpp>
 #include <valijson/validator.hpp>
@@ -71,3 +72,50 @@ TEST_CASE("Can validate a document")
 
   REQUIRE(validator.validate(mySchema, myTargetAdapter, nullptr));
 }
+
+
+TEST_CASE("Adapter finds object members in place")
+{
+  using valijson::adapters::json2cppJsonAdapter;
+  using valijson::adapters::json2cppJsonObject;
+
+  const json2cppJsonObject schema(compiled_json::allof_integers_and_numbers_schema::get());
+  REQUIRE(schema.size() == 2);
+
+  const auto all_of = schema.find("allOf");
+  REQUIRE(all_of != schema.end());
+  CHECK(all_of->first == std::string_view{ "allOf" });
+  CHECK(all_of->second.isArray());
+  CHECK(schema.find("anyOf") == schema.end());
+
+  std::size_t members = 0;
+  for (auto itr = schema.begin(); itr != schema.end(); ++itr) {
+    const std::string key = itr->first;
+    CHECK(schema.find(key) == itr);
+    ++members;
+  }
+  CHECK(members == schema.size());
+}
+
+
+TEST_CASE("Frozen values refer to the document and reuse pooled storage")
+{
+  using valijson::adapters::FrozenValue;
+  using valijson::adapters::json2cppJsonAdapter;
+  using valijson::adapters::json2cppJsonFrozenValuePool;
+
+  const json2cppJsonAdapter adapter(compiled_json::array_integers_10_20_30_40::get());
+  const auto allocations = json2cppJsonFrozenValuePool::allocations();
+
+  std::unique_ptr<FrozenValue> frozen(adapter.freeze());
+  const std::unique_ptr<FrozenValue> clone(frozen->clone());
+  CHECK(frozen->equalTo(adapter, true));
+  CHECK(clone->equalTo(adapter, true));
+  CHECK_FALSE(clone->equalTo(json2cppJsonAdapter(compiled_json::array_doubles_10_20_30_40::get()), true));
+
+  const void *released = frozen.get();
+  frozen.reset();
+  frozen.reset(adapter.freeze());
+  CHECK(frozen.get() == released);
+  CHECK(json2cppJsonFrozenValuePool::allocations() - allocations == 3);
+}